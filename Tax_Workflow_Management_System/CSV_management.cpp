@@ -8,9 +8,19 @@
  * - CSV import/export
  * - Database operations
  * - Project filtering
+ * - Full-text project search
  */
 
 #include "CSV_management.h"
+#include "project_snapshot.h"
+#include "project_filter.h"
+#include "csv_reader.h"
+#include "statistics_aggregates.h"
+#include "dependency_graph.h"
+#include <chrono>
+#include <algorithm>
+#include <tuple>
+#include <filesystem>
 
 using namespace std;
 
@@ -90,7 +100,7 @@ namespace TaxReturnSystem {
 // PROJECT CLASS METHODS:
 
     // Definition of a method to assign a cell value to the appropriate member variable based on column number; takes an int, a string, and a ReportType as parameters; returns void
-    void Project::saveToAppropriateVariable(const int columnNum, const string &cellVal, const ReportType reportType) {
+    void Project::saveToAppropriateVariable(const int columnNum, string_view cellVal, const ReportType reportType) {
         const int MAX_COLUMNS = 11;
 
         if (columnNum >= MAX_COLUMNS) {
@@ -98,12 +108,8 @@ namespace TaxReturnSystem {
             return;
         }
 
-        string unquotedVal;
-        if (cellVal.length() >= 2 && cellVal.front() == '"' && cellVal.back() == '"') {
-            unquotedVal = cellVal.substr(1, cellVal.length() - 2);
-        } else {
-            unquotedVal = cellVal;
-        }
+        // Quoting has already been removed by the CSV reader
+        string_view unquotedVal = cellVal;
 
         // Handle each column based on its index
         if (columnNum == GROUP_COLUMN) {
@@ -118,17 +124,17 @@ namespace TaxReturnSystem {
         else if (columnNum == DUE_DATE_COLUMN) {
 
             if (reportType == ReportType::RegularDeadline) {
-                regularDeadline.setDate(unquotedVal);
+                regularDeadline.setDate(string(unquotedVal));
                 // If internal deadline isn't set, make it the same as regular deadline
                 if (internalDeadline.getDateStr().empty()) {
                     internalDeadline = regularDeadline;
                 }
             } else {
-                internalDeadline.setDate(unquotedVal);
+                internalDeadline.setDate(string(unquotedVal));
             }
         }
         else if (columnNum == BILLING_PARTNER_COLUMN) {
-            string unquotedTags = unquotedVal;
+            string unquotedTags(unquotedVal);
             billingPartner = ProjectManager::getBillingPartner(unquotedTags);
             extended = ProjectManager::isProjectExtended(unquotedTags);
         }
@@ -144,6 +150,7 @@ namespace TaxReturnSystem {
         }
         else if (columnNum == NEXT_TASK_COLUMN) {
             nextTask = unquotedVal;
+            taskStatus = parseTaskStatus(nextTask);
         }
         else if (columnNum == MEMO_COLUMN) {
             memo = unquotedVal;
@@ -152,9 +159,14 @@ namespace TaxReturnSystem {
 
     // Definition of a method to check if a project's dependency is met; takes two strings as parameters; returns bool
     bool Project::isDependencyMet(const string& dependencyId, const string& dependencyStatus) const {
+        return isDependencyMet(dependencyId, parseTaskStatus(dependencyStatus));
+    }
+
+    // Definition of a method to check if a project's dependency is met; takes a dependency id and its TaskStatus as parameters; returns bool
+    bool Project::isDependencyMet(const string& dependencyId, TaskStatus dependencyStatus) const {
         auto it = dependencies.find(dependencyId);
         if (it != dependencies.end()) {
-            return dependencyStatus == "Billed";
+            return dependencyStatus == TaskStatus::Billed;
         }
         return true;
     }
@@ -186,241 +198,531 @@ namespace TaxReturnSystem {
 
 // PROJECTS DATABASE CLASS METHODS:
 
-    // Definition of a constructor to open database and create tables; takes a string as parameter; returns nothing
-    ProjectsDatabase::ProjectsDatabase(const string& dbPath) : dbPath(dbPath), db(nullptr) {
-        if (!openDatabase()) {
-            throw runtime_error("Failed to open database");
+    namespace {
+
+        // Columns of the projects table in the order readProjectRow expects them
+        constexpr const char* PROJECT_COLUMNS = "id, project_group, client, project_type, billing_partner, partner, manager, "
+                                                "next_task, memo, regular_deadline, internal_deadline, extended, report_type";
+
+        // Read a text column, treating NULL as an empty string
+        string textColumn(sqlite3_stmt* stmt, int index) {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, index));
+            return string(text ? text : "");
         }
+
+        // Build a project from a row selected with PROJECT_COLUMNS
+        Project readProjectRow(sqlite3_stmt* stmt) {
+            Project project;
+            project.setId(textColumn(stmt, 0));
+            project.setGroup(textColumn(stmt, 1));
+            project.setClient(textColumn(stmt, 2));
+            project.setProjectType(textColumn(stmt, 3));
+            project.setBillingPartner(textColumn(stmt, 4));
+            project.setPartner(textColumn(stmt, 5));
+            project.setManager(textColumn(stmt, 6));
+            project.setNextTask(textColumn(stmt, 7));
+            project.setMemo(textColumn(stmt, 8));
+            project.setRegularDeadline(Date::fromValue(sqlite3_column_int(stmt, 9)));
+            project.setInternalDeadline(Date::fromValue(sqlite3_column_int(stmt, 10)));
+            project.setExtended(sqlite3_column_int(stmt, 11) != 0);
+            project.setReportType(static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
+            return project;
+        }
+
+        // SQL function date_value(text) used by migrations: the YYYYMMDD value Date parses from a stored deadline
+        void dateValueFunction(sqlite3_context* context, int, sqlite3_value** values) {
+            const unsigned char* text = sqlite3_value_text(values[0]);
+            int value = 0;
+            try {
+                value = text ? Date(reinterpret_cast<const char*>(text)).getValue() : 0;
+            } catch (const exception&) {
+                value = 0; // Unparseable deadlines were already treated as no deadline
+            }
+            sqlite3_result_int(context, value);
+        }
+
+        // Count the UTF-8 characters of a string; the trigram tokenizer works on characters, not bytes
+        size_t characterCount(const string& text) {
+            return count_if(text.begin(), text.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+        }
+
+        // Quote a search term as one FTS5 phrase, so its words, spaces and operators are matched literally
+        string ftsPhrase(const string& term) {
+            string phrase = "\"";
+            for (char c : term) {
+                phrase += c;
+                if (c == '"') {
+                    phrase += '"';
+                }
+            }
+            return phrase + "\"";
+        }
+
+        // Schema migrations; MIGRATIONS[i] upgrades a file at user_version i to i + 1 and runs in one transaction
+        const char* const MIGRATIONS[] = {
+            // 1: every table that existed before the schema was versioned: projects with deadlines stored as YYYY-MM-DD
+            // text, Lacerte feedback, the feedback export watermarks and project dependencies. Files created before
+            // versioning already have some or all of these, so each statement only creates what is missing.
+            R"(
+            CREATE TABLE IF NOT EXISTS projects (
+                id TEXT PRIMARY KEY ON CONFLICT REPLACE,
+                project_group TEXT,
+                client TEXT,
+                project_type TEXT,
+                billing_partner TEXT,
+                partner TEXT,
+                manager TEXT,
+                next_task TEXT,
+                memo TEXT,
+                regular_deadline TEXT,
+                internal_deadline TEXT,
+                extended INTEGER DEFAULT 0,
+                report_type INTEGER
+            );
+            CREATE TABLE IF NOT EXISTS lacerte_feedback (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                lacerte_name TEXT NOT NULL,
+                database_name TEXT NOT NULL,
+                is_match INTEGER NOT NULL,
+                confidence REAL,
+                feedback_time INTEGER DEFAULT (strftime('%s', 'now')),
+                user_id INTEGER
+            );
+            CREATE TABLE IF NOT EXISTS feedback_exports (
+                filename TEXT PRIMARY KEY,
+                last_feedback_id INTEGER NOT NULL
+            );
+            CREATE TABLE IF NOT EXISTS project_dependencies (
+                project_id TEXT NOT NULL,
+                depends_on_id TEXT NOT NULL,
+                dependency_type INTEGER NOT NULL DEFAULT 0,
+                PRIMARY KEY (project_id, depends_on_id)
+            );
+            CREATE INDEX IF NOT EXISTS idx_project_dependencies_depends_on ON project_dependencies(depends_on_id);
+            )",
+
+            // 2: deadlines as integer YYYYMMDD, matching Date::getValue, and indexes for the lookups by column
+            R"(
+            CREATE TABLE projects_v2 (
+                id TEXT PRIMARY KEY ON CONFLICT REPLACE,
+                project_group TEXT,
+                client TEXT,
+                project_type TEXT,
+                billing_partner TEXT,
+                partner TEXT,
+                manager TEXT,
+                next_task TEXT,
+                memo TEXT,
+                regular_deadline INTEGER NOT NULL DEFAULT 0,
+                internal_deadline INTEGER NOT NULL DEFAULT 0,
+                extended INTEGER DEFAULT 0,
+                report_type INTEGER
+            );
+            INSERT INTO projects_v2
+                SELECT id, project_group, client, project_type, billing_partner, partner, manager, next_task, memo,
+                       date_value(regular_deadline), date_value(internal_deadline), extended, report_type
+                FROM projects;
+            DROP TABLE projects;
+            ALTER TABLE projects_v2 RENAME TO projects;
+            CREATE INDEX idx_projects_regular_deadline ON projects(regular_deadline);
+            CREATE INDEX idx_projects_internal_deadline ON projects(internal_deadline);
+            CREATE INDEX idx_projects_manager ON projects(manager, regular_deadline);
+            CREATE INDEX idx_projects_partner ON projects(partner, regular_deadline);
+            CREATE INDEX idx_projects_billing_partner ON projects(billing_partner, regular_deadline);
+            CREATE INDEX idx_projects_client_type ON projects(client, project_type, id);
+            )",
+
+            // 3: trigram full-text index over the searchable columns, kept in step with projects by triggers.
+            // It reads column values from projects by rowid; nothing in this system runs VACUUM, which could renumber them.
+            R"(
+            CREATE VIRTUAL TABLE projects_search USING fts5(
+                id, project_group, client, project_type, billing_partner, partner, manager, next_task, memo,
+                content = 'projects', tokenize = 'trigram'
+            );
+            INSERT INTO projects_search(projects_search) VALUES ('rebuild');
+            INSERT INTO projects_search(projects_search, rank) VALUES ('rank', 'bm25(1, 1, 10, 2, 1, 1, 1, 1, 0.5)');
+            CREATE TRIGGER projects_search_insert AFTER INSERT ON projects BEGIN
+                INSERT INTO projects_search(rowid, id, project_group, client, project_type, billing_partner, partner, manager, next_task, memo)
+                VALUES (new.rowid, new.id, new.project_group, new.client, new.project_type, new.billing_partner, new.partner,
+                        new.manager, new.next_task, new.memo);
+            END;
+            CREATE TRIGGER projects_search_delete AFTER DELETE ON projects BEGIN
+                INSERT INTO projects_search(projects_search, rowid, id, project_group, client, project_type, billing_partner, partner,
+                                            manager, next_task, memo)
+                VALUES ('delete', old.rowid, old.id, old.project_group, old.client, old.project_type, old.billing_partner,
+                        old.partner, old.manager, old.next_task, old.memo);
+            END;
+            CREATE TRIGGER projects_search_update AFTER UPDATE ON projects BEGIN
+                INSERT INTO projects_search(projects_search, rowid, id, project_group, client, project_type, billing_partner, partner,
+                                            manager, next_task, memo)
+                VALUES ('delete', old.rowid, old.id, old.project_group, old.client, old.project_type, old.billing_partner,
+                        old.partner, old.manager, old.next_task, old.memo);
+                INSERT INTO projects_search(rowid, id, project_group, client, project_type, billing_partner, partner, manager, next_task, memo)
+                VALUES (new.rowid, new.id, new.project_group, new.client, new.project_type, new.billing_partner, new.partner,
+                        new.manager, new.next_task, new.memo);
+            END;
+            )"
+        };
+
+        constexpr int SCHEMA_VERSION = sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]); // Version of a fully migrated file
+
+    } // namespace
+
+    // Definition of a constructor to open database and create tables; takes a string as parameter; returns nothing
+    ProjectsDatabase::ProjectsDatabase(const string& dbPath) : dbPath(dbPath), pool(dbPath) {
         createTablesIfNotExist();
+
+        // Load the dependencies and count the existing projects once; every write after this applies a delta
+        dependencyGraph = make_unique<DependencyGraph>();
+        {
+            WriteLease writer = pool.writer();
+            loadDependencyGraph(*writer);
+        }
+        aggregates = make_unique<StatisticsAggregates>(*dependencyGraph);
+        aggregates->rebuild(*getSnapshot());
     }
 
-    // Definition of a method to execute a SQL query; takes a string as parameter; returns void
-    void ProjectsDatabase::executeQuery(const string& query) {
-        char* errMsg = nullptr;
-        int rc = sqlite3_exec(db, query.c_str(), nullptr, nullptr, &errMsg);
-        if (rc != SQLITE_OK) {
-            string error = "SQL error: ";
-            error += errMsg;
-            sqlite3_free(errMsg);
-            throw runtime_error(error);
+    // Definition of a method to build the dependency graph from the stored edges; takes the writer connection as parameter; returns void
+    void ProjectsDatabase::loadDependencyGraph(SqliteConnection& writer) {
+        shared_ptr<const ProjectSnapshot> current = getSnapshot();
+        vector<DependencyEdge> edges;
+
+        CachedStatement statement = writer.prepare("SELECT project_id, depends_on_id, dependency_type FROM project_dependencies;");
+        if (sqlite3_stmt* stmt = statement.get()) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                edges.push_back({reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                                 reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                 static_cast<DependencyType>(sqlite3_column_int(stmt, 2))});
+            }
+        }
+        statement.reset();
+
+        // Databases written before the table existed get their edges derived and stored once;
+        // if storing fails the derived edges are still used and storing is retried on the next start
+        if (edges.empty() && current->size() > 0) {
+            DependencyChanges derived;
+            derived.addedEdges = DependencyGraph::deriveEdges(*current);
+            if (!derived.addedEdges.empty() && beginTransaction(writer)) {
+                if (!writeDependencyChanges(writer, derived) || !commitTransaction(writer)) {
+                    rollbackTransaction(writer);
+                }
+            }
+            edges = move(derived.addedEdges);
         }
+
+        dependencyGraph->rebuild(*current, edges);
     }
 
-    // Definition of a destructor to close database connection; takes no parameters; returns nothing
-    ProjectsDatabase::~ProjectsDatabase() {
-        closeDatabase();
+    // Definition of a method to write a graph change to project_dependencies; takes the writer connection and DependencyChanges as parameters; returns bool
+    bool ProjectsDatabase::writeDependencyChanges(SqliteConnection& writer, const DependencyChanges& changes) {
+        if (changes.addedEdges.empty() && changes.removedEdges.empty()) {
+            return true;
+        }
+
+        CachedStatement insertStmt = writer.prepare("INSERT OR REPLACE INTO project_dependencies (project_id, depends_on_id, dependency_type) VALUES (?, ?, ?);");
+        CachedStatement deleteStmt = writer.prepare("DELETE FROM project_dependencies WHERE project_id = ? AND depends_on_id = ?;");
+        if (!insertStmt || !deleteStmt) {
+            cerr << "Failed to prepare dependency statements: " << writer.errorMessage() << endl;
+            return false;
+        }
+
+        // Bind one edge, run the statement and reset it for the next edge
+        auto writeEdge = [&writer](sqlite3_stmt* stmt, const DependencyEdge& edge, bool withType) {
+            sqlite3_bind_text(stmt, 1, edge.projectId.c_str(), static_cast<int>(edge.projectId.size()), SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, edge.dependsOnId.c_str(), static_cast<int>(edge.dependsOnId.size()), SQLITE_TRANSIENT);
+            if (withType) {
+                sqlite3_bind_int(stmt, 3, static_cast<int>(edge.type));
+            }
+            bool done = sqlite3_step(stmt) == SQLITE_DONE;
+            if (!done) {
+                cerr << "Failed to write project dependency: " << writer.errorMessage() << endl;
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            return done;
+        };
+
+        bool success = true;
+        for (size_t i = 0; success && i < changes.removedEdges.size(); i++) {
+            success = writeEdge(deleteStmt.get(), changes.removedEdges[i], false);
+        }
+        for (size_t i = 0; success && i < changes.addedEdges.size(); i++) {
+            success = writeEdge(insertStmt.get(), changes.addedEdges[i], true);
+        }
+        return success;
     }
 
-    // Definition of a method to open the database connection; takes no parameters; returns bool
-    bool ProjectsDatabase::openDatabase() {
-        int result = sqlite3_open(dbPath.c_str(), &db);
-        if (result != SQLITE_OK) {
-            cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
+    // Definition of a method to fill each project's dependencies from the graph; takes a vector of Projects as parameter; returns void
+    void ProjectsDatabase::attachDependencies(vector<Project>& projects) const {
+        unordered_map<string_view, Project*> byId;
+        byId.reserve(projects.size());
+        for (Project& project : projects) {
+            byId.emplace(project.getId(), &project);
+        }
+
+        dependencyGraph->forEachEdge([&](const string& projectId, const string& dependsOnId) {
+            auto project = byId.find(projectId);
+            if (project != byId.end()) {
+                project->second->addDependency(dependsOnId, DependencyType::BEFORE);
+            }
+        });
+    }
+
+    // Definition of a method to begin a transaction; takes the writer connection as parameter; returns bool
+    bool ProjectsDatabase::beginTransaction(SqliteConnection& writer) {
+        if (!writer.execute("BEGIN IMMEDIATE TRANSACTION;")) {
+            cerr << "Failed to begin transaction" << endl;
             return false;
         }
         return true;
     }
 
-    // Definition of a method to close the database connection; takes no parameters; returns void
-    void ProjectsDatabase::closeDatabase() {
-        if (db) {
-            sqlite3_close(db);
-            db = nullptr;
+    // Definition of a method to commit the current transaction; takes the writer connection as parameter; returns bool
+    bool ProjectsDatabase::commitTransaction(SqliteConnection& writer) {
+        if (!writer.execute("COMMIT;")) {
+            cerr << "Failed to commit transaction" << endl;
+            return false;
         }
+        return true;
     }
 
-    // Definition of a method to retrieve all projects from database; takes no parameters; returns vector of Projects
-    vector<Project> ProjectsDatabase::getAllProjects() const {
-        vector<Project> projects;
+    // Definition of a method to roll back the current transaction; takes the writer connection as parameter; returns bool
+    bool ProjectsDatabase::rollbackTransaction(SqliteConnection& writer) {
+        if (sqlite3_get_autocommit(writer.handle())) {
+            return false; // No transaction is open, e.g. a failed COMMIT already rolled it back
+        }
+        if (!writer.execute("ROLLBACK;")) {
+            cerr << "Failed to roll back transaction" << endl;
+            return false;
+        }
+        return true;
+    }
 
-        if (!db) {
-            cerr << "Database connection is not open!" << endl;
-            return projects;
+    // Definition of a method to check that the database accepts writes; takes no parameters; returns bool
+    bool ProjectsDatabase::testDatabaseWrite() {
+        WriteLease writer = pool.writer();
+        if (!beginTransaction(*writer)) {
+            return false;
+        }
+        bool writable = writer->execute("CREATE TEMP TABLE IF NOT EXISTS write_test (id INTEGER); DROP TABLE write_test;");
+        if (!writable) {
+            cerr << "Database write test failed" << endl;
         }
+        rollbackTransaction(*writer);
+        return writable;
+    }
+
+    // Definition of a destructor; the pool closes the connections; takes no parameters; returns nothing
+    ProjectsDatabase::~ProjectsDatabase() = default;
 
-        string query = "SELECT id, project_group, client, project_type, billing_partner, partner, manager, "
-                       "next_task, memo, regular_deadline, internal_deadline, extended, report_type "
-                       "FROM projects;";
+    // Definition of a method to load the projects table into a new snapshot; takes a version number as parameter; returns shared pointer to ProjectSnapshot
+    shared_ptr<const ProjectSnapshot> ProjectsDatabase::buildSnapshot(uint64_t version) const {
+        auto newSnapshot = make_shared<ProjectSnapshot>(version);
 
-        sqlite3_stmt* stmt;
+        string query = string("SELECT ") + PROJECT_COLUMNS + " FROM projects;";
 
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
-            return projects;
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(query);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            return newSnapshot;
         }
 
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Project project;
+            newSnapshot->appendRow(textColumn(stmt, 0), textColumn(stmt, 1), textColumn(stmt, 2), textColumn(stmt, 3),
+                                   textColumn(stmt, 4), textColumn(stmt, 5), textColumn(stmt, 6), textColumn(stmt, 7),
+                                   textColumn(stmt, 8), Date::fromValue(sqlite3_column_int(stmt, 9)),
+                                   Date::fromValue(sqlite3_column_int(stmt, 10)),
+                                   sqlite3_column_int(stmt, 11) != 0,
+                                   static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
+        }
 
-            // Get all the text fields safely
-            const char* id = (const char*)sqlite3_column_text(stmt, 0);
-            const char* group = (const char*)sqlite3_column_text(stmt, 1);
-            const char* client = (const char*)sqlite3_column_text(stmt, 2);
-            const char* projectType = (const char*)sqlite3_column_text(stmt, 3);
-            const char* billingPartner = (const char*)sqlite3_column_text(stmt, 4);
-            const char* partner = (const char*)sqlite3_column_text(stmt, 5);
-            const char* manager = (const char*)sqlite3_column_text(stmt, 6);
-            const char* nextTask = (const char*)sqlite3_column_text(stmt, 7);
-            const char* memo = (const char*)sqlite3_column_text(stmt, 8);
-            const char* regularDeadline = (const char*)sqlite3_column_text(stmt, 9);
-            const char* internalDeadline = (const char*)sqlite3_column_text(stmt, 10);
-
-            project.setId(id ? id : "");
-            project.setGroup(group ? group : "");
-            project.setClient(client ? client : "");
-            project.setProjectType(projectType ? projectType : "");
-            project.setBillingPartner(billingPartner ? billingPartner : "");
-            project.setPartner(partner ? partner : "");
-            project.setManager(manager ? manager : "");
-            project.setNextTask(nextTask ? nextTask : "");
-            project.setMemo(memo ? memo : "");
-
-            if (regularDeadline) {
-                project.setRegularDeadline(Date(regularDeadline));
-            }
-            if (internalDeadline) {
-                project.setInternalDeadline(Date(internalDeadline));
-            }
+        newSnapshot->buildIndexes();
+        return newSnapshot;
+    }
 
-            project.setExtended(sqlite3_column_int(stmt, 11) != 0);
-            project.setReportType(static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
+    // Definition of a method to get the current snapshot of the projects table, rebuilding it only if the data changed; takes no parameters; returns shared pointer to ProjectSnapshot
+    shared_ptr<const ProjectSnapshot> ProjectsDatabase::getSnapshot() const {
+        lock_guard<mutex> lock(snapshotMutex);
 
-            projects.push_back(project);
+        if (snapshotStale || !snapshot) {
+            snapshot = buildSnapshot(++snapshotVersion);
+            snapshotStale = false;
         }
 
-        sqlite3_finalize(stmt);
+        return snapshot;
+    }
+
+    // Definition of a method to mark the snapshot stale after the projects table changed; takes no parameters; returns void
+    void ProjectsDatabase::invalidateSnapshot() {
+        lock_guard<mutex> lock(snapshotMutex);
+        snapshotStale = true;
+    }
+
+    // Definition of a method to retrieve all projects; takes no parameters; returns vector of Projects
+    vector<Project> ProjectsDatabase::getAllProjects() const {
+        vector<Project> projects = getSnapshot()->toProjects();
+        attachDependencies(projects);
         return projects;
     }
 
     // Definition of a method to search projects in database; takes a string as parameter; returns vector of Projects
     vector<Project> ProjectsDatabase::searchProjects(const string& searchTerm) const {
+        return findMatches(searchTerm, -1, 0);
+    }
+
+    // Definition of a method to get one page of search results; takes the search term, page size and cursor as parameters; returns ProjectSearchPage
+    ProjectSearchPage ProjectsDatabase::searchProjects(const string& searchTerm, size_t limit, const string& cursor) const {
+        limit = min(limit > 0 ? limit : PROJECT_SEARCH_DEFAULT_LIMIT, PROJECT_SEARCH_MAX_LIMIT);
+
+        // The cursor is the number of matches on the previous pages
+        int64_t offset = 0;
+        if (!cursor.empty()) {
+            try {
+                offset = stoll(cursor);
+            } catch (const exception&) {
+                offset = -1;
+            }
+            if (offset < 0) {
+                cerr << "Ignoring invalid search cursor: " << cursor << endl;
+                offset = 0;
+            }
+        }
+
+        // Fetch one extra row to learn whether another page follows
+        ProjectSearchPage page;
+        page.projects = findMatches(searchTerm, static_cast<int64_t>(limit) + 1, offset);
+        if (page.projects.size() > limit) {
+            page.projects.pop_back();
+            page.nextCursor = to_string(offset + static_cast<int64_t>(limit));
+        }
+        return page;
+    }
+
+    // Definition of a method to run a search; takes the search term, row limit (-1 for all) and offset as parameters; returns vector of Projects
+    vector<Project> ProjectsDatabase::findMatches(const string& searchTerm, int64_t limit, int64_t offset) const {
         vector<Project> results;
-        string query = "SELECT * FROM projects WHERE "
-                       "id LIKE ? OR "
-                       "project_group LIKE ? OR "
-                       "client LIKE ? OR "
-                       "project_type LIKE ? OR "
-                       "billing_partner LIKE ? OR "
-                       "partner LIKE ? OR "
-                       "manager LIKE ? OR "
-                       "next_task LIKE ? OR "
-                       "memo LIKE ?";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+
+        // The trigram index answers any term of three or more characters as a substring match over the
+        // searchable columns, ranked by bm25 with the client weighted highest. Shorter terms have no
+        // trigram to look up and scan the table instead.
+        bool indexed = characterCount(searchTerm) >= PROJECT_SEARCH_MIN_INDEXED_LENGTH;
+        string query;
+        if (indexed) {
+            query = string("WITH hits AS (SELECT rowid AS hit, rank AS score FROM projects_search "
+                           "WHERE projects_search MATCH ? ORDER BY rank, rowid LIMIT ? OFFSET ?) "
+                           "SELECT ") + PROJECT_COLUMNS + " FROM hits JOIN projects ON projects.rowid = hits.hit "
+                    "ORDER BY hits.score, hits.hit;";
+        } else {
+            query = string("SELECT ") + PROJECT_COLUMNS + " FROM projects WHERE "
+                    "id LIKE ? OR "
+                    "project_group LIKE ? OR "
+                    "client LIKE ? OR "
+                    "project_type LIKE ? OR "
+                    "billing_partner LIKE ? OR "
+                    "partner LIKE ? OR "
+                    "manager LIKE ? OR "
+                    "next_task LIKE ? OR "
+                    "memo LIKE ? "
+                    "ORDER BY client, id LIMIT ? OFFSET ?;";
+        }
+
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(query);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return results;
         }
 
-        string likePattern = "%" + searchTerm + "%";
-        for (int i = 1; i <= 9; ++i) {
-            sqlite3_bind_text(stmt, i, likePattern.c_str(), -1, SQLITE_STATIC);
+        int index = 1;
+        string pattern;
+        if (indexed) {
+            pattern = ftsPhrase(searchTerm);
+            sqlite3_bind_text(stmt, index++, pattern.c_str(), -1, SQLITE_STATIC);
+        } else {
+            pattern = "%" + searchTerm + "%";
+            for (; index <= 9; ++index) {
+                sqlite3_bind_text(stmt, index, pattern.c_str(), -1, SQLITE_STATIC);
+            }
         }
+        sqlite3_bind_int64(stmt, index++, limit);
+        sqlite3_bind_int64(stmt, index, offset);
 
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Project project;
-            project.setId(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-            project.setGroup(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            project.setClient(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            project.setProjectType(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-            project.setBillingPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)));
-            project.setPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-            project.setManager(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6)));
-            project.setNextTask(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
-            project.setMemo(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8)));
-            project.setRegularDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9))));
-            project.setInternalDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10))));
-            project.setExtended(sqlite3_column_int(stmt, 11) != 0);
-            project.setReportType(static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
-
-            results.push_back(project);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            results.push_back(readProjectRow(stmt));
+        }
+        if (rc != SQLITE_DONE) {
+            cerr << "Failed to search projects: " << reader->errorMessage() << endl;
         }
 
-        sqlite3_finalize(stmt);
         return results;
     }
 
-    // Definition of a method to create database tables if they don't exist; takes no parameters; returns void
+    // Definition of a method to create database tables and migrate older files to the current schema; takes no parameters; returns void
     void ProjectsDatabase::createTablesIfNotExist() {
-        const char* sql = R"(
-        CREATE TABLE IF NOT EXISTS projects (
-            id TEXT PRIMARY KEY ON CONFLICT REPLACE,
-            project_group TEXT,
-            client TEXT,
-            project_type TEXT,
-            billing_partner TEXT,
-            partner TEXT,
-            manager TEXT,
-            next_task TEXT,
-            memo TEXT,
-            regular_deadline TEXT,
-            internal_deadline TEXT,
-            extended INTEGER DEFAULT 0,
-            report_type INTEGER
-        );
-    )";
-
-        char* errMsg = nullptr;
-        int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
-
-        if (rc != SQLITE_OK) {
-            cerr << "SQL error: " << errMsg << endl;
-            string errorMsg = errMsg ? errMsg : "Unknown error";
-            sqlite3_free(errMsg);
-            throw runtime_error("Failed to create projects table: " + errorMsg);
-        }
-    }
-
-    // Definition of a method to add a project to database; takes a Project as parameter; returns bool
-    bool ProjectsDatabase::addProjectToDatabase(const Project& project) {
-
-        string id = project.generateId();
+        WriteLease writer = pool.writer();
 
-        // Begin transaction
-        executeQuery("BEGIN TRANSACTION;");
+        // Rows replaced through the ON CONFLICT REPLACE primary key only fire the delete trigger that keeps
+        // the search index in step when recursive triggers are on
+        if (!writer->execute("PRAGMA recursive_triggers = ON;")) {
+            throw runtime_error("Failed to enable recursive triggers for " + dbPath);
+        }
+        sqlite3_create_function(writer->handle(), "date_value", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                                nullptr, dateValueFunction, nullptr, nullptr);
 
-        string checkQuery = "SELECT * FROM projects WHERE id = ?;";
-        sqlite3_stmt* checkStmt;
-        bool projectExists = false;
+        int version = 0;
+        {
+            CachedStatement statement = writer->prepare("PRAGMA user_version;");
+            if (statement && sqlite3_step(statement.get()) == SQLITE_ROW) {
+                version = sqlite3_column_int(statement.get(), 0);
+            }
+        }
 
-        if (sqlite3_prepare_v2(db, checkQuery.c_str(), -1, &checkStmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(checkStmt, 1, id.c_str(), -1, SQLITE_STATIC);
+        if (version > SCHEMA_VERSION) {
+            throw runtime_error("Database schema version " + to_string(version) + " is newer than this build supports");
+        }
 
-            if (sqlite3_step(checkStmt) == SQLITE_ROW) {
-                projectExists = true;
-            } else {
+        // Each step commits on its own, so an interrupted upgrade resumes from the last finished version
+        bool migrated = version < SCHEMA_VERSION;
+        for (; version < SCHEMA_VERSION; version++) {
+            string setVersion = "PRAGMA user_version = " + to_string(version + 1) + ";";
+            if (!beginTransaction(*writer) || !writer->execute(MIGRATIONS[version]) ||
+                !writer->execute(setVersion.c_str()) || !commitTransaction(*writer)) {
+                rollbackTransaction(*writer);
+                throw runtime_error("Failed to migrate projects database to schema version " + to_string(version + 1));
             }
-            sqlite3_finalize(checkStmt);
+            cout << "Projects database migrated to schema version " << version + 1 << endl;
         }
 
-        // First delete the existing record if it exists
-        if (projectExists) {
-            string deleteQuery = "DELETE FROM projects WHERE id = ?;";
-            sqlite3_stmt* deleteStmt;
-            if (sqlite3_prepare_v2(db, deleteQuery.c_str(), -1, &deleteStmt, nullptr) == SQLITE_OK) {
-                sqlite3_bind_text(deleteStmt, 1, id.c_str(), -1, SQLITE_STATIC);
-                if (sqlite3_step(deleteStmt) != SQLITE_DONE) {
-                    cerr << "Failed to delete existing record: " << sqlite3_errmsg(db) << endl;
-                }
-                sqlite3_finalize(deleteStmt);
-            }
+        if (migrated) {
+            writer->execute("ANALYZE;");
         }
+    }
 
-        // Now insert the new/updated record
-        string query = "INSERT INTO projects (id, project_group, client, project_type, billing_partner, "
-                       "partner, manager, next_task, memo, regular_deadline, internal_deadline, "
-                       "extended, report_type) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    // Definition of a method to add a project to database; takes a Project as parameter; returns bool
+    bool ProjectsDatabase::addProjectToDatabase(const Project& project) {
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
-            executeQuery("ROLLBACK;");
+        string id = project.generateId();
+
+        WriteLease writer = pool.writer();
+        if (!beginTransaction(*writer)) {
             return false;
         }
 
-        auto bindLongText = [this, &stmt](int index, const string& text) {
+        // The primary key replaces an existing row with the same id
+        CachedStatement statement = writer->prepare("INSERT INTO projects (id, project_group, client, project_type, billing_partner, "
+                                                    "partner, manager, next_task, memo, regular_deadline, internal_deadline, "
+                                                    "extended, report_type) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            rollbackTransaction(*writer);
+            return false;
+        }
+
+        auto bindLongText = [&writer, stmt](int index, const string& text) {
             if (sqlite3_bind_text(stmt, index, text.c_str(), -1, SQLITE_TRANSIENT) != SQLITE_OK) {
-                cerr << "Error binding text for column " << index << ": " << sqlite3_errmsg(db) << endl;
+                cerr << "Error binding text for column " << index << ": " << writer->errorMessage() << endl;
                 return false;
             }
             return true;
@@ -437,133 +739,269 @@ namespace TaxReturnSystem {
         bindingSuccess &= bindLongText(7, project.getManager());
         bindingSuccess &= bindLongText(8, project.getNextTask());
         bindingSuccess &= bindLongText(9, project.getMemo());
-        bindingSuccess &= bindLongText(10, project.getRegularDeadline().getDateStr());
-        bindingSuccess &= bindLongText(11, project.getInternalDeadline().getDateStr());
 
         if (!bindingSuccess) {
             cerr << "Failed to bind one or more text fields\n";
-            sqlite3_finalize(stmt);
-            executeQuery("ROLLBACK;");
+            rollbackTransaction(*writer);
             return false;
         }
 
-        if (sqlite3_bind_int(stmt, 12, project.isExtended() ? 1 : 0) != SQLITE_OK ||
+        if (sqlite3_bind_int(stmt, 10, project.getRegularDeadline().getValue()) != SQLITE_OK ||
+            sqlite3_bind_int(stmt, 11, project.getInternalDeadline().getValue()) != SQLITE_OK ||
+            sqlite3_bind_int(stmt, 12, project.isExtended() ? 1 : 0) != SQLITE_OK ||
             sqlite3_bind_int(stmt, 13, static_cast<int>(project.getReportType())) != SQLITE_OK) {
-            cerr << "Error binding integer fields: " << sqlite3_errmsg(db) << endl;
-            sqlite3_finalize(stmt);
-            executeQuery("ROLLBACK;");
+            cerr << "Error binding integer fields: " << writer->errorMessage() << endl;
+            rollbackTransaction(*writer);
             return false;
         }
 
         int result = sqlite3_step(stmt);
         if (result != SQLITE_DONE) {
-            cerr << "Failed to add/update project in database: " << sqlite3_errmsg(db) << endl;
+            cerr << "Failed to add/update project in database: " << writer->errorMessage() << endl;
             cerr << "SQLite result code: " << result << endl;
-            sqlite3_finalize(stmt);
-            executeQuery("ROLLBACK;");
+            rollbackTransaction(*writer);
+            return false;
+        }
+        statement.reset();
+
+        // Link the project into the dependency graph and store its edges in the same transaction
+        DependencyChanges dependencyChanges;
+        dependencyGraph->upsertProject(id, project.getClient(), project.getProjectType(), project.getTaskStatus(),
+                                       project.getRegularDeadline(), dependencyChanges);
+        if (!writeDependencyChanges(*writer, dependencyChanges) || !commitTransaction(*writer)) {
+            rollbackTransaction(*writer);
+            loadDependencyGraph(*writer);
             return false;
         }
 
-        sqlite3_finalize(stmt);
-        executeQuery("COMMIT;");
+        invalidateSnapshot();
+        aggregates->upsertProject(id, project, dependencyChanges);
 
         return true;
     }
 
     // Definition of a method to update a project in database; takes a Project as parameter; returns bool
     bool ProjectsDatabase::updateProjectInDatabase(const Project& project) {
-        string query = "UPDATE projects SET billing_partner = ?, partner = ?, manager = ?, next_task = ?, memo = ?, regular_deadline = ?, internal_deadline = ?, extended = ?, report_type = ? WHERE id = ?;";
-        sqlite3_stmt* stmt;
-
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("UPDATE projects SET billing_partner = ?, partner = ?, manager = ?, next_task = ?, memo = ?, "
+                                                    "regular_deadline = ?, internal_deadline = ?, extended = ?, report_type = ? WHERE id = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
-        sqlite3_bind_text(stmt, 1, project.getBillingPartner().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, project.getPartner().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, project.getManager().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, project.getNextTask().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 5, project.getMemo().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 6, project.getRegularDeadline().getDateStr().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 7, project.getInternalDeadline().getDateStr().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, project.getBillingPartner().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, project.getPartner().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, project.getManager().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, project.getNextTask().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 5, project.getMemo().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 6, project.getRegularDeadline().getValue());
+        sqlite3_bind_int(stmt, 7, project.getInternalDeadline().getValue());
         sqlite3_bind_int(stmt, 8, project.isExtended() ? 1 : 0);
         sqlite3_bind_int(stmt, 9, static_cast<int>(project.getReportType()));
-        sqlite3_bind_text(stmt, 10, project.getId().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 10, project.getId().c_str(), -1, SQLITE_TRANSIENT);
 
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
 
         if (result != SQLITE_DONE) {
-            cerr << "Failed to update project: " << sqlite3_errmsg(db) << endl;
+            cerr << "Failed to update project: " << writer->errorMessage() << endl;
             return false;
         }
 
+        // Updates never change the client or project type, so only the status can move dependents
+        DependencyChanges dependencyChanges;
+        dependencyGraph->updateProject(project.getId(), project.getTaskStatus(), project.getRegularDeadline(), dependencyChanges);
+
+        invalidateSnapshot();
+        aggregates->updateProject(project, dependencyChanges);
         return true;
     }
 
     // Definition of a method to delete a project from database by ID; takes a string as parameter; returns bool
     bool ProjectsDatabase::deleteProjectFromDatabase(const string& id) {
-        string query = "DELETE FROM projects WHERE id = ?;";
-        sqlite3_stmt* stmt;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("DELETE FROM projects WHERE id = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            return false;
+        }
 
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        if (!beginTransaction(*writer)) {
             return false;
         }
 
-        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
 
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
 
         if (result != SQLITE_DONE) {
-            cerr << "Failed to delete project: " << sqlite3_errmsg(db) << endl;
+            cerr << "Failed to delete project: " << writer->errorMessage() << endl;
+            rollbackTransaction(*writer);
+            return false;
+        }
+
+        // Drop the project's edges with it
+        DependencyChanges dependencyChanges;
+        dependencyGraph->removeProject(id, dependencyChanges);
+        if (!writeDependencyChanges(*writer, dependencyChanges) || !commitTransaction(*writer)) {
+            rollbackTransaction(*writer);
+            loadDependencyGraph(*writer);
             return false;
         }
 
+        invalidateSnapshot();
+        aggregates->removeProject(id, dependencyChanges);
+        return true;
+    }
+
+    // Definition of a method to apply an import diff in one transaction, reusing one prepared statement per operation; takes an ImportDiff as parameter; returns bool
+    bool ProjectsDatabase::applyImportDiff(const ImportDiff& diff) {
+        if (diff.additions.empty() && diff.updates.empty() && diff.removals.empty()) {
+            return true;
+        }
+
+        WriteLease writer = pool.writer();
+        CachedStatement insertStmt = writer->prepare("INSERT OR REPLACE INTO projects (id, project_group, client, project_type, billing_partner, "
+                                                     "partner, manager, next_task, memo, regular_deadline, internal_deadline, "
+                                                     "extended, report_type) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+        CachedStatement updateStmt = writer->prepare("UPDATE projects SET project_group = ?, billing_partner = ?, partner = ?, manager = ?, "
+                                                     "next_task = ?, memo = ?, regular_deadline = ?, internal_deadline = ?, extended = ?, "
+                                                     "report_type = ? WHERE id = ?;");
+        CachedStatement deleteStmt = writer->prepare("DELETE FROM projects WHERE id = ?;");
+
+        if (!insertStmt || !updateStmt || !deleteStmt) {
+            cerr << "Failed to prepare import statements: " << writer->errorMessage() << endl;
+            return false;
+        }
+
+        if (!beginTransaction(*writer)) {
+            return false;
+        }
+
+        // Run a bound statement and reset it for the next row
+        auto stepAndReset = [&writer](CachedStatement& statement) {
+            bool done = sqlite3_step(statement.get()) == SQLITE_DONE;
+            if (!done) {
+                cerr << "Failed to apply import row: " << writer->errorMessage() << endl;
+            }
+            statement.reset();
+            return done;
+        };
+
+        auto bindText = [](CachedStatement& statement, int index, const string& text) {
+            sqlite3_bind_text(statement.get(), index, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+        };
+
+        bool success = true;
+
+        for (const string& id : diff.removals) {
+            bindText(deleteStmt, 1, id);
+            if (!stepAndReset(deleteStmt)) {
+                success = false;
+                break;
+            }
+        }
+
+        for (size_t i = 0; success && i < diff.updates.size(); i++) {
+            const Project& project = diff.updates[i];
+            bindText(updateStmt, 1, project.getGroup());
+            bindText(updateStmt, 2, project.getBillingPartner());
+            bindText(updateStmt, 3, project.getPartner());
+            bindText(updateStmt, 4, project.getManager());
+            bindText(updateStmt, 5, project.getNextTask());
+            bindText(updateStmt, 6, project.getMemo());
+            sqlite3_bind_int(updateStmt.get(), 7, project.getRegularDeadline().getValue());
+            sqlite3_bind_int(updateStmt.get(), 8, project.getInternalDeadline().getValue());
+            sqlite3_bind_int(updateStmt.get(), 9, project.isExtended() ? 1 : 0);
+            sqlite3_bind_int(updateStmt.get(), 10, static_cast<int>(project.getReportType()));
+            bindText(updateStmt, 11, project.getId());
+            success = stepAndReset(updateStmt);
+        }
+
+        for (size_t i = 0; success && i < diff.additions.size(); i++) {
+            const Project& project = diff.additions[i];
+            bindText(insertStmt, 1, project.generateId());
+            bindText(insertStmt, 2, project.getGroup());
+            bindText(insertStmt, 3, project.getClient());
+            bindText(insertStmt, 4, project.getProjectType());
+            bindText(insertStmt, 5, project.getBillingPartner());
+            bindText(insertStmt, 6, project.getPartner());
+            bindText(insertStmt, 7, project.getManager());
+            bindText(insertStmt, 8, project.getNextTask());
+            bindText(insertStmt, 9, project.getMemo());
+            sqlite3_bind_int(insertStmt.get(), 10, project.getRegularDeadline().getValue());
+            sqlite3_bind_int(insertStmt.get(), 11, project.getInternalDeadline().getValue());
+            sqlite3_bind_int(insertStmt.get(), 12, project.isExtended() ? 1 : 0);
+            sqlite3_bind_int(insertStmt.get(), 13, static_cast<int>(project.getReportType()));
+            success = stepAndReset(insertStmt);
+        }
+
+        if (!success) {
+            rollbackTransaction(*writer);
+            return false;
+        }
+
+        // Apply the same removals, updates and additions to the dependency graph and store its edges with the rows
+        DependencyChanges dependencyChanges;
+        for (const string& id : diff.removals) {
+            dependencyGraph->removeProject(id, dependencyChanges);
+        }
+        for (const Project& project : diff.updates) {
+            dependencyGraph->updateProject(project.getId(), project.getTaskStatus(), project.getRegularDeadline(), dependencyChanges);
+        }
+        for (const Project& project : diff.additions) {
+            dependencyGraph->upsertProject(project.generateId(), project.getClient(), project.getProjectType(),
+                                           project.getTaskStatus(), project.getRegularDeadline(), dependencyChanges);
+        }
+
+        if (!writeDependencyChanges(*writer, dependencyChanges) || !commitTransaction(*writer)) {
+            rollbackTransaction(*writer);
+            loadDependencyGraph(*writer);
+            return false;
+        }
+
+        // Refresh the planner statistics after a bulk load so the indexes keep being chosen
+        size_t changedRows = diff.additions.size() + diff.updates.size() + diff.removals.size();
+        if (changedRows >= PROJECTS_ANALYZE_MIN_ROWS) {
+            writer->execute("ANALYZE;");
+        }
+
+        invalidateSnapshot();
+        aggregates->applyImportDiff(diff, dependencyChanges);
         return true;
     }
 
     // Definition of a method to get a project from database by ID; takes a string and Project reference as parameters; returns bool
     bool ProjectsDatabase::getProjectFromDatabase(const string& id, Project& project) {
-        string query = "SELECT * FROM projects WHERE id = ?;";
-        sqlite3_stmt* stmt;
-
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(string("SELECT ") + PROJECT_COLUMNS + " FROM projects WHERE id = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
         sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
 
         if (sqlite3_step(stmt) == SQLITE_ROW) {
-            project.setId(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-            project.setGroup(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            project.setClient(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            project.setProjectType(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-            project.setBillingPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)));
-            project.setPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-            project.setManager(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6)));
-            project.setNextTask(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
-            project.setMemo(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8)));
-            project.setRegularDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9))));
-            project.setInternalDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10))));
-            project.setExtended(sqlite3_column_int(stmt, 11) != 0);
-            project.setReportType(static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
+            project = readProjectRow(stmt);
+
+            project.clearDependencies();
+            for (const string& dependencyId : dependencyGraph->getDependencies(id)) {
+                project.addDependency(dependencyId, DependencyType::BEFORE);
+            }
 
-            sqlite3_finalize(stmt);
             return true;
         }
 
-        sqlite3_finalize(stmt);
         return false;
     }
 
     // Definition of a method to get projects within a date range; takes two Dates and a ReportType as parameters; returns vector of Projects
     vector<Project> ProjectsDatabase::getProjectsByDateRange(const Date& startDate, const Date& endDate, ReportType reportType) const {
         vector<Project> results;
-        string query = "SELECT * FROM projects WHERE ";
+        string query = string("SELECT ") + PROJECT_COLUMNS + " FROM projects WHERE ";
 
         // Determine which deadline to use based on report type
         if (reportType == ReportType::RegularDeadline) {
@@ -572,40 +1010,59 @@ namespace TaxReturnSystem {
             query += "internal_deadline BETWEEN ? AND ?";
         }
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(query);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return results;
         }
 
-        // Bind date parameters
-        sqlite3_bind_text(stmt, 1, startDate.getDateStr().c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, endDate.getDateStr().c_str(), -1, SQLITE_STATIC);
+        // Bind date parameters as the YYYYMMDD integers the deadline columns hold
+        sqlite3_bind_int(stmt, 1, startDate.getValue());
+        sqlite3_bind_int(stmt, 2, endDate.getValue());
 
         // Retrieve and process each matching project
         while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Project project;
-            project.setId(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-            project.setGroup(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-            project.setClient(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            project.setProjectType(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3)));
-            project.setBillingPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4)));
-            project.setPartner(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5)));
-            project.setManager(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6)));
-            project.setNextTask(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7)));
-            project.setMemo(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8)));
-            project.setRegularDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 9))));
-            project.setInternalDeadline(Date(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 10))));
-            project.setExtended(sqlite3_column_int(stmt, 11) != 0);
-            project.setReportType(static_cast<ReportType>(sqlite3_column_int(stmt, 12)));
+            results.push_back(readProjectRow(stmt));
+        }
+
+        return results;
+    }
 
-            results.push_back(project);
+    // Definition of a method to get the projects whose column equals a value; takes a column name and a value as parameters; returns vector of Projects
+    vector<Project> ProjectsDatabase::getProjectsByColumn(const char* column, const string& value) const {
+        vector<Project> results;
+        string query = string("SELECT ") + PROJECT_COLUMNS + " FROM projects WHERE " + column + " = ? ORDER BY regular_deadline;";
+
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(query);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            return results;
         }
 
-        sqlite3_finalize(stmt);
+        sqlite3_bind_text(stmt, 1, value.c_str(), static_cast<int>(value.size()), SQLITE_TRANSIENT);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            results.push_back(readProjectRow(stmt));
+        }
         return results;
     }
 
+    // Definition of a method to get a manager's projects; takes a manager name as parameter; returns vector of Projects
+    vector<Project> ProjectsDatabase::getProjectsByManager(const string& manager) const {
+        return getProjectsByColumn("manager", manager);
+    }
+
+    // Definition of a method to get a partner's projects; takes a partner name as parameter; returns vector of Projects
+    vector<Project> ProjectsDatabase::getProjectsByPartner(const string& partner) const {
+        return getProjectsByColumn("partner", partner);
+    }
+
+    // Definition of a method to get a billing partner's projects; takes a billing partner name as parameter; returns vector of Projects
+    vector<Project> ProjectsDatabase::getProjectsByBillingPartner(const string& billingPartner) const {
+        return getProjectsByColumn("billing_partner", billingPartner);
+    }
+
     // Definition of a method to list all projects (for debugging purposes); takes no parameters; returns void
     void ProjectsDatabase::listAllProjects() const {
         // Get all projects from database
@@ -632,30 +1089,38 @@ namespace TaxReturnSystem {
                                        bool isMatch,
                                        double confidence,
                                        int userId) {
-        try {
-            string query = "INSERT INTO lacerte_feedback "
-                          "(lacerte_name, database_name, is_match, confidence, user_id) VALUES "
-                          "('" + lacerteName + "', '" + databaseName + "', " +
-                          (isMatch ? "1" : "0") + ", " +
-                          to_string(confidence) + ", " +
-                          to_string(userId) + ");";
-
-            executeQuery(query);
-            return true;
-        } catch (const exception& e) {
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("INSERT INTO lacerte_feedback "
+                                                    "(lacerte_name, database_name, is_match, confidence, user_id) VALUES (?, ?, ?, ?, ?);");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            cerr << "Failed to prepare feedback insert: " << writer->errorMessage() << endl;
             return false;
         }
+
+        sqlite3_bind_text(stmt, 1, lacerteName.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, databaseName.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(stmt, 3, isMatch ? 1 : 0);
+        sqlite3_bind_double(stmt, 4, confidence);
+        sqlite3_bind_int(stmt, 5, userId);
+
+        bool stored = sqlite3_step(stmt) == SQLITE_DONE;
+        if (!stored) {
+            cerr << "Failed to store feedback: " << writer->errorMessage() << endl;
+        }
+        return stored;
     }
 
     // Definition of a method to get feedback history from database; takes limit as parameter; returns vector of FeedbackEntry
     vector<FeedbackEntry> ProjectsDatabase::getFeedbackHistory(int limit) {
         vector<FeedbackEntry> history;
-        string query = "SELECT lacerte_name, database_name, is_match, confidence, "
-                      "feedback_time, user_id FROM lacerte_feedback "
-                      "ORDER BY feedback_time DESC LIMIT " + to_string(limit);
 
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare("SELECT lacerte_name, database_name, is_match, confidence, "
+                                                    "feedback_time, user_id FROM lacerte_feedback "
+                                                    "ORDER BY feedback_time DESC LIMIT ?;");
+        if (sqlite3_stmt* stmt = statement.get()) {
+            sqlite3_bind_int(stmt, 1, limit);
             while (sqlite3_step(stmt) == SQLITE_ROW) {
                 FeedbackEntry entry;
                 entry.lacerte_name = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
@@ -666,327 +1131,203 @@ namespace TaxReturnSystem {
                 entry.user_id = sqlite3_column_int(stmt, 5);
                 history.push_back(entry);
             }
-            sqlite3_finalize(stmt);
         }
         return history;
     }
 
-    // Definition of a method to export feedback to training file; takes filename as parameter; returns void
-    void ProjectsDatabase::exportFeedbackToTrainingFile(const string& filename) {
-        try {
-            cout << "\n=== Starting feedback export to " << filename << " ===" << endl;
-
-            // Store the original file content exactly as is
-            vector<string> originalLines;
-            ifstream existingFile(filename);
-            if (existingFile.is_open()) {
-                cout << "Reading original training data..." << endl;
-                string line;
-                while (getline(existingFile, line)) {
-                    originalLines.push_back(line);
-                    cout << "Preserved original line: " << line << endl;
-                }
-                existingFile.close();
+    namespace {
+
+        // Quote a training file field if it contains a delimiter, quote or line break
+        string quoteTrainingField(const string& field) {
+            if (field.find_first_of(",\"\r\n") == string::npos) {
+                return field;
+            }
+            string quoted = "\"";
+            for (char c : field) {
+                if (c == '"') quoted += '"';
+                quoted += c;
             }
+            quoted += '"';
+            return quoted;
+        }
 
-            // Get new feedback from database
-            cout << "Querying database for feedback..." << endl;
-            string query = "SELECT lacerte_name, database_name, is_match FROM lacerte_feedback";
-            sqlite3_stmt* stmt;
+    } // namespace
 
-            if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-                throw runtime_error("Failed to prepare SQL statement");
-            }
+    // Definition of a method to append feedback not yet exported to the training file; takes filename as parameter; returns number of rows appended
+    size_t ProjectsDatabase::exportFeedbackToTrainingFile(const string& filename) {
+        // Exports read and advance the watermark, so they run one at a time; project writes are not held up by the file I/O
+        lock_guard<mutex> exportLock(feedbackExportMutex);
 
-            // Open file for writing
-            ofstream outFile(filename);
-            if (!outFile.is_open()) {
-                sqlite3_finalize(stmt);
-                throw runtime_error("Unable to open training file for writing");
+        // Rows up to last_feedback_id are already in the file
+        sqlite3_int64 lastExported = 0;
+        vector<tuple<sqlite3_int64, string, string, bool>> rows;
+        {
+            ReadLease reader = pool.reader();
+            CachedStatement watermarkStmt = reader->prepare("SELECT last_feedback_id FROM feedback_exports WHERE filename = ?;");
+            if (!watermarkStmt) {
+                throw runtime_error("Failed to prepare feedback export query: " + string(reader->errorMessage()));
             }
-
-            // Write original content exactly as is
-            cout << "Writing original training data..." << endl;
-            for (const string& line : originalLines) {
-                outFile << line << "\n";
+            sqlite3_bind_text(watermarkStmt.get(), 1, filename.c_str(), -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(watermarkStmt.get()) == SQLITE_ROW) {
+                lastExported = sqlite3_column_int64(watermarkStmt.get(), 0);
             }
+            watermarkStmt.reset();
 
-            // Add new feedback data
-            cout << "Adding new feedback data..." << endl;
+            CachedStatement feedbackStmt = reader->prepare("SELECT id, lacerte_name, database_name, is_match FROM lacerte_feedback "
+                                                           "WHERE id > ? ORDER BY id;");
+            sqlite3_stmt* stmt = feedbackStmt.get();
+            if (!stmt) {
+                throw runtime_error("Failed to prepare feedback export query: " + string(reader->errorMessage()));
+            }
+            sqlite3_bind_int64(stmt, 1, lastExported);
             while (sqlite3_step(stmt) == SQLITE_ROW) {
-                string lacerte_name = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-                string database_name = string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
-                bool is_match = sqlite3_column_int(stmt, 2) != 0;
-
-                // Skip empty entries
-                if (lacerte_name.empty() || database_name.empty()) {
-                    cout << "Skipping empty entry" << endl;
-                    continue;
-                }
-
-                outFile << lacerte_name << ","
-                        << database_name << ","
-                        << (is_match ? "1" : "-1") << "\n";
-                cout << "Added feedback: " << lacerte_name << ", " << database_name << endl;
+                rows.emplace_back(sqlite3_column_int64(stmt, 0), textColumn(stmt, 1), textColumn(stmt, 2),
+                                  sqlite3_column_int(stmt, 3) != 0);
             }
-
-            sqlite3_finalize(stmt);
-            outFile.close();
-
-        } catch (const exception& e) {
-            cerr << "Error exporting feedback: " << e.what() << endl;
-            throw;
         }
-    }
 
-// PROJECT MANAGER CLASS METHODS:
-
-    // Definition of a method to import projects from a CSV file into database; takes a string and a ReportType as parameters; returns bool
-    bool ProjectManager::importFromCSV(const string& filename, ReportType reportType) {
-
-        // Open and validate input file
-        ifstream inFile(filename);
-        if (!inFile.is_open()) {
-            cerr << "Failed to open file: " << filename << endl;
-            cerr << "Error: " << strerror(errno) << endl;
-            throw runtime_error("Error: Could not open file " + filename);
+        if (rows.empty()) {
+            return 0;
         }
 
-        // Read and process header line
-        string headerLine;
-        if (!getline(inFile, headerLine)) {
-            cerr << "File is empty" << endl;
-            throw runtime_error("Error: File is empty");
-        }
+        // Write the current file plus the new rows to a temporary file, so a failure part way leaves the training file untouched
+        string tempPath = filename + ".tmp";
+        string backupPath = filename + ".bak";
+        bool hadFile = filesystem::exists(filename);
 
-        // Update column mappings based on header
-        try {
-            ProjectsDatabase::updateColumnMappingsFromCSVHeader(headerLine);
-        } catch (const exception& e) {
-            cerr << "Error updating column mappings: " << e.what() << endl;
-            throw;
+        ofstream outFile(tempPath, ios::trunc);
+        if (!outFile.is_open()) {
+            throw runtime_error("Unable to open training file for writing");
         }
-
-        // Process CSV data
-        vector<Project> csvProjects;
-        int lineCount = 0;
-
-        string line;
-        while (getline(inFile, line)) {
-            lineCount++;
-
-            try {
-                // Initialize project and parsing variables
-                Project project;
-                project.setReportType(reportType);
-                int columnNum = 0;
-                bool inQuotes = false;
-                string currentCell;
-
-                // Remove trailing carriage return if present
-                if (!line.empty() && line.back() == '\r') {
-                    line.pop_back();
-                }
-
-                // Parse line character by character
-                for (size_t i = 0; i < line.length(); i++) {
-                    char ch = line[i];
-
-                    if (ch == '"') {
-                        inQuotes = !inQuotes;
-                    } else if (ch == ',' && !inQuotes) {
-                        project.saveToAppropriateVariable(columnNum, currentCell, reportType);
-                        currentCell.clear();
-                        columnNum++;
-                    } else if (ch != '\r' && ch != '\n') {  // Skip CR/LF characters
-                        currentCell += ch;
-                    }
-                }
-
-                // Process final column
-                if (!currentCell.empty() || columnNum < 9) {
-                    project.saveToAppropriateVariable(columnNum, currentCell, reportType);
-                }
-
-                csvProjects.push_back(project);
-            } catch (const exception& e) {
-                cerr << "Error processing line " << lineCount << ": " << e.what() << endl;
+        if (hadFile) {
+            ifstream existing(filename);
+            if (!existing.is_open()) {
+                throw runtime_error("Unable to read training file " + filename);
+            }
+            if (existing.peek() != ifstream::traits_type::eof()) {
+                outFile << existing.rdbuf();
             }
         }
 
-        inFile.close();
-
-        // Retrieve existing projects from database
-        vector<Project> dbProjects;
-        try {
-            dbProjects = database.getAllProjects();
-        } catch (const exception& e) {
-            cerr << "Error retrieving projects from database: " << e.what() << endl;
-            throw;
-        }
+        size_t appended = 0;
+        for (const auto& [id, lacerteName, databaseName, isMatch] : rows) {
+            // Skip empty entries
+            if (lacerteName.empty() || databaseName.empty()) {
+                continue;
+            }
 
-        // Prepare list of projects to remove
-        vector<string> projectIdsToRemove;
-        for (const auto& dbProject : dbProjects) {
-            projectIdsToRemove.push_back(dbProject.getId());
+            outFile << quoteTrainingField(lacerteName) << ","
+                    << quoteTrainingField(databaseName) << ","
+                    << (isMatch ? "1" : "-1") << "\n";
+            appended++;
         }
 
-        // Track operation counts
-        int addedCount = 0, updatedCount = 0, removedCount = 0;
-        bool success = true;
-
-        // Compare and update projects
-        for (const auto& csvProject : csvProjects) {
-            try {
-                auto dbProject = find_if(dbProjects.begin(), dbProjects.end(),
-                                         [&csvProject](const Project& p) {
-                                             return p.getClient() == csvProject.getClient() &&
-                                                    p.getProjectType() == csvProject.getProjectType();
-                                         });
-
-                if (dbProject == dbProjects.end()) {
-                    // Add new project
-                    bool addSuccess = database.addProjectToDatabase(csvProject);
-                    if (addSuccess) {
-                        addedCount++;
-                    } else {
-                        cerr << "Failed to add new project" << endl;
-                        success = false;
-                    }
-                } else {
-                    // Update existing project if needed
-                    if (dbProject->getGroup() != csvProject.getGroup() ||
-                        dbProject->getBillingPartner() != csvProject.getBillingPartner() ||
-                        dbProject->getPartner() != csvProject.getPartner() ||
-                        dbProject->getManager() != csvProject.getManager() ||
-                        dbProject->getNextTask() != csvProject.getNextTask() ||
-                        dbProject->getMemo() != csvProject.getMemo() ||
-                        dbProject->getRegularDeadline() != csvProject.getRegularDeadline() ||
-                        dbProject->getInternalDeadline() != csvProject.getInternalDeadline() ||
-                        dbProject->isExtended() != csvProject.isExtended()) {
-
-                        Project updatedProject = csvProject;
-                        updatedProject.setId(dbProject->getId());
-                        bool updateSuccess = database.updateProjectInDatabase(updatedProject);
-                        if (updateSuccess) {
-                            updatedCount++;
-                        } else {
-                            cerr << "Failed to update project: " << updatedProject.getClient() << " - " << updatedProject.getProjectType() << endl;
-                            success = false;
-                        }
-                    } else {
-                    }
+        outFile.close();
+        if (!outFile) {
+            filesystem::remove(tempPath);
+            throw runtime_error("Failed to write training file " + filename);
+        }
+
+        // Advance the watermark and swap the file in within one transaction: the rename happens only once the
+        // watermark is written, and a failed commit puts the previous file back, so no row is exported twice
+        WriteLease writer = pool.writer();
+        auto abandon = [&](const string& message) {
+            rollbackTransaction(*writer);
+            filesystem::remove(tempPath);
+            throw runtime_error(message);
+        };
 
-                    projectIdsToRemove.erase(remove(projectIdsToRemove.begin(), projectIdsToRemove.end(), dbProject->getId()), projectIdsToRemove.end());
-                }
-            } catch (const exception& e) {
-                cerr << "Error processing project " << csvProject.getClient() << " - " << csvProject.getProjectType() << ": " << e.what() << endl;
-                success = false;
+        if (!beginTransaction(*writer)) {
+            abandon("Failed to begin feedback export");
+        }
+        {
+            CachedStatement updateStmt = writer->prepare("INSERT OR REPLACE INTO feedback_exports (filename, last_feedback_id) VALUES (?, ?);");
+            if (!updateStmt) {
+                abandon("Failed to prepare feedback export update: " + string(writer->errorMessage()));
+            }
+            sqlite3_bind_text(updateStmt.get(), 1, filename.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(updateStmt.get(), 2, get<0>(rows.back()));
+            if (sqlite3_step(updateStmt.get()) != SQLITE_DONE) {
+                abandon("Failed to record feedback export: " + string(writer->errorMessage()));
             }
         }
 
-        // Remove projects not in CSV
-        for (const string& idToRemove : projectIdsToRemove) {
-            try {
-                bool removeSuccess = database.deleteProjectFromDatabase(idToRemove);
-                if (removeSuccess) {
-                    removedCount++;
-                } else {
-                    cerr << "Failed to remove project with ID: " << idToRemove << endl;
-                    success = false;
-                }
-            } catch (const exception& e) {
-                cerr << "Error removing project with ID " << idToRemove << ": " << e.what() << endl;
-                success = false;
+        error_code ec;
+        if (hadFile) {
+            filesystem::rename(filename, backupPath, ec);
+        }
+        if (!ec) {
+            filesystem::rename(tempPath, filename, ec);
+            if (ec && hadFile) {
+                error_code restoreError;
+                filesystem::rename(backupPath, filename, restoreError);
             }
         }
-
-        return success;
-    }
-
-    // Definition of a method to search projects in the database based on a search term; takes a string as a parameter; returns a vector of Projects
-    vector<Project> ProjectManager::searchProjects(const string& searchTerm) const {
-        return database.searchProjects(searchTerm);
-    }
-
-    // Definition of a method to export projects to a CSV file; takes a string and a ReportType as parameters; returns void
-    void ProjectManager::exportToCSV(const string& filename, ReportType reportType) const {
-        // Open output file
-        ofstream outFile(filename);
-        if (!outFile.is_open()) {
-            throw runtime_error("Error: Could not open file for writing: " + filename);
+        if (ec) {
+            abandon("Failed to replace training file " + filename + ": " + ec.message());
         }
 
-        // Write CSV header
-        outFile << "\"Group\",\"Client\",\"Project\",\"Due Date\",\"Billing Partner\",\"Partner\",\"Manager\",\"Next Task\",\"Memo\"\n";
-
-        // Get filtered projects
-        vector<Project> filteredProjects = getFilteredProjects();
-
-        // Write each project to CSV
-        for (const auto& project : filteredProjects) {
-            if (project.getReportType() == reportType) {
-                outFile << "\"" << project.getGroup() << "\","
-                        << "\"" << project.getClient() << "\","
-                        << "\"" << project.getProjectType() << "\","
-                        << "\"" << (reportType == ReportType::RegularDeadline ?
-                                    project.getRegularDeadline().getDateStr() :
-                                    project.getInternalDeadline().getDateStr()) << "\","
-                        << "\"" << project.getBillingPartner() << "\","
-                        << "\"" << project.getPartner() << "\","
-                        << "\"" << project.getManager() << "\","
-                        << "\"" << project.getNextTask() << "\","
-                        << "\"" << project.getMemo() << "\"\n";
+        if (!commitTransaction(*writer)) {
+            rollbackTransaction(*writer);
+            filesystem::remove(filename, ec);
+            if (hadFile) {
+                filesystem::rename(backupPath, filename, ec);
             }
+            throw runtime_error("Failed to commit feedback export: " + string(writer->errorMessage()));
+        }
+        if (hadFile) {
+            filesystem::remove(backupPath, ec);
         }
 
-        outFile.close();
+        return appended;
     }
 
-// Definition of a method to set a filter for project retrieval based on the specified filter type and value; takes a FilterType and a string as parameters; returns void
-    void ProjectManager::setFilter(FilterType filterType, const string& value) {
+// FILTER CRITERIA STRUCT METHODS:
+
+    // Definition of a method to set one filter criterion from its string form; takes a FilterType and a string as parameters; returns void
+    void FilterCriteria::set(FilterType filterType, const string& value) {
         // Set appropriate filter based on filter type
         switch (filterType) {
             // Basic text filters
             case FilterType::Group:
-                currentFilter.group = value;
+                group = value;
                 break;
             case FilterType::ProjectType:
-                currentFilter.projectType = value;
+                projectType = value;
                 break;
             case FilterType::BillingPartner:
-                currentFilter.billingPartner = value;
+                billingPartner = value;
                 break;
             case FilterType::Partner:
-                currentFilter.partner = value;
+                partner = value;
                 break;
             case FilterType::Manager:
-                currentFilter.manager = value;
+                manager = value;
                 break;
             case FilterType::NextTask:
-                currentFilter.nextTask = value;
+                nextTask = value;
                 break;
 
                 // Date filters
             case FilterType::StartDate:
-                currentFilter.startDate = Date(value);
+                startDate = Date(value);
                 break;
             case FilterType::EndDate:
-                currentFilter.endDate = Date(value);
+                endDate = Date(value);
                 break;
             case FilterType::RegularDeadline:
-                currentFilter.regularDeadline = Date(value);
+                regularDeadline = Date(value);
                 break;
             case FilterType::InternalDeadline:
-                currentFilter.internalDeadline = Date(value);
+                internalDeadline = Date(value);
                 break;
 
                 // Report type filter
             case FilterType::ReportType:
                 if (value == "Regular") {
-                    currentFilter.reportType = ReportType::RegularDeadline;
+                    reportType = ReportType::RegularDeadline;
                 } else if (value == "Internal") {
-                    currentFilter.reportType = ReportType::InternalDeadline;
+                    reportType = ReportType::InternalDeadline;
                 } else {
                     throw runtime_error("Invalid ReportType value: " + value);
                 }
@@ -997,11 +1338,11 @@ namespace TaxReturnSystem {
                 if (value == "1" || value == "true" || value == "True" ||
                     value == "TRUE" || value == "yes" || value == "Yes" ||
                     value == "YES" || value == "Extended") {
-                    currentFilter.extended = true;
+                    extended = true;
                 } else if (value == "0" || value == "false" || value == "False" ||
                            value == "FALSE" || value == "no" || value == "No" ||
                            value == "NO") {
-                    currentFilter.extended = false;
+                    extended = false;
                 } else {
                     throw runtime_error("Invalid Extended value: " + value);
                 }
@@ -1009,63 +1350,251 @@ namespace TaxReturnSystem {
         }
     }
 
-    // Definition of a method to set a date range filter for project retrieval; takes two strings as parameters; returns void
-    void ProjectManager::setDateRangeFilter(const string& startDate, const string& endDate) {
-        currentFilter.startDate = Date(startDate);
-        currentFilter.endDate = Date(endDate);
+    // Definition of a method to set the start and end date criteria; takes two strings as parameters; returns void
+    void FilterCriteria::setDateRange(const string& start, const string& end) {
+        startDate = Date(start);
+        endDate = Date(end);
     }
 
-    // Definition of a method to clear a specific filter type; takes a FilterType as a parameter; returns void
-    void ProjectManager::clearFilter(FilterType filterType) {
+    // Definition of a method to clear one filter criterion; takes a FilterType as a parameter; returns void
+    void FilterCriteria::clear(FilterType filterType) {
         // Reset specified filter to nullopt based on filter type
         switch (filterType) {
             // Basic text filters
             case FilterType::Group:
-                currentFilter.group = nullopt;
+                group = nullopt;
                 break;
             case FilterType::ProjectType:
-                currentFilter.projectType = nullopt;
+                projectType = nullopt;
                 break;
             case FilterType::BillingPartner:
-                currentFilter.billingPartner = nullopt;
+                billingPartner = nullopt;
                 break;
             case FilterType::Partner:
-                currentFilter.partner = nullopt;
+                partner = nullopt;
                 break;
             case FilterType::Manager:
-                currentFilter.manager = nullopt;
+                manager = nullopt;
                 break;
             case FilterType::NextTask:
-                currentFilter.nextTask = nullopt;
+                nextTask = nullopt;
                 break;
 
                 // Date filters
             case FilterType::StartDate:
-                currentFilter.startDate = nullopt;
+                startDate = nullopt;
                 break;
             case FilterType::EndDate:
-                currentFilter.endDate = nullopt;
+                endDate = nullopt;
                 break;
             case FilterType::RegularDeadline:
-                currentFilter.regularDeadline = nullopt;
+                regularDeadline = nullopt;
                 break;
             case FilterType::InternalDeadline:
-                currentFilter.internalDeadline = nullopt;
+                internalDeadline = nullopt;
                 break;
 
                 // Type filters
             case FilterType::ReportType:
-                currentFilter.reportType = nullopt;
+                reportType = nullopt;
                 break;
             case FilterType::Extended:
-                currentFilter.extended = nullopt;
+                extended = nullopt;
                 break;
         }
     }
 
-    // Definition of a method to reset all filters to their default state; takes no parameters; returns void
-    void ProjectManager::resetFilter() {
-        currentFilter = FilterCriteria();
+// PROJECT MANAGER CLASS METHODS:
+
+    // Definition of a method to import projects from a CSV file into database; takes a string, a ReportType and an optional ImportReport pointer as parameters; returns bool
+    bool ProjectManager::importFromCSV(const string& filename, ReportType reportType, ImportReport* reportOut) {
+        using Clock = chrono::steady_clock;
+        auto elapsedMs = [](Clock::time_point since) {
+            return chrono::duration<double, milli>(Clock::now() - since).count();
+        };
+
+        ImportReport report;
+        auto phaseStart = Clock::now();
+
+        // Open and validate input file
+        CSVReader reader = CSVReader::fromFile(filename);
+
+        // Read and process header line
+        if (!reader.readRow()) {
+            cerr << "File is empty" << endl;
+            throw runtime_error("Error: File is empty");
+        }
+
+        // Update column mappings based on header
+        try {
+            ProjectsDatabase::updateColumnMappingsFromCSVHeader(reader.getFields());
+        } catch (const exception& e) {
+            cerr << "Error updating column mappings: " << e.what() << endl;
+            throw;
+        }
+
+        // Process CSV data
+        vector<Project> csvProjects;
+
+        while (reader.readRow()) {
+            try {
+                Project project;
+                project.setReportType(reportType);
+
+                const vector<string_view>& cells = reader.getFields();
+                for (size_t columnNum = 0; columnNum < cells.size(); columnNum++) {
+                    project.saveToAppropriateVariable(static_cast<int>(columnNum), cells[columnNum], reportType);
+                }
+
+                csvProjects.push_back(move(project));
+            } catch (const exception& e) {
+                cerr << "Error processing line " << reader.getRowNumber() << ": " << e.what() << endl;
+            }
+        }
+
+        report.rowsRead = csvProjects.size();
+        report.parseMs = elapsedMs(phaseStart);
+
+        // Compare against the current snapshot in linear time
+        phaseStart = Clock::now();
+        ImportDiff diff;
+        try {
+            diff = diffAgainstDatabase(csvProjects, report.unchanged);
+        } catch (const exception& e) {
+            cerr << "Error retrieving projects from database: " << e.what() << endl;
+            throw;
+        }
+        report.diffMs = elapsedMs(phaseStart);
+
+        // Write all changes in one transaction
+        phaseStart = Clock::now();
+        bool success = database.applyImportDiff(diff);
+        report.applyMs = elapsedMs(phaseStart);
+
+        if (success) {
+            report.added = diff.additions.size();
+            report.updated = diff.updates.size();
+            report.removed = diff.removals.size();
+        } else {
+            cerr << "Failed to apply CSV import; no changes were written" << endl;
+        }
+        if (reportOut) {
+            *reportOut = report;
+        }
+
+        cout << "Import of " << filename << ": " << report.rowsRead << " rows, "
+             << report.added << " added, " << report.updated << " updated, "
+             << report.removed << " removed, " << report.unchanged << " unchanged "
+             << "(parse " << report.parseMs << " ms, diff " << report.diffMs
+             << " ms, apply " << report.applyMs << " ms)" << endl;
+
+        return success;
+    }
+
+    // Definition of a method to compute the add/update/remove diff between imported projects and the snapshot; takes a vector of Projects and an unchanged-row counter as parameters; returns ImportDiff
+    ImportDiff ProjectManager::diffAgainstDatabase(const vector<Project>& csvProjects, size_t& unchanged) const {
+        shared_ptr<const ProjectSnapshot> snapshot = database.getSnapshot();
+        ImportDiff diff;
+        unchanged = 0;
+
+        // Index existing rows by (client, project type)
+        auto makeKey = [](const string& client, const string& projectType) {
+            string key;
+            key.reserve(client.size() + projectType.size() + 1);
+            key.append(client).push_back('\x1f');
+            key.append(projectType);
+            return key;
+        };
+
+        unordered_map<string, uint32_t> rowsByKey;
+        rowsByKey.reserve(snapshot->size());
+        for (uint32_t row = 0; row < snapshot->size(); row++) {
+            // First row wins, matching the previous first-match lookup
+            rowsByKey.emplace(makeKey(snapshot->getClient(row), snapshot->getProjectType(row)), row);
+        }
+
+        vector<bool> seen(snapshot->size(), false);
+
+        for (const auto& csvProject : csvProjects) {
+            auto it = rowsByKey.find(makeKey(csvProject.getClient(), csvProject.getProjectType()));
+            if (it == rowsByKey.end()) {
+                diff.additions.push_back(csvProject);
+                continue;
+            }
+
+            uint32_t row = it->second;
+            seen[row] = true;
+
+            if (snapshot->getGroup(row) != csvProject.getGroup() ||
+                snapshot->getBillingPartner(row) != csvProject.getBillingPartner() ||
+                snapshot->getPartner(row) != csvProject.getPartner() ||
+                snapshot->getManager(row) != csvProject.getManager() ||
+                snapshot->getNextTask(row) != csvProject.getNextTask() ||
+                snapshot->getMemo(row) != csvProject.getMemo() ||
+                snapshot->getRegularDeadlineValue(row) != csvProject.getRegularDeadline().getValue() ||
+                snapshot->getInternalDeadlineValue(row) != csvProject.getInternalDeadline().getValue() ||
+                snapshot->isExtended(row) != csvProject.isExtended()) {
+
+                Project updatedProject = csvProject;
+                updatedProject.setId(snapshot->getId(row));
+                diff.updates.push_back(move(updatedProject));
+            } else {
+                unchanged++;
+            }
+        }
+
+        // Everything the CSV did not mention is removed
+        for (uint32_t row = 0; row < snapshot->size(); row++) {
+            if (!seen[row]) {
+                diff.removals.push_back(snapshot->getId(row));
+            }
+        }
+
+        return diff;
+    }
+
+    // Definition of a method to search projects in the database based on a search term; takes a string as a parameter; returns a vector of Projects
+    vector<Project> ProjectManager::searchProjects(const string& searchTerm) const {
+        return database.searchProjects(searchTerm);
+    }
+
+    // Definition of a method to get one page of search results; takes the search term, page size and cursor as parameters; returns ProjectSearchPage
+    ProjectSearchPage ProjectManager::searchProjects(const string& searchTerm, size_t limit, const string& cursor) const {
+        return database.searchProjects(searchTerm, limit, cursor);
+    }
+
+    // Definition of a method to export projects matching the given criteria to a CSV file; takes a string, a ReportType and FilterCriteria as parameters; returns void
+    void ProjectManager::exportToCSV(const string& filename, ReportType reportType, const FilterCriteria& criteria) const {
+        // Open output file
+        ofstream outFile(filename);
+        if (!outFile.is_open()) {
+            throw runtime_error("Error: Could not open file for writing: " + filename);
+        }
+
+        // Write CSV header
+        outFile << "\"Group\",\"Client\",\"Project\",\"Due Date\",\"Billing Partner\",\"Partner\",\"Manager\",\"Next Task\",\"Memo\"\n";
+
+        // Get filtered projects
+        vector<Project> filteredProjects = getFilteredProjects(criteria);
+
+        // Write each project to CSV
+        for (const auto& project : filteredProjects) {
+            if (project.getReportType() == reportType) {
+                outFile << "\"" << project.getGroup() << "\","
+                        << "\"" << project.getClient() << "\","
+                        << "\"" << project.getProjectType() << "\","
+                        << "\"" << (reportType == ReportType::RegularDeadline ?
+                                    project.getRegularDeadline().getDateStr() :
+                                    project.getInternalDeadline().getDateStr()) << "\","
+                        << "\"" << project.getBillingPartner() << "\","
+                        << "\"" << project.getPartner() << "\","
+                        << "\"" << project.getManager() << "\","
+                        << "\"" << project.getNextTask() << "\","
+                        << "\"" << project.getMemo() << "\"\n";
+            }
+        }
+
+        outFile.close();
     }
 
     // Definition of a method to extract the billing partner from a cell value; takes a string as a parameter; returns a string
@@ -1141,110 +1670,59 @@ namespace TaxReturnSystem {
         return database.getProjectsByDateRange(startDate, endDate, reportType);
     }
 
-    // Definition of a method to retrieve projects that match the current filter criteria; takes no parameters; returns a vector of Projects
-    vector<Project> ProjectManager::getFilteredProjects() const {
-        vector<Project> projects = database.getAllProjects();
-
-        if (currentFilter.group) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getGroup() != *currentFilter.group;
-                                     }), projects.end());
-        }
-        if (currentFilter.projectType) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getProjectType() != *currentFilter.projectType;
-                                     }), projects.end());
-        }
-        if (currentFilter.billingPartner) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getBillingPartner() != *currentFilter.billingPartner;
-                                     }), projects.end());
-        }
-        if (currentFilter.partner) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getPartner() != *currentFilter.partner;
-                                     }), projects.end());
-        }
-        if (currentFilter.manager) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getManager() != *currentFilter.manager;
-                                     }), projects.end());
-        }
-        if (currentFilter.nextTask) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getNextTask() != *currentFilter.nextTask;
-                                     }), projects.end());
-        }
-        if (currentFilter.startDate && currentFilter.endDate) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         Date dueDate = project.getRegularDeadline(); // or getInternalDeadline() based on context
-                                         return dueDate < *currentFilter.startDate || dueDate > *currentFilter.endDate;
-                                     }), projects.end());
-        }
-        if (currentFilter.regularDeadline) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getRegularDeadline() != *currentFilter.regularDeadline;
-                                     }), projects.end());
-        }
-        if (currentFilter.internalDeadline) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getInternalDeadline() != *currentFilter.internalDeadline;
-                                     }), projects.end());
-        }
-        if (currentFilter.reportType) {
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.getReportType() != *currentFilter.reportType;
-                                     }), projects.end());
-        }
-        if (currentFilter.extended) {  // Add this block
-            projects.erase(remove_if(projects.begin(), projects.end(),
-                                     [this](const Project& project) {
-                                         return project.isExtended() != *currentFilter.extended;
-                                     }), projects.end());
-        }
-
-        return projects;
+    // Definition of a method to retrieve projects that match the given filter criteria; takes FilterCriteria as parameter; returns a vector of Projects
+    vector<Project> ProjectManager::getFilteredProjects(const FilterCriteria& criteria) const {
+        return ProjectFilter(database.getSnapshot(), criteria).getProjects();
     }
 
-    // Definition of a method to update column mappings based on CSV header; takes a string as parameter; returns void
-    void ProjectsDatabase::updateColumnMappingsFromCSVHeader(const string& headerLine) {
-        vector<string> headers;
-        string currentHeader;
+    // Definition of a method to store a session's filter criteria; takes a session token and FilterCriteria as parameters; returns void
+    void ProjectManager::setSessionFilter(const string& sessionToken, const FilterCriteria& criteria) {
+        auto stored = make_shared<const FilterCriteria>(criteria);
+        auto now = chrono::system_clock::now();
 
-        // Initialize all column indices to -1
-        GROUP_COLUMN = CLIENT_COLUMN = PROJECT_COLUMN = DUE_DATE_COLUMN =
-        BILLING_PARTNER_COLUMN = PARTNER_COLUMN = MANAGER_COLUMN =
-        NEXT_TASK_COLUMN = MEMO_COLUMN = -1;
+        lock_guard<mutex> lock(sessionFiltersMutex);
 
-        // Parse header line character by character
-        for (size_t i = 0; i < headerLine.length(); i++) {
-            char c = headerLine[i];
-            if (c == ',' || c == '\n' || c == '\r') {
-                headers.push_back(currentHeader);
-                currentHeader.clear();
+        // Drop sessions whose token has expired without a logout
+        for (auto it = sessionFilters.begin(); it != sessionFilters.end();) {
+            if (it->second.expiresAt <= now) {
+                it = sessionFilters.erase(it);
             } else {
-                currentHeader += c;
+                ++it;
             }
         }
 
-        // Handle last header if no trailing delimiter
-        if (!currentHeader.empty()) {
-            headers.push_back(currentHeader);
+        // The token was issued before this request, so it expires within TOKEN_EXPIRY from now
+        sessionFilters[sessionToken] = {move(stored), now + chrono::seconds(TOKEN_EXPIRY)};
+    }
+
+    // Definition of a method to get a session's filter criteria, or empty criteria if none were set; takes a session token as parameter; returns shared pointer to FilterCriteria
+    shared_ptr<const FilterCriteria> ProjectManager::getSessionFilter(const string& sessionToken) const {
+        static const auto noFilter = make_shared<const FilterCriteria>();
+
+        lock_guard<mutex> lock(sessionFiltersMutex);
+        auto it = sessionFilters.find(sessionToken);
+        if (it == sessionFilters.end() || it->second.expiresAt <= chrono::system_clock::now()) {
+            return noFilter;
         }
+        return it->second.criteria;
+    }
+
+    // Definition of a method to drop a session's filter criteria; takes a session token as parameter; returns void
+    void ProjectManager::clearSessionFilter(const string& sessionToken) {
+        lock_guard<mutex> lock(sessionFiltersMutex);
+        sessionFilters.erase(sessionToken);
+    }
+
+    // Definition of a method to update column mappings based on CSV header; takes the header fields as parameter; returns void
+    void ProjectsDatabase::updateColumnMappingsFromCSVHeader(const vector<string_view>& headers) {
+        // Initialize all column indices to -1
+        GROUP_COLUMN = CLIENT_COLUMN = PROJECT_COLUMN = DUE_DATE_COLUMN =
+        BILLING_PARTNER_COLUMN = PARTNER_COLUMN = MANAGER_COLUMN =
+        NEXT_TASK_COLUMN = MEMO_COLUMN = -1;
 
         // Map column indices based on header names
         for (size_t i = 0; i < headers.size(); i++) {
-            const string& h = headers[i];
+            string_view h = headers[i];
             if (h == "Client") CLIENT_COLUMN = i;
             else if (h == "Project") PROJECT_COLUMN = i;
             else if (h == "Tags") BILLING_PARTNER_COLUMN = i;
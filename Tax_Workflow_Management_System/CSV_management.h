@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <vector>
 #include <optional>
@@ -12,7 +13,12 @@
 #include <sstream>
 #include <set>
 #include <map>
+#include <memory>
+#include <cstdint>
+#include <chrono>
 #include "config.h"
+#include "task_status.h"
+#include "sqlite_pool.h"
 #include "CSV_management.h"
 
 using namespace std;
@@ -40,6 +46,8 @@ namespace TaxReturnSystem {
 
         void setDate(const string& dateStr); // Set the date from a string in the format YYYY-MM-DD
         string getDateStr() const; // Return the date as a string in the format YYYY-MM-DD
+        int getValue() const { return dateValue; } // Return the date as an integer in the format YYYYMMDD
+        static Date fromValue(int value) { Date date; date.dateValue = value; return date; } // Create a date from an integer in the format YYYYMMDD
 
         // Comparison operators for Date
         bool operator<=(const Date& rhs) const { return dateValue <= rhs.dateValue; }
@@ -182,11 +190,12 @@ namespace TaxReturnSystem {
         string group, client, projectType, billingPartner, partner, manager, nextTask, memo;
         Date regularDeadline, internalDeadline;
         bool extended;
+        TaskStatus taskStatus = TaskStatus::Unknown; // Interned nextTask, kept in step by every nextTask write
         unordered_map<string, DependencyType> dependencies;
         ReportType reportType;
 
     public:
-        Project() : id(generateId()), extended(false) {} // Default constructor
+        Project() : extended(false) { id = generateId(); } // Default constructor; id is generated once the fields exist
 
         string generateId() const { // Generate a unique ID for the project
             string generatedId = group + "|" + client + "|" + projectType;
@@ -197,7 +206,7 @@ namespace TaxReturnSystem {
         string getId() const { return id; }
         void setId(const string& newId) { id = newId; }
 
-        void saveToAppropriateVariable(int columnNum, const string& cellVal, const ReportType type); // Assign a value to the appropriate member variable based on the column number
+        void saveToAppropriateVariable(int columnNum, string_view cellVal, const ReportType type); // Assign a value to the appropriate member variable based on the column number
 
         // Getters
         string getGroup() const { return group; }
@@ -207,6 +216,7 @@ namespace TaxReturnSystem {
         string getPartner() const { return partner; }
         string getManager() const { return manager; }
         string getNextTask() const { return nextTask; }
+        TaskStatus getTaskStatus() const { return taskStatus; }
         string getMemo() const { return memo; }
         Date getRegularDeadline() const { return regularDeadline; }
         Date getInternalDeadline() const { return internalDeadline; }
@@ -220,7 +230,8 @@ namespace TaxReturnSystem {
         void setBillingPartner(const string& newBillingPartner) { billingPartner = newBillingPartner; }
         void setPartner(const string& newPartner) { partner = newPartner; }
         void setManager(const string& newManager) { manager = newManager; }
-        void setNextTask(const string& newNextTask) { nextTask = newNextTask; }
+        void setNextTask(const string& newNextTask) { nextTask = newNextTask; taskStatus = parseTaskStatus(nextTask); }
+        void setNextTask(const string& newNextTask, TaskStatus status) { nextTask = newNextTask; taskStatus = status; } // For callers that already interned the value
         void setMemo(const string& newMemo) { memo = newMemo; }
         void setRegularDeadline(const Date& newRegularDeadline) { regularDeadline = newRegularDeadline; }
         void setInternalDeadline(const Date& newInternalDeadline) { internalDeadline = newInternalDeadline; }
@@ -232,6 +243,7 @@ namespace TaxReturnSystem {
         bool hasDependency(string projectId) const { return dependencies.find(projectId) != dependencies.end(); }
         void clearDependencies() { dependencies.clear(); }
         bool isDependencyMet(const string& dependencyId, const string& dependencyStatus) const;
+        bool isDependencyMet(const string& dependencyId, TaskStatus dependencyStatus) const;
         void buildPTETDependency(const vector<Project>& allProjects);
 
         bool isInDeadline(const Date& deadline, ReportType deadlineType) const;
@@ -240,35 +252,81 @@ namespace TaxReturnSystem {
         void setExtended(bool isExtended) { extended = isExtended; }
     };
 
-    // Manages the database of projects
+    class ProjectSnapshot;
+    class StatisticsAggregates;
+    class DependencyGraph;
+    struct DependencyChanges;
+
+    // Changes needed to bring the projects table in line with an imported CSV
+    struct ImportDiff {
+        vector<Project> additions; // Projects in the CSV with no matching database row
+        vector<Project> updates; // Changed projects, carrying the id of the database row they replace
+        vector<string> removals; // Ids of database rows missing from the CSV
+    };
+
+    // Row counts and per-phase timings of the last CSV import
+    struct ImportReport {
+        size_t rowsRead = 0, added = 0, updated = 0, removed = 0, unchanged = 0;
+        double parseMs = 0, diffMs = 0, applyMs = 0; // Time spent reading the file, diffing and writing
+    };
+
+    // One page of search results, best matches first
+    struct ProjectSearchPage {
+        vector<Project> projects; // Matching projects on this page
+        string nextCursor; // Pass back to get the next page; empty on the last page
+    };
+
+    // Manages the database of projects. Reads lease one of the pool's reader connections and may run
+    // concurrently with each other and with a write; writes lease the single writer connection for
+    // their whole transaction, so they run one at a time.
     class ProjectsDatabase {
     private:
         string dbPath; // Path to the database file
-        sqlite3* db; // SQLite database connection
-
-        void executeQuery(const string& query); // Execute a SQL query
-
-        // Methods for database connection management
-        bool openDatabase();
-        void closeDatabase();
-        bool initializeDatabase();
-        bool isInTransaction = false; // Transaction state
+        mutable SqlitePool pool; // Writer and reader connections in WAL mode
+
+        // In-memory snapshot of the projects table
+        mutable mutex snapshotMutex; // Guards the snapshot fields below
+        mutable shared_ptr<const ProjectSnapshot> snapshot; // Current snapshot, rebuilt lazily
+        mutable bool snapshotStale = true; // Whether the projects table changed since the snapshot was built
+        mutable uint64_t snapshotVersion = 0; // Version counter for rebuilt snapshots
+
+        mutex feedbackExportMutex; // Serializes exports to training files, which read and advance their watermark
+        unique_ptr<DependencyGraph> dependencyGraph; // Project dependencies, mirrored in the project_dependencies table
+        unique_ptr<StatisticsAggregates> aggregates; // Statistics counters, updated alongside every write
+
+        void loadDependencyGraph(SqliteConnection& writer); // Build the graph from the stored edges, deriving them when none are stored
+        bool writeDependencyChanges(SqliteConnection& writer, const DependencyChanges& changes); // Write a graph change to project_dependencies
+        void attachDependencies(vector<Project>& projects) const; // Fill each project's dependencies from the graph
+        shared_ptr<const ProjectSnapshot> buildSnapshot(uint64_t version) const; // Load the projects table into a new snapshot
+        vector<Project> getProjectsByColumn(const char* column, const string& value) const; // Select the projects whose column equals value
+        vector<Project> findMatches(const string& searchTerm, int64_t limit, int64_t offset) const; // Run a search; a limit of -1 returns every match
+        void invalidateSnapshot(); // Mark the snapshot stale after a write
+
+        // Transaction helpers; callers hold the writer lease from begin to commit or rollback
+        bool beginTransaction(SqliteConnection& writer);
+        bool commitTransaction(SqliteConnection& writer);
+        bool rollbackTransaction(SqliteConnection& writer);
 
     public:
         ProjectsDatabase(const string& dbPath); // Constructor
         ~ProjectsDatabase(); // Destructor
 
-        void createTablesIfNotExist(); // Helper function for constructor
+        void createTablesIfNotExist(); // Create the tables and migrate older files to the current schema version
 
         // CRUD operations for projects
         bool addProjectToDatabase(const Project& project);
         bool getProjectFromDatabase(const string& id, Project& project);
         bool updateProjectInDatabase(const Project& project);
         bool deleteProjectFromDatabase(const string& id);
+        bool applyImportDiff(const ImportDiff& diff); // Apply an import diff in a single transaction
 
         // Methods to retrieve projects based on various criteria
+        shared_ptr<const ProjectSnapshot> getSnapshot() const; // Get the current in-memory snapshot of all projects
+        const StatisticsAggregates& getAggregates() const { return *aggregates; } // Get the incrementally maintained statistics counters
+        const DependencyGraph& getDependencyGraph() const { return *dependencyGraph; } // Get the project dependency graph
         vector<Project> getAllProjects() const;
-        vector<Project> searchProjects(const string& searchTerm) const;
+        vector<Project> searchProjects(const string& searchTerm) const; // Every project containing the term, best matches first
+        ProjectSearchPage searchProjects(const string& searchTerm, size_t limit, const string& cursor) const; // One page of matches
         vector<Project> getProjectsByDateRange(const Date& startDate, const Date& endDate, ReportType reportType) const;
         vector<Project> getProjectsByManager(const string& manager) const;
         vector<Project> getProjectsByPartner(const string& partner) const;
@@ -279,11 +337,8 @@ namespace TaxReturnSystem {
         void listAllProjects() const; // List all projects (for debugging)
 
         bool testDatabaseWrite();
-        bool commitTransaction();
-        bool beginTransaction();
-        bool rollbackTransaction();
 
-        static void updateColumnMappingsFromCSVHeader(const string& headerLine);
+        static void updateColumnMappingsFromCSVHeader(const vector<string_view>& headers); // Map column indices from the CSV header fields
 
         // Store feedback data in database
         bool storeFeedback(const string& lacerteName,
@@ -295,8 +350,24 @@ namespace TaxReturnSystem {
         // Retrieve recent feedback entries
         vector<FeedbackEntry> getFeedbackHistory(int limit = 100);
 
-        // Export feedback data to training file
-        void exportFeedbackToTrainingFile(const string& filename);
+        // Append feedback recorded since the last export to a training file; returns rows appended
+        size_t exportFeedbackToTrainingFile(const string& filename);
+    };
+
+    // Enum for the fields a filter can be set on
+    enum class FilterType {
+        Group,
+        ProjectType,
+        BillingPartner,
+        Partner,
+        Manager,
+        NextTask,
+        StartDate,
+        EndDate,
+        RegularDeadline,
+        InternalDeadline,
+        ReportType,
+        Extended
     };
 
     // Struct for filter criteria
@@ -306,37 +377,54 @@ namespace TaxReturnSystem {
         optional<Date> regularDeadline, internalDeadline;
         optional<bool> extended;
         optional<ReportType> reportType;
+
+        void set(FilterType filterType, const string& value); // Set one criterion from its string form
+        void setDateRange(const string& startDate, const string& endDate); // Set the start and end date criteria
+        void clear(FilterType filterType); // Clear one criterion
     };
 
     // Manages project operations and filtering
     class ProjectManager {
     private:
-        ProjectsDatabase database; // Database of projects
-        FilterCriteria currentFilter; // Current filter criteria
+        ProjectsDatabase& database; // Database of projects, shared with the rest of the application
+
+        ImportDiff diffAgainstDatabase(const vector<Project>& csvProjects, size_t& unchanged) const; // Compare imported projects with the snapshot
+
+        // Filter criteria of one session, kept no longer than its token can be valid
+        struct SessionFilter {
+            shared_ptr<const FilterCriteria> criteria; // Criteria applied by the session
+            chrono::system_clock::time_point expiresAt; // When the session's token has expired for certain
+        };
+
+        mutable mutex sessionFiltersMutex; // Guards sessionFilters
+        unordered_map<string, SessionFilter> sessionFilters; // Filter criteria per session token
 
     public:
-        ProjectManager(const string& dbPath) : database(dbPath) {} // Constructor
+        explicit ProjectManager(ProjectsDatabase& database) : database(database) {} // Constructor
 
         static string getBillingPartner(const string& cellVal); // Extract billing partner from a cell value
 
         // CSV import/export operations
-        bool importFromCSV(const string& filename, ReportType reportType);
-        void exportToCSV(const string& filename, ReportType reportType) const;
+        bool importFromCSV(const string& filename, ReportType reportType, ImportReport* report = nullptr); // Fills report with counts and timings when given
+        void exportToCSV(const string& filename, ReportType reportType, const FilterCriteria& criteria = FilterCriteria()) const;
 
-        // Filter management
-        void setFilter(FilterType filterType, const string& value);
-        void setDateRangeFilter(const string& startDate, const string& endDate);
-        void clearFilter(FilterType filterType);
-        void resetFilter();
-        vector<Project> getFilteredProjects() const;
+        // Per-session filter management
+        void setSessionFilter(const string& sessionToken, const FilterCriteria& criteria);
+        shared_ptr<const FilterCriteria> getSessionFilter(const string& sessionToken) const;
+        void clearSessionFilter(const string& sessionToken);
+        vector<Project> getFilteredProjects(const FilterCriteria& criteria) const;
 
         vector<Project> searchProjects(const string& searchTerm) const; // Search projects based on a search term
+        ProjectSearchPage searchProjects(const string& searchTerm, size_t limit, const string& cursor) const; // One page of search results
 
         void displayFilteredData(const vector<Project>& projects) const; // Display filtered data for testing purposes
 
         vector<Project> filterByDateRange(const Date& startDate, const Date& endDate, ReportType reportType) const; // Filter projects by date range
 
         vector<Project> getAllProjects(); // Get all projects
+        shared_ptr<const ProjectSnapshot> getSnapshot() const { return database.getSnapshot(); } // Get the current project snapshot
+        const StatisticsAggregates& getAggregates() const { return database.getAggregates(); } // Get the statistics counters
+        const DependencyGraph& getDependencyGraph() const { return database.getDependencyGraph(); } // Get the project dependency graph
 
         static bool isProjectExtended(const string& cellVal); // Check if project is extended
     };
@@ -8,11 +8,16 @@
  */
 
 #include "Lacerte_cross_ref.h"
+#include "csv_reader.h"
+#include "feature_store.h"
+#include "edit_distance.h"
+#include "name_normalizer.h"
+#include "task_executor.h"
+#include "batch_scoring.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-#include <regex>
 #include "config.h"
 #include <thread>
 #include <atomic>
@@ -23,6 +28,7 @@ namespace TaxReturnSystem {
 
     // Definition of method to initialize equivalent terms mapping; takes no parameters; returns void
     void LacerteCrossReference::initializeEquivalentTerms() {
+        // Looked up with tokens of normalized names, so every term is lowercase
         equivalentTerms = {
                 {"&", {"and"}},
                 {"intl", {"international"}},
@@ -36,11 +42,10 @@ namespace TaxReturnSystem {
                 {"mgmt", {"management"}},
                 {"ave", {"avenue"}},
                 {"st", {"street"}},
-                {"E", {"East"}},
+                {"e", {"east"}},
                 {"@", {"at"}},
                 {"opco", {"operating"}},
-                {"holdco", {"holding"}},
-                {"holdco", {"holdings"}},
+                {"holdco", {"holding", "holdings"}},
                 {"tom", {"thomas"}},
                 {"dan", {"daniel"}},
                 {"dave", {"david"}}
@@ -50,58 +55,32 @@ namespace TaxReturnSystem {
     // Definition of method to read CSV file; takes filename string parameter; returns vector of string vectors
     vector<vector<string>> LacerteCrossReference::readCSV(const string& filename) {
         vector<vector<string>> data;
-        ifstream file(filename);
-        string line;
 
-        while (getline(file, line)) {
-            stringstream ss(line);
-            string item;
-            vector<string> row;
-
-            while (getline(ss, item, ',')) {
-                row.push_back(item);
+        try {
+            CSVReader reader = CSVReader::fromFile(filename);
+            while (reader.readRow()) {
+                const vector<string_view>& fields = reader.getFields();
+                data.emplace_back(fields.begin(), fields.end());
             }
-            data.push_back(row);
+        } catch (const exception& e) {
+            cerr << "Error reading CSV file " << filename << ": " << e.what() << endl;
         }
+
         return data;
     }
 
     // Definition of method to preprocess a name; takes name string parameter; returns processed string
     string LacerteCrossReference::preprocessName(const string& name) {
-        static const unordered_map<string, string> businessAbbrs = {
-                {"llc", ""}, {"ltd", ""}, {"inc", ""}, {"corp", ""},
-                {"corporation", ""}, {"incorporated", ""}, {"limited", ""},
-                {"company", ""}, {"co", ""}, {"lp", ""}, {"llp", ""},
-                {"l.l.c.", ""}, {"l.t.d.", ""}, {"l.p.", ""}, {"l.l.p.", ""}
-        };
-
         string processed;
-        processed.reserve(name.length());
-
-        transform(name.begin(), name.end(), back_inserter(processed),
-                  [](unsigned char c) { return tolower(c); });
-
-        static const regex cleanup_pattern("[.,;:'\"\\-_\\s]+");
-        processed = regex_replace(processed, cleanup_pattern, " ");
-
-        for (const auto& [abbr, _] : businessAbbrs) {
-            size_t pos;
-            while ((pos = processed.find(abbr)) != string::npos) {
-                processed.erase(pos, abbr.length());
-            }
-        }
-
-        if (!processed.empty()) {
-            size_t start = processed.find_first_not_of(" ");
-            size_t end = processed.find_last_not_of(" ");
-            if (start != string::npos && end != string::npos) {
-                processed = processed.substr(start, end - start + 1);
-            }
-        }
-
+        preprocessName(name, processed);
         return processed;
     }
 
+    // Definition of method to preprocess a name into a reusable buffer; takes name string and output string as parameters; returns void
+    void LacerteCrossReference::preprocessName(const string& name, string& processed) {
+        NameNormalizer::normalize(name, processed);
+    }
+
     // Definition of method to tokenize and sort a name; takes name string parameter; returns vector of tokens
     vector<string> LacerteCrossReference::tokenizeAndSort(const string& name) {
         vector<string> tokens;
@@ -115,48 +94,50 @@ namespace TaxReturnSystem {
         return tokens;
     }
 
-    // Definition of method to calculate Levenshtein distance; takes two strings as parameters; returns distance as integer
-    int LacerteCrossReference::calculateLevenshteinDistance(const string& s1, const string& s2) {
-        vector<vector<int>> dp(s1.length() + 1, vector<int>(s2.length() + 1));
-
-        for (int i = 0; i <= s1.length(); i++)
-            dp[i][0] = i;
-        for (int j = 0; j <= s2.length(); j++)
-            dp[0][j] = j;
-
-        for (int i = 1; i <= s1.length(); i++) {
-            for (int j = 1; j <= s2.length(); j++) {
-                if (s1[i-1] == s2[j-1])
-                    dp[i][j] = dp[i-1][j-1];
-                else
-                    dp[i][j] = 1 + min({dp[i-1][j], dp[i][j-1], dp[i-1][j-1]});
+    // Definition of method to compute all per-name matching data once; takes name string parameter; returns PrecomputedFeatures
+    LacerteCrossReference::PrecomputedFeatures LacerteCrossReference::computeFeatures(const string& name) {
+        PrecomputedFeatures features;
+        features.clientName = name;
+        preprocessName(name, features.processedName);
+        features.tokens = tokenizeAndSort(features.processedName);
+        features.tokenSet = unordered_set<string>(features.tokens.begin(), features.tokens.end());
+        features.features = nameToFeatures(features.processedName);
+        return features;
+    }
+
+    namespace {
+
+        // Maximum edit distance for two tokens to count as the same word; -1 if either is too short for typo matching
+        inline int tokenEditThreshold(size_t length1, size_t length2) {
+            if (length1 <= 3 || length2 <= 3) {
+                return -1;
             }
+            return max(length1, length2) <= 5 ? 1 : 2;
         }
 
-        return dp[s1.length()][s2.length()];
+    } // namespace
+
+    // Definition of method to check whether token2 is a listed equivalent of token1; takes two token strings as parameters; returns boolean
+    bool LacerteCrossReference::isEquivalentTerm(const string& token1, const string& token2) const {
+        auto it = equivalentTerms.find(token1);
+        return it != equivalentTerms.end() &&
+               find(it->second.begin(), it->second.end(), token2) != it->second.end();
     }
 
     // Definition of method to check token equivalence; takes two token strings as parameters; returns boolean
-    bool LacerteCrossReference::areTokensEquivalent(const string& token1, const string& token2) {
+    bool LacerteCrossReference::areTokensEquivalent(const string& token1, const string& token2) const {
         if (token1 == token2) return true;
 
-        if (equivalentTerms.count(token1) &&
-            find(equivalentTerms[token1].begin(), equivalentTerms[token1].end(), token2) != equivalentTerms[token1].end()) {
+        if (isEquivalentTerm(token1, token2)) {
             return true;
         }
 
-        if (token1.length() <= 3 || token2.length() <= 3) {
-            return false;
-        }
-
-        int maxLength = max(token1.length(), token2.length());
-        int threshold = maxLength <= 5 ? 1 : 2;
-
-        return calculateLevenshteinDistance(token1, token2) <= threshold;
+        int threshold = tokenEditThreshold(token1.length(), token2.length());
+        return threshold >= 0 && boundedLevenshtein(token1, token2, threshold) <= threshold;
     }
 
     // Definition of method to calculate token overlap; takes two name strings as parameters; returns overlap score as double
-    double LacerteCrossReference::tokenOverlap(const PrecomputedFeatures& features1, const PrecomputedFeatures& features2) {
+    double LacerteCrossReference::tokenOverlap(const PrecomputedFeatures& features1, const PrecomputedFeatures& features2) const {
         int matchCount = 0;
 
         const auto& smaller = features1.tokenSet.size() < features2.tokenSet.size() ?
@@ -165,9 +146,26 @@ namespace TaxReturnSystem {
                              features2.tokenSet : features1.tokenSet;
 
         for (const auto& token : smaller) {
-            if (larger.count(token) ||
-                any_of(larger.begin(), larger.end(),
-                       [&](const string& t) { return areTokensEquivalent(token, t); })) {
+            if (larger.count(token)) {
+                matchCount++;
+                continue;
+            }
+
+            auto equivalents = equivalentTerms.find(token);
+            if (equivalents != equivalentTerms.end() &&
+                any_of(equivalents->second.begin(), equivalents->second.end(),
+                       [&](const string& term) { return larger.count(term) > 0; })) {
+                matchCount++;
+                continue;
+            }
+
+            if (token.length() <= 3) {
+                continue;
+            }
+
+            // Build the pattern once and compare it against every token of the larger set
+            LevenshteinPattern pattern(token);
+            if (pattern.anyWithin(larger, [&](const string& t) { return tokenEditThreshold(token.length(), t.length()); })) {
                 matchCount++;
             }
         }
@@ -179,7 +177,7 @@ namespace TaxReturnSystem {
     // Definition of method to load training data; takes filename string parameter; returns void
     void LacerteCrossReference::loadTrainingData(const string& filename) {
         auto csvData = readCSV(filename);
-        training_data.clear();
+        vector<TrainingPair> loaded;
 
         int positiveCount = 0;
         int negativeCount = 0;
@@ -205,13 +203,17 @@ namespace TaxReturnSystem {
                     continue;
                 }
 
-                training_data.push_back(pair);
+                loaded.push_back(pair);
             }
         }
 
-        if (training_data.empty()) {
+        if (loaded.empty()) {
             throw runtime_error("No valid training data loaded from " + filename);
         }
+
+        lock_guard<mutex> lock(trainingDataMutex);
+        training_data = move(loaded);
+        trainingDataGeneration++;
     }
 
     // Definition of method to convert name to features; takes name string parameter; returns feature vector
@@ -219,7 +221,9 @@ namespace TaxReturnSystem {
         sample_type features;
         features.set_size(5);
 
-        string processed = preprocessName(name);
+        // Reuse one buffer per thread; this runs for every name in a batch
+        thread_local string processed;
+        preprocessName(name, processed);
         auto tokens = tokenizeAndSort(processed);
 
         // Feature 1: Word count (normalized)
@@ -245,62 +249,187 @@ namespace TaxReturnSystem {
         return features;
     }
 
-    // Definition of method to train the model; takes no parameters; returns void
-    void LacerteCrossReference::trainModel() {
-        vector<sample_type> samples;
-        vector<double> labels;
-
-        for (const auto& pair : training_data) {
-            // Create PrecomputedFeatures for both names
-            PrecomputedFeatures features1;
-            features1.clientName = pair.system1_name;
-            features1.processedName = preprocessName(pair.system1_name);
-            features1.tokens = tokenizeAndSort(features1.processedName);
-            features1.tokenSet = unordered_set<string>(features1.tokens.begin(), features1.tokens.end());
-            features1.features = nameToFeatures(features1.processedName);
-
-            PrecomputedFeatures features2;
-            features2.clientName = pair.system2_name;
-            features2.processedName = preprocessName(pair.system2_name);
-            features2.tokens = tokenizeAndSort(features2.processedName);
-            features2.tokenSet = unordered_set<string>(features2.tokens.begin(), features2.tokens.end());
-            features2.features = nameToFeatures(features2.processedName);
-
-            // Set token overlap for this specific pair
-            double overlap = tokenOverlap(features1, features2);
-            features1.features(3) = overlap;
-            features2.features(3) = overlap;
-
-            auto combined = concatenateFeatures(features1.features, features2.features);
-            samples.push_back(combined);
-            labels.push_back(pair.is_match ? 1.0 : -1.0);
+    namespace {
+
+        // One passive-aggressive (PA-I) step: move just far enough to classify the sample with margin 1, capped at c
+        void passiveAggressiveStep(LacerteCrossReference::LinearModel& model,
+                                   const LacerteCrossReference::sample_type& sample, double label, double c) {
+            if (model.weights.size() != static_cast<size_t>(sample.size())) {
+                model.weights.resize(sample.size(), 0.0);
+            }
+
+            double loss = 1.0 - label * model.score(sample);
+            if (loss <= 0.0) {
+                return;
+            }
+
+            // The bias acts as a weight on a constant feature of 1
+            double squaredNorm = 1.0;
+            for (long i = 0; i < sample.size(); i++) {
+                squaredNorm += sample(i) * sample(i);
+            }
+
+            double step = min(c, loss / squaredNorm) * label;
+            for (long i = 0; i < sample.size(); i++) {
+                model.weights[i] += step * sample(i);
+            }
+            model.bias += step;
+        }
+
+    } // namespace
+
+    // Definition of destructor; stops the background retraining thread
+    LacerteCrossReference::~LacerteCrossReference() {
+        {
+            lock_guard<mutex> lock(retrainMutex);
+            stopRetraining = true;
+        }
+        retrainCondition.notify_all();
+        if (retrainThread.joinable()) {
+            retrainThread.join();
         }
+    }
+
+    // Definition of method to score a pair with the linear model; takes concatenated pair features as parameter; returns raw decision value
+    double LacerteCrossReference::LinearModel::score(const sample_type& sample) const {
+        double value = bias;
+        size_t dimensions = min(weights.size(), static_cast<size_t>(sample.size()));
+        for (size_t i = 0; i < dimensions; i++) {
+            value += weights[i] * sample(i);
+        }
+        return value;
+    }
+
+    // Definition of method to compute the model input for a pair; takes two precomputed features as parameters; returns concatenated feature vector
+    LacerteCrossReference::sample_type LacerteCrossReference::pairFeatures(
+            const PrecomputedFeatures& features1, const PrecomputedFeatures& features2) {
+        // Set token overlap for this specific pair
+        double overlap = tokenOverlap(features1, features2);
+        auto f1 = features1.features;
+        auto f2 = features2.features;
+        f1(3) = overlap;
+        f2(3) = overlap;
+        return concatenateFeatures(f1, f2);
+    }
+
+    // Definition of method to fit the SVM on training pairs; takes training pairs as parameter; returns LinearModel
+    LacerteCrossReference::LinearModel LacerteCrossReference::trainLinearModel(const vector<TrainingPair>& pairs) {
+        vector<sample_type> samples(pairs.size());
+        vector<double> labels(pairs.size());
+
+        TaskExecutor::shared().parallelFor(0, pairs.size(), 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                samples[i] = pairFeatures(computeFeatures(pairs[i].system1_name), computeFeatures(pairs[i].system2_name));
+                labels[i] = pairs[i].is_match ? 1.0 : -1.0;
+            }
+        });
 
         dlib::svm_c_linear_trainer<kernel_type> trainer;
         trainer.set_c(10.0);
         trainer.set_epsilon(0.001);
+        dec_funct_type decision = trainer.train(samples, labels);
+
+        // A linear kernel decision function is sum(alpha_i * <basis_i, x>) - b; fold it into one weight vector
+        LinearModel trained;
+        trained.weights.assign(samples.empty() ? 0 : samples.front().size(), 0.0);
+        for (long i = 0; i < decision.basis_vectors.size(); i++) {
+            const sample_type& basis = decision.basis_vectors(i);
+            for (long j = 0; j < basis.size() && j < static_cast<long>(trained.weights.size()); j++) {
+                trained.weights[j] += decision.alpha(i) * basis(j);
+            }
+        }
+        trained.bias = -decision.b;
+        return trained;
+    }
+
+    // Definition of method to train the model; takes no parameters; returns void
+    void LacerteCrossReference::trainModel() {
+        vector<TrainingPair> pairs;
+        {
+            lock_guard<mutex> lock(trainingDataMutex);
+            pairs = training_data;
+        }
+
+        auto trained = make_shared<const LinearModel>(trainLinearModel(pairs));
+
+        lock_guard<mutex> lock(modelUpdateMutex);
+        atomic_store(&model, trained);
+    }
+
+    // Definition of method to schedule a background retrain; takes no parameters; returns void
+    void LacerteCrossReference::requestRetrain() {
+        lock_guard<mutex> lock(retrainMutex);
+        retrainRequested = true;
+        if (!retrainThread.joinable()) {
+            retrainThread = thread(&LacerteCrossReference::retrainLoop, this);
+        }
+        retrainCondition.notify_one();
+    }
+
+    // Definition of method run by the retrain thread; takes no parameters; returns void
+    void LacerteCrossReference::retrainLoop() {
+        while (true) {
+            {
+                unique_lock<mutex> lock(retrainMutex);
+                retrainCondition.wait(lock, [this] { return retrainRequested || stopRetraining; });
+                if (stopRetraining) {
+                    return;
+                }
+                // Requests arriving while this retrain runs coalesce into one more
+                retrainRequested = false;
+            }
+
+            try {
+                auto start = chrono::steady_clock::now();
+                size_t exported = database.exportFeedbackToTrainingFile(learningParams.trainingFile);
+
+                vector<TrainingPair> pairs;
+                uint64_t generation;
+                {
+                    lock_guard<mutex> lock(trainingDataMutex);
+                    pairs = training_data;
+                    generation = trainingDataGeneration;
+                }
+                LinearModel trained = trainLinearModel(pairs);
+
+                // Feedback that arrived during training was applied to the old model; replay it on the new one.
+                // Within one generation training_data only grows, so the new pairs are the ones past the copy.
+                lock_guard<mutex> lock(modelUpdateMutex);
+                vector<TrainingPair> arrived;
+                bool replaced;
+                {
+                    lock_guard<mutex> dataLock(trainingDataMutex);
+                    replaced = generation != trainingDataGeneration;
+                    if (!replaced) {
+                        arrived.assign(training_data.begin() + pairs.size(), training_data.end());
+                    }
+                }
+                if (replaced) {
+                    // The training data was reloaded while this model trained; train again on the new data
+                    cout << "Training data was reloaded during a background retrain; retraining again" << endl;
+                    requestRetrain();
+                    continue;
+                }
+                for (const auto& pair : arrived) {
+                    passiveAggressiveStep(trained,
+                                          pairFeatures(computeFeatures(pair.system1_name), computeFeatures(pair.system2_name)),
+                                          pair.is_match ? 1.0 : -1.0, learningParams.passiveAggressiveC);
+                }
+                atomic_store(&model, make_shared<const LinearModel>(move(trained)));
 
-        matcher_model = trainer.train(samples, labels);
+                auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+                cout << "Background retrain finished: " << pairs.size() << " pairs, "
+                     << exported << " feedback rows exported, " << elapsed << " ms" << endl;
+            } catch (const exception& e) {
+                cerr << "Background retrain failed: " << e.what() << endl;
+            }
+        }
     }
 
     // Definition of method to get match confidence; takes two name strings as parameters; returns confidence score as double
     double LacerteCrossReference::getMatchConfidence(const string& name1, const string& name2) {
         // Create PrecomputedFeatures from strings
-        PrecomputedFeatures features1;
-        features1.clientName = name1;
-        features1.processedName = preprocessName(name1);
-        features1.tokens = tokenizeAndSort(features1.processedName);
-        features1.tokenSet = unordered_set<string>(features1.tokens.begin(), features1.tokens.end());
-        features1.features = nameToFeatures(features1.processedName);
-
-        PrecomputedFeatures features2;
-        features2.clientName = name2;
-        features2.processedName = preprocessName(name2);
-        features2.tokens = tokenizeAndSort(features2.processedName);
-        features2.tokenSet = unordered_set<string>(features2.tokens.begin(), features2.tokens.end());
-        features2.features = nameToFeatures(features2.processedName);
-
-        return getMatchConfidence(features1, features2);
+        return getMatchConfidence(computeFeatures(name1), computeFeatures(name2));
     }
 
     double LacerteCrossReference::getMatchConfidence(const PrecomputedFeatures& features1,const PrecomputedFeatures& features2) {
@@ -314,15 +443,7 @@ namespace TaxReturnSystem {
             return 0.0;
         }
 
-        // Set token overlap for this specific comparison
-        double overlap = tokenOverlap(features1, features2);
-        auto f1 = features1.features;
-        auto f2 = features2.features;
-        f1(3) = overlap;
-        f2(3) = overlap;
-
-        auto combined = concatenateFeatures(f1, f2);
-        double raw_score = matcher_model(combined);
+        double raw_score = getModel()->score(pairFeatures(features1, features2));
 
         // Convert to probability using sigmoid
         return 1.0 / (1.0 + std::exp(-raw_score));
@@ -344,38 +465,48 @@ namespace TaxReturnSystem {
         return combined;
     }
 
+    // Definition of method to apply a passive-aggressive update to the published model; takes pair features and a +1/-1 label as parameters; returns void
+    void LacerteCrossReference::applyOnlineUpdate(const sample_type& sample, double label) {
+        // Caller holds modelUpdateMutex; readers keep using the old snapshot until the new one is stored
+        LinearModel updated = *getModel();
+        passiveAggressiveStep(updated, sample, label, learningParams.passiveAggressiveC);
+        atomic_store(&model, make_shared<const LinearModel>(move(updated)));
+    }
+
     // Definition of method to update model with feedback; takes names, match status, and confidence as parameters; returns void
     void LacerteCrossReference::updateModelWithFeedback(
             const string& name1, const string& name2,
             bool isCorrectMatch, double predictedConfidence,
             bool forceRetrain) {
         try {
-            forceRetrain = false;
-            cout << "\n=== Starting updateModelWithFeedback ===" << endl;
-            cout << "Input Parameters:" << endl;
-            cout << "  name1: " << name1 << endl;
-            cout << "  name2: " << name2 << endl;
-            cout << "  isCorrectMatch: " << isCorrectMatch << endl;
-            cout << "  predictedConfidence: " << predictedConfidence << endl;
-            cout << "  forceRetrain: " << (forceRetrain ? "yes" : "no") << endl;
-
-            // Skip database storage if it's a force retrain call
-            if (!forceRetrain) {
-                cout << "\nAttempting to store feedback in database..." << endl;
-                bool stored = database.storeFeedback(name1, name2, isCorrectMatch, predictedConfidence);
-                if (!stored) {
-                    cout << "Database storage failed!" << endl;
-                    throw runtime_error("Failed to store feedback in database");
+            if (forceRetrain) {
+                requestRetrain();
+                return;
+            }
+
+            if (!database.storeFeedback(name1, name2, isCorrectMatch, predictedConfidence)) {
+                throw runtime_error("Failed to store feedback in database");
+            }
+
+            // Learn from this pair immediately, in O(features)
+            if (!name1.empty() && !name2.empty()) {
+                sample_type sample = pairFeatures(computeFeatures(name1), computeFeatures(name2));
+
+                lock_guard<mutex> lock(modelUpdateMutex);
+                {
+                    lock_guard<mutex> dataLock(trainingDataMutex);
+                    training_data.push_back({name1, name2, isCorrectMatch});
                 }
-                cout << "Feedback stored successfully in database" << endl;
+                applyOnlineUpdate(sample, isCorrectMatch ? 1.0 : -1.0);
+            }
 
-                // Initialize metrics timestamp if this is the first prediction
-                cout << "\nUpdating metrics..." << endl;
-                cout << "Current total predictions: " << metrics.totalPredictions << endl;
+            bool needsRetrain;
+            {
+                lock_guard<mutex> lock(metricsMutex);
 
+                // Initialize metrics timestamp if this is the first prediction
                 if (metrics.totalPredictions == 0) {
                     metrics.lastUpdate = chrono::system_clock::now();
-                    cout << "Initialized metrics timestamp (first prediction)" << endl;
                 }
 
                 // Always increment total predictions for learning progress
@@ -383,13 +514,15 @@ namespace TaxReturnSystem {
 
                 // Only update accuracy and matches for model predictions (predictedConfidence > 0)
                 if (predictedConfidence > 0) {
-                    double predictedLabel = predictedConfidence > 0.7 ? 1.0 : -1.0;
-                    double actualLabel = isCorrectMatch ? 1.0 : -1.0;
-                    bool wasCorrectPrediction = predictedLabel == actualLabel;
-
                     // Count high confidence predictions for accuracy calculation
-                    if (predictedConfidence > 0.7) {  // Count all high confidence predictions
-                        metrics.totalHighConfidence++;  // Track total high confidence predictions
+                    if (predictedConfidence > 0.7) {
+                        metrics.totalHighConfidence++;
+
+                        recentOutcomes.push_back(isCorrectMatch);
+                        if (recentOutcomes.size() > learningParams.accuracyWindow) {
+                            recentOutcomes.pop_front();
+                        }
+                        outcomesSinceRetrain++;
                     }
 
                     // Update match statistics - only count as match if it was correct
@@ -398,7 +531,6 @@ namespace TaxReturnSystem {
                         metrics.correctMatches++;
                     }
 
-                    // Calculate accuracy after updating all counters
                     metrics.accuracy = metrics.totalHighConfidence > 0 ?
                                        (double)metrics.correctMatches / metrics.totalHighConfidence : 0.0;
                 }
@@ -410,271 +542,205 @@ namespace TaxReturnSystem {
                         metrics.recentMismatches.erase(metrics.recentMismatches.begin());
                     }
                 }
-            }
-
-            // Check if retraining is needed
-            cout << "\nChecking if retraining is needed..." << endl;
-            auto now = chrono::system_clock::now();
-            bool needsRetrain = forceRetrain ||  // Added forceRetrain condition
-                                metrics.recentMismatches.size() >= learningParams.minMismatchesForRetrain ||
-                                chrono::duration_cast<chrono::hours>(now - metrics.lastUpdate).count() >= learningParams.hoursBeforeRetrain ||
-                                metrics.accuracy < learningParams.retrainAccuracyThreshold;
-
-            cout << "Retrain check results:" << endl;
-            if (forceRetrain) cout << "  Force retrain requested" << endl;
-            cout << "  Recent mismatches: " << metrics.recentMismatches.size()
-                 << " (threshold: " << learningParams.minMismatchesForRetrain << ")" << endl;
-            cout << "  Hours since update: "
-                 << chrono::duration_cast<chrono::hours>(now - metrics.lastUpdate).count()
-                 << " (threshold: " << learningParams.hoursBeforeRetrain << ")" << endl;
-            cout << "  Current accuracy: " << metrics.accuracy
-                 << " (threshold: " << learningParams.retrainAccuracyThreshold << ")" << endl;
-            cout << "Needs retrain: " << (needsRetrain ? "yes" : "no") << endl;
 
-            if (needsRetrain) {
-                cout << "\nStarting model retraining..." << endl;
-                cout << "Exporting feedback to training file..." << endl;
-                database.exportFeedbackToTrainingFile("training_data.csv");
+                // Accuracy only calls for a retrain once a full window of predictions has been seen since the
+                // last one, so a low accuracy does not turn every feedback into a full retrain
+                bool accuracyDrifted = false;
+                if (recentOutcomes.size() == learningParams.accuracyWindow && outcomesSinceRetrain >= learningParams.accuracyWindow) {
+                    size_t correct = count(recentOutcomes.begin(), recentOutcomes.end(), true);
+                    accuracyDrifted = static_cast<double>(correct) / recentOutcomes.size() < learningParams.retrainAccuracyThreshold;
+                }
 
-                cout << "Training model..." << endl;
-                trainModel();
+                // Check if a full retrain is due
+                auto now = chrono::system_clock::now();
+                needsRetrain = metrics.recentMismatches.size() >= learningParams.minMismatchesForRetrain ||
+                               chrono::duration_cast<chrono::hours>(now - metrics.lastUpdate).count() >= learningParams.hoursBeforeRetrain ||
+                               accuracyDrifted;
 
-                metrics.lastUpdate = now;
-                metrics.recentMismatches.clear();
-                cout << "Model retraining completed" << endl;
+                if (needsRetrain) {
+                    metrics.lastUpdate = now;
+                    metrics.recentMismatches.clear();
+                    outcomesSinceRetrain = 0;
+                }
             }
 
-            cout << "=== updateModelWithFeedback completed successfully ===" << endl;
+            // The retrain runs in the background; this request returns as soon as the online update is published
+            if (needsRetrain) {
+                requestRetrain();
+            }
 
         } catch (const exception& e) {
-            cout << "\nERROR in updateModelWithFeedback: " << e.what() << endl;
+            cerr << "Error in updateModelWithFeedback: " << e.what() << endl;
             throw runtime_error(string("Error in updateModelWithFeedback: ") + e.what());
         }
     }
 
     // Definition of method to get model metrics; takes no parameters; returns ModelMetrics object
     LacerteCrossReference::ModelMetrics LacerteCrossReference::getModelMetrics() const {
+        lock_guard<mutex> lock(metricsMutex);
         return metrics;
     }
 
     // Definition of method to precompute database features; takes vector of projects parameter; returns vector of precomputed features
     vector<LacerteCrossReference::PrecomputedFeatures> LacerteCrossReference::precomputeDatabaseFeatures(
             const vector<Project>& projects) {
-        vector<PrecomputedFeatures> precomputed;
+        vector<const Project*> clients;
+        unordered_set<string> seenClients;
 
         for (const auto& project : projects) {
-            PrecomputedFeatures features;
-            features.clientName = project.getClient();
+            // Several projects share a client; the client only needs to be featurized once
+            if (seenClients.insert(project.getClient()).second) {
+                clients.push_back(&project);
+            }
+        }
+
+        vector<PrecomputedFeatures> precomputed(clients.size());
+        TaskExecutor::shared().parallelFor(0, clients.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                precomputed[i] = computeFeatures(clients[i]->getClient());
+            }
+        });
 
-            // Preprocess the name and compute features
-            string processedName = preprocessName(features.clientName);
-            features.features = nameToFeatures(processedName);
+        return precomputed;
+    }
 
-            // Store token information for faster matching
-            auto tokens = tokenizeAndSort(processedName);
+    // Definition of method to find matches, building a candidate index over precomputed; takes names and precomputed features as parameters; returns vector of MatchResults
+    vector<MatchResult> LacerteCrossReference::findMatches(
+            const vector<string>& lacerteNames,
+            const vector<PrecomputedFeatures>& precomputed) {
 
-            // Add to precomputed vector
-            precomputed.push_back(features);
+        // Build the candidate blocking index over the database names
+        CandidateIndex candidateIndex;
+        candidateIndex.reserve(precomputed.size());
+        for (const auto& features : precomputed) {
+            candidateIndex.add(features.processedName, features.tokens);
         }
+        candidateIndex.finalize();
 
-        return precomputed;
+        return findMatches(lacerteNames, precomputed, candidateIndex);
     }
 
+    // Definition of method to find the best database match for each Lacerte name; takes names, precomputed features and their candidate index, and optional progress counters as parameters; returns vector of MatchResults
     vector<MatchResult> LacerteCrossReference::findMatches(
             const vector<string>& lacerteNames,
-            const vector<PrecomputedFeatures>& precomputed) {
+            const vector<PrecomputedFeatures>& precomputed,
+            const CandidateIndex& candidateIndex,
+            MatchProgress* progress) {
 
         vector<MatchResult> results(lacerteNames.size());
-        mutex cout_mutex, rebalance_mutex;
         const double EARLY_EXIT_THRESHOLD = 0.95;
+        const size_t MATCH_GRAIN = 32; // Names per chunk; small enough to balance, large enough to amortize scheduling
 
-        // Create length-based buckets
-        unordered_map<size_t, vector<size_t>> lengthBuckets;
-        for (size_t idx = 0; idx < precomputed.size(); idx++) {
-            size_t lengthBucket = precomputed[idx].clientName.length() / 5;
-            lengthBuckets[lengthBucket].push_back(idx);
-        }
+        const size_t SCORE_BLOCK = 64; // Candidates scored per batch; early exit is checked between batches
 
-        const size_t num_threads = thread::hardware_concurrency();
-        vector<thread> threads;
-        const size_t initial_chunk_size = max(size_t(1), lacerteNames.size() / num_threads);
-
-        // Thread status tracking
-        struct ThreadStatus {
-            atomic<size_t> current_pos;
-            atomic<size_t> end_pos;
-            atomic<bool> is_working;
-            atomic<size_t> processed_count;
-            atomic<size_t> early_exits;
-            atomic<size_t> comparisons_made;
-            atomic<size_t> possible_comparisons;
-        };
-        vector<ThreadStatus> thread_status(num_threads);
-
-        // Initialize thread status
-        for (size_t t = 0; t < num_threads; ++t) {
-            size_t start = t * initial_chunk_size;
-            size_t end = (t == num_threads - 1) ? lacerteNames.size()
-                                                : min((t + 1) * initial_chunk_size, lacerteNames.size());
-            thread_status[t].current_pos.store(start);
-            thread_status[t].end_pos.store(end);
-            thread_status[t].is_working.store(true);
-            thread_status[t].processed_count.store(0);
-            thread_status[t].early_exits.store(0);
-            thread_status[t].comparisons_made.store(0);
-            thread_status[t].possible_comparisons.store(0);
-        }
+        atomic<size_t> comparisonsMade{0};
+        atomic<size_t> earlyExits{0};
 
-        for (size_t t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&, t]() {
-                size_t rebalance_attempts = 0;
-                const size_t MAX_REBALANCE_ATTEMPTS = 3;
-
-                while (thread_status[t].is_working.load()) {
-                    // Process current chunk
-                    while (thread_status[t].current_pos.load() < thread_status[t].end_pos.load()) {
-                        size_t i = thread_status[t].current_pos.fetch_add(1);
-                        if (i >= thread_status[t].end_pos.load()) break;
-
-                        const string& lacerteName = lacerteNames[i];
-                        double bestConfidence = 0.0;
-                        string bestMatch;
-
-                        // Get candidates from length buckets
-                        set<size_t> candidateIndices;
-                        size_t currentBucket = lacerteName.length() / 5;
-
-                        for (int bucketOffset = -1; bucketOffset <= 1; bucketOffset++) {
-                            size_t bucket = currentBucket + bucketOffset;
-                            if (lengthBuckets.find(bucket) != lengthBuckets.end()) {
-                                const auto& indices = lengthBuckets[bucket];
-                                candidateIndices.insert(indices.begin(), indices.end());
-                            }
-                        }
+        // Score the whole run with one model, even if feedback publishes a new one meanwhile
+        shared_ptr<const LinearModel> currentModel = getModel();
 
-                        thread_status[t].possible_comparisons.fetch_add(precomputed.size());
-                        thread_status[t].comparisons_made.fetch_add(candidateIndices.size());
+        TaskExecutor::shared().parallelFor(0, lacerteNames.size(), MATCH_GRAIN, [&](size_t begin, size_t end) {
+            // Marks are stamped per query, so one scratch per thread is safe to reuse across calls and indexes
+            thread_local CandidateIndex::QueryScratch scratch;
+            thread_local vector<uint32_t> candidateIndices;
+            thread_local vector<string> queryTokens;
+            thread_local CandidateBlock block;
+            thread_local vector<double> confidences;
 
-                        for (size_t idx : candidateIndices) {
-                            if (idx >= precomputed.size()) continue;
+            size_t chunkComparisons = 0;
+            size_t chunkEarlyExits = 0;
 
-                            double confidence = getMatchConfidence(lacerteName, precomputed[idx].clientName);
-                            if (confidence > bestConfidence) {
-                                bestConfidence = confidence;
-                                bestMatch = precomputed[idx].clientName;
+            for (size_t i = begin; i < end; i++) {
+                const string& lacerteName = lacerteNames[i];
+                double bestConfidence = 0.0;
+                string bestMatch;
 
-                                if (confidence >= EARLY_EXIT_THRESHOLD) {
-                                    thread_status[t].early_exits.fetch_add(1);
-                                    break;
-                                }
-                            }
-                        }
+                // Featurize the Lacerte name once and reuse it for every candidate
+                PrecomputedFeatures lacerteFeatures = computeFeatures(lacerteName);
 
-                        results[i] = {lacerteName, bestMatch, bestConfidence};
-                        size_t processed = thread_status[t].processed_count.fetch_add(1) + 1;
-
-                        // Progress reporting
-                        size_t chunk_size = thread_status[t].end_pos.load() - thread_status[t].current_pos.load();
-                        size_t report_interval = max(size_t(1), chunk_size / 20);
+                // Query with the name's tokens plus their equivalent terms
+                queryTokens = lacerteFeatures.tokens;
+                for (const string& token : lacerteFeatures.tokens) {
+                    auto equivalents = equivalentTerms.find(token);
+                    if (equivalents != equivalentTerms.end()) {
+                        queryTokens.insert(queryTokens.end(), equivalents->second.begin(), equivalents->second.end());
+                    }
+                }
 
-                        if (processed % report_interval == 0) {
-                            lock_guard<mutex> lock(cout_mutex);
-                            double progress = (100.0 * processed) / chunk_size;
-                            double comparison_reduction = 100.0 *
-                                                          (1.0 - (double)thread_status[t].comparisons_made.load() /
-                                                                 thread_status[t].possible_comparisons.load());
+                candidateIndex.query(lacerteFeatures.processedName, queryTokens, scratch, candidateIndices);
+                chunkComparisons += candidateIndices.size();
 
-                            cout << "Thread " << t << ": "
-                                 << processed << "/" << chunk_size
-                                 << " (" << fixed << setprecision(1) << progress << "%) "
-                                 << "Comparisons reduced by " << comparison_reduction << "%" << endl;
+                array<double, CandidateBlock::FEATURE_COUNT> queryFeatures;
+                for (size_t f = 0; f < queryFeatures.size(); f++) {
+                    queryFeatures[f] = lacerteFeatures.features(f);
+                }
+                BatchScorer scorer(currentModel->weights, currentModel->bias, queryFeatures);
+
+                // Fill a column-wise block of candidates, score it in one pass, then scan it in candidate order
+                bool exitedEarly = false;
+                for (size_t blockStart = 0; blockStart < candidateIndices.size() && !exitedEarly; blockStart += SCORE_BLOCK) {
+                    size_t blockSize = min(SCORE_BLOCK, candidateIndices.size() - blockStart);
+                    block.resize(blockSize);
+                    confidences.resize(blockSize);
+
+                    for (size_t k = 0; k < blockSize; k++) {
+                        const PrecomputedFeatures& candidate = precomputed[candidateIndices[blockStart + k]];
+                        for (size_t f = 0; f < CandidateBlock::FEATURE_COUNT; f++) {
+                            block.columns[f][k] = candidate.features(f);
                         }
+                        // Exact and empty names are decided without the model, as in getMatchConfidence
+                        bool decided = candidate.processedName == lacerteFeatures.processedName ||
+                                       candidate.processedName.empty() || lacerteFeatures.processedName.empty();
+                        block.columns[CandidateBlock::OVERLAP_COLUMN][k] = decided ? 0.0 : tokenOverlap(lacerteFeatures, candidate);
                     }
 
-                    // Check if should stop rebalancing
-                    if (rebalance_attempts >= MAX_REBALANCE_ATTEMPTS) {
-                        thread_status[t].is_working.store(false);
-                        break;
-                    }
+                    scorer.scoreConfidences(block, confidences.data());
 
-                    // Try to steal work
-                    {
-                        lock_guard<mutex> lock(rebalance_mutex);
-
-                        size_t max_remaining = 0;
-                        size_t target_thread = num_threads;
+                    for (size_t k = 0; k < blockSize; k++) {
+                        const PrecomputedFeatures& candidate = precomputed[candidateIndices[blockStart + k]];
+                        double confidence = confidences[k];
+                        if (candidate.processedName == lacerteFeatures.processedName) {
+                            confidence = 1.0;
+                        } else if (candidate.processedName.empty() || lacerteFeatures.processedName.empty()) {
+                            confidence = 0.0;
+                        }
 
-                        for (size_t other = 0; other < num_threads; ++other) {
-                            if (other == t) continue;
+                        if (confidence > bestConfidence) {
+                            bestConfidence = confidence;
+                            bestMatch = candidate.clientName;
 
-                            size_t remaining = thread_status[other].end_pos.load() -
-                                               thread_status[other].current_pos.load();
-                            if (remaining > 1 && thread_status[other].is_working.load()) {
-                                if (remaining > max_remaining) {
-                                    max_remaining = remaining;
-                                    target_thread = other;
-                                }
+                            if (confidence >= EARLY_EXIT_THRESHOLD) {
+                                chunkEarlyExits++;
+                                exitedEarly = true;
+                                break;
                             }
                         }
+                    }
+                }
 
-                        if (target_thread < num_threads && max_remaining > 1) {
-                            size_t steal_amount = max_remaining / 2;
-                            size_t target_end = thread_status[target_thread].end_pos.load();
-                            size_t new_start = target_end - steal_amount;
-
-                            thread_status[t].current_pos.store(new_start);
-                            thread_status[t].end_pos.store(target_end);
-                            thread_status[target_thread].end_pos.store(new_start);
-
-                            // Reset progress counters for new chunk
-                            thread_status[t].processed_count.store(0);
-                            thread_status[t].comparisons_made.store(0);
-                            thread_status[t].possible_comparisons.store(0);
-                            thread_status[t].early_exits.store(0);
-
-                            {
-                                lock_guard<mutex> lock(cout_mutex);
-                                cout << "Thread " << t << " received new chunk: "
-                                     << new_start << " to " << target_end
-                                     << " (stole " << steal_amount << " items from thread "
-                                     << target_thread << ")" << endl;
-                            }
-
-                            rebalance_attempts = 0;  // Reset after successful steal
-                            continue;
-                        }
+                results[i] = {lacerteName, bestMatch, bestConfidence};
 
-                        rebalance_attempts++;
-                        thread_status[t].is_working.store(false);
-                    }
+                if (progress) {
+                    progress->processed.fetch_add(1, memory_order_relaxed);
                 }
-            });
-        }
+            }
 
-        // Join threads and collect final metrics
-        for (auto& t : threads) {
-            if (t.joinable()) t.join();
-        }
+            comparisonsMade.fetch_add(chunkComparisons, memory_order_relaxed);
+            earlyExits.fetch_add(chunkEarlyExits, memory_order_relaxed);
+            if (progress) {
+                progress->comparisons.fetch_add(chunkComparisons, memory_order_relaxed);
+                progress->earlyExits.fetch_add(chunkEarlyExits, memory_order_relaxed);
+            }
+        });
 
         // Final summary
-        cout << "\nAll threads completed. Summary:" << endl;
-        size_t total_processed = 0;
-        size_t total_early_exits = 0;
-        size_t total_comparisons_saved = 0;
-        size_t total_possible = 0;
-
-        for (const auto& status : thread_status) {
-            total_processed += status.processed_count.load();
-            total_early_exits += status.early_exits.load();
-            total_comparisons_saved += status.possible_comparisons.load() - status.comparisons_made.load();
-            total_possible += status.possible_comparisons.load();
-        }
-
-        double overall_reduction = 100.0 * (double)total_comparisons_saved / total_possible;
-        cout << "\nTotal processed: " << total_processed << "/" << lacerteNames.size() << endl;
-        cout << "Total early exits: " << total_early_exits
-             << " (" << (100.0 * total_early_exits / total_processed) << "%)" << endl;
-        cout << "Overall comparison reduction: " << overall_reduction << "%" << endl;
+        size_t possibleComparisons = lacerteNames.size() * precomputed.size();
+        double overallReduction = possibleComparisons > 0 ?
+                                  100.0 * (1.0 - (double)comparisonsMade.load() / possibleComparisons) : 0.0;
+        cout << "\nTotal processed: " << lacerteNames.size() << endl;
+        cout << "Total early exits: " << earlyExits.load()
+             << " (" << (lacerteNames.empty() ? 0.0 : 100.0 * earlyExits.load() / lacerteNames.size()) << "%)" << endl;
+        cout << "Overall comparison reduction: " << overallReduction << "%" << endl;
 
         return results;
     }
@@ -694,27 +760,35 @@ namespace TaxReturnSystem {
         }
     }
 
-    // Definition of method to benchmark precompute performance; takes vector of projects parameter; returns void
-    void LacerteCrossReference::benchmarkPrecompute(const vector<Project>& projects) {
+    // Definition of method to benchmark cold precompute against a warm load from the feature cache; takes vector of projects and a FeatureStore as parameters; returns void
+    void LacerteCrossReference::benchmarkPrecompute(const vector<Project>& projects, FeatureStore& featureStore) {
         cout << "\n=== Running Precompute Benchmark ===" << endl;
 
-        auto startTime = chrono::high_resolution_clock::now();
-
         cout << "Starting precomputation for " << projects.size() << " projects..." << endl;
+        auto coldStart = chrono::high_resolution_clock::now();
         auto precomputed = precomputeDatabaseFeatures(projects);
+        auto coldDuration = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - coldStart);
 
-        auto endTime = chrono::high_resolution_clock::now();
-        auto duration = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+        // Warm start as the server does it: load and index the store's configured cache file
+        auto warmStart = chrono::high_resolution_clock::now();
+        bool cacheWorked = featureStore.load();
+        auto warmDuration = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - warmStart);
+        size_t loaded = cacheWorked ? featureStore.size() : 0;
 
-        double timeSeconds = duration.count() / 1000.0;
-        double itemsPerSecond = projects.size() / timeSeconds;
+        double coldSeconds = coldDuration.count() / 1000.0;
+        double warmSeconds = warmDuration.count() / 1000.0;
 
         cout << "\nBenchmark Results:" << endl;
         cout << "--------------------------------" << endl;
-        cout << "Total time: " << timeSeconds << " seconds" << endl;
-        cout << "Items processed: " << projects.size() << endl;
-        cout << "Processing speed: " << itemsPerSecond << " items/second" << endl;
-        cout << "Threads used: " << thread::hardware_concurrency() - 1 << endl;
+        cout << "Projects: " << projects.size() << ", distinct clients: " << precomputed.size() << endl;
+        cout << "Cold precompute: " << coldDuration.count() << " ms ("
+             << static_cast<long>(coldSeconds > 0 ? precomputed.size() / coldSeconds : 0.0) << " clients/second)" << endl;
+        if (cacheWorked) {
+            cout << "Warm load from cache: " << warmDuration.count() << " ms ("
+                 << static_cast<long>(warmSeconds > 0 ? loaded / warmSeconds : 0.0) << " clients/second)" << endl;
+        } else {
+            cout << "Warm load from cache: unavailable (cache file missing or stale)" << endl;
+        }
         cout << "--------------------------------" << endl;
     }
 
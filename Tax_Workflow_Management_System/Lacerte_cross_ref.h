@@ -3,19 +3,25 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <deque>
+#include <unordered_set>
 #include <algorithm>
 #include <dlib/svm.h>
 #include <chrono>
 #include "CSV_management.h"
+#include "candidate_index.h"
 #include <thread>
 #include <mutex>
 #include <atomic>
-#include <algorithm>
+#include <memory>
+#include <condition_variable>
 
 using namespace std;
 
 namespace TaxReturnSystem {
 
+    class FeatureStore;
+
     // Struct for storing match results between two systems
     struct MatchResult {
         std::string lacerteName; // Name from Lacerte system
@@ -23,6 +29,13 @@ namespace TaxReturnSystem {
         double confidence; // Confidence score of the match
     };
 
+    // Counters a caller can watch while findMatches runs
+    struct MatchProgress {
+        atomic<size_t> processed{0}; // Lacerte names matched so far
+        atomic<size_t> comparisons{0}; // Candidate pairs scored
+        atomic<size_t> earlyExits{0}; // Names that stopped at a near-certain match
+    };
+
     class LacerteCrossReference {
     public:
         // Type definitions for SVM implementation
@@ -39,10 +52,20 @@ namespace TaxReturnSystem {
             unordered_set<string> tokenSet;  // For faster lookups
         };
 
+        // Linear scoring model, score = weights . x + bias; published as an immutable snapshot
+        struct LinearModel {
+            vector<double> weights; // One weight per concatenated pair feature
+            double bias = 0.0; // Intercept
+            double score(const sample_type& sample) const; // Raw decision value for a pair
+        };
+
         // Constructor and main methods
-        LacerteCrossReference(ProjectsDatabase& db) : database(db) {} // Initialize the cross reference system
+        LacerteCrossReference(ProjectsDatabase& db) // Initialize the cross reference system
+            : database(db), model(make_shared<const LinearModel>()) { initializeEquivalentTerms(); }
+        ~LacerteCrossReference(); // Stops the background retraining thread
         void loadTrainingData(const string& filename); // Load training data from file
-        void trainModel(); // Train the SVM model
+        void trainModel(); // Train the SVM model on all training pairs and publish it
+        void requestRetrain(); // Schedule a full retrain on the background thread; returns immediately
         double getMatchConfidence(const string& name1, const string& name2); // Confidence score calculation
         double getMatchConfidence(const PrecomputedFeatures& features1, const PrecomputedFeatures& features2); // Confidence score calculation
         // Feature computation and model methods
@@ -50,9 +73,10 @@ namespace TaxReturnSystem {
         sample_type concatenateFeatures(const sample_type& f1, const sample_type& f2); // Combine two feature vectors
 
         // Pre-computation methods
+        PrecomputedFeatures computeFeatures(const string& name); // Preprocess, tokenize and featurize a name once
         vector<PrecomputedFeatures> precomputeDatabaseFeatures(const vector<Project>& projects); // Precompute features for database entries
 
-        // Online learning methods
+        // Online learning methods; applies a passive-aggressive update and may schedule a background retrain
         void updateModelWithFeedback(
                 const string& name1, const string& name2,
                 bool isCorrectMatch, double predictedConfidence,
@@ -82,7 +106,7 @@ namespace TaxReturnSystem {
             }
         };
 
-        ModelMetrics metrics; // Current model metrics
+        ModelMetrics metrics; // Current model metrics; guarded by metricsMutex
         ModelMetrics getModelMetrics() const; // Get copy of current metrics
 
         // Structure for indexed features to optimize matching
@@ -96,10 +120,14 @@ namespace TaxReturnSystem {
         // Add findMatches as a class method
         vector<MatchResult> findMatches(const vector<string>& lacerteNames,
                                         const vector<PrecomputedFeatures>& precomputed);
+        vector<MatchResult> findMatches(const vector<string>& lacerteNames,
+                                        const vector<PrecomputedFeatures>& precomputed,
+                                        const CandidateIndex& candidateIndex,
+                                        MatchProgress* progress = nullptr); // Match using an index already built over precomputed, optionally reporting progress
 
         bool testDatabaseAccess(); // Tests database connectivity by attempting to store test feedback data
 
-        void benchmarkPrecompute(const vector<Project>& projects); // Measures and reports precomputation performance for a set of projects
+        void benchmarkPrecompute(const vector<Project>& projects, FeatureStore& featureStore); // Measures cold precomputation against a warm load of the store's cache file
 
     private:
         ProjectsDatabase& database;  // Reference to the database
@@ -108,16 +136,25 @@ namespace TaxReturnSystem {
 
         // String processing methods
         string preprocessName(const string& name); // Clean and standardize input name
+        void preprocessName(const string& name, string& processed); // Same, reusing the capacity of processed
         vector<string> tokenizeAndSort(const string& name); // Split name into sorted tokens
         double tokenOverlap(const PrecomputedFeatures& features1,
-                            const PrecomputedFeatures& features2); // Calculate overlap between names
+                            const PrecomputedFeatures& features2) const; // Calculate overlap between names
 
         void initializeEquivalentTerms(); // Initialize map of equivalent terms
-        bool areTokensEquivalent(const string& token1, const string& token2); // Check if tokens are equivalent
-        int calculateLevenshteinDistance(const string& s1, const string& s2); // Calculate edit distance
+        bool isEquivalentTerm(const string& token1, const string& token2) const; // Check the equivalent terms map
+        bool areTokensEquivalent(const string& token1, const string& token2) const; // Check if tokens are equivalent
 
         // AI model components
-        dlib::decision_function<kernel_type> matcher_model; // SVM model for matching
+        shared_ptr<const LinearModel> model; // Current model; read with atomic_load and replaced with atomic_store
+        mutex modelUpdateMutex; // Serializes online updates and publishing of retrained models
+        mutable mutex metricsMutex; // Guards metrics and the retrain window below
+        deque<bool> recentOutcomes; // Whether each of the latest high-confidence predictions was correct
+        size_t outcomesSinceRetrain = 0; // High-confidence predictions recorded since the last retrain was scheduled
+
+        shared_ptr<const LinearModel> getModel() const { return atomic_load(&model); } // Current model snapshot
+        sample_type pairFeatures(const PrecomputedFeatures& features1, const PrecomputedFeatures& features2); // Concatenated features for a pair
+        void applyOnlineUpdate(const sample_type& sample, double label); // Passive-aggressive step towards label
 
         // Training data structure and storage
         struct TrainingPair {
@@ -125,7 +162,18 @@ namespace TaxReturnSystem {
             string system2_name; // Name from second system
             bool is_match; // Whether names match
         };
-        vector<TrainingPair> training_data; // Storage for training pairs
+        vector<TrainingPair> training_data; // Storage for training pairs; guarded by trainingDataMutex
+        uint64_t trainingDataGeneration = 0; // Bumped when loadTrainingData replaces training_data; guarded by trainingDataMutex
+        mutex trainingDataMutex; // Guards training_data and trainingDataGeneration
+        LinearModel trainLinearModel(const vector<TrainingPair>& pairs); // Fit the SVM on pairs and flatten it to a LinearModel
+
+        // Background retraining
+        thread retrainThread; // Started on the first retrain request
+        mutex retrainMutex; // Guards the flags below
+        condition_variable retrainCondition; // Wakes the retrain thread
+        bool retrainRequested = false; // A retrain is pending
+        bool stopRetraining = false; // Set by the destructor
+        void retrainLoop(); // Body of the retrain thread
         vector<vector<string>> readCSV(const string& filename); // Read training data from CSV
 
         // Online learning parameters
@@ -133,7 +181,10 @@ namespace TaxReturnSystem {
             int minMismatchesForRetrain = 50; // Minimum mismatches before retraining
             int hoursBeforeRetrain = 24; // Hours between retraining
             int maxRecentMismatches = 100; // Maximum stored mismatches
-            double retrainAccuracyThreshold = 0.95; // Accuracy threshold for retraining
+            double retrainAccuracyThreshold = 0.95; // Windowed accuracy below which a retrain is due
+            size_t accuracyWindow = 200; // High-confidence predictions in the windowed accuracy; at most one accuracy retrain per window
+            double passiveAggressiveC = 0.1; // Cap on the step size of one online update
+            string trainingFile = "training_data.csv"; // Feedback is appended here before a full retrain
         } learningParams;
     };
 
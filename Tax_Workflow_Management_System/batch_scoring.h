@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Candidate features for one query, stored column by column (structure of arrays)
+    struct CandidateBlock {
+        static constexpr size_t FEATURE_COUNT = 5; // Features per name
+        static constexpr size_t OVERLAP_COLUMN = 3; // Column holding the pair's token overlap instead of a name feature
+
+        array<vector<double>, FEATURE_COUNT> columns; // columns[f][i] is feature f of candidate i
+        size_t count = 0; // Candidates in the block
+
+        void resize(size_t candidates) { // Size every column; keeps capacity between queries
+            for (auto& column : columns) {
+                column.resize(candidates);
+            }
+            count = candidates;
+        }
+    };
+
+    // Linear model over concatenated pair features, with the query's half folded into a constant for one query
+    class BatchScorer {
+    private:
+        array<double, CandidateBlock::FEATURE_COUNT> candidateWeights{}; // Weight of each candidate column
+        double queryScore = 0.0; // Bias plus the query's contribution, shared by every candidate
+
+    public:
+        // weights holds the query's FEATURE_COUNT weights then the candidate's; missing weights count as zero
+        BatchScorer(const vector<double>& weights, double bias, const array<double, CandidateBlock::FEATURE_COUNT>& queryFeatures);
+
+        void scoreConfidences(const CandidateBlock& block, double* confidences) const; // Logistic of the raw score of every candidate
+    };
+
+} // namespace TaxReturnSystem
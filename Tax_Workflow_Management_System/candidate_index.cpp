@@ -0,0 +1,170 @@
+/**
+ * @file candidate_index.cpp
+ * @brief Implementation of the candidate blocking index for name matching
+ *
+ * This file contains implementations for:
+ * - Inverted token postings
+ * - MinHash signatures over character trigrams
+ * - LSH banding and candidate lookup
+ *
+ * A pair of names becomes a candidate if they share a token, or if any LSH
+ * band of their trigram signatures collides. With 16 bands of 2 rows, two
+ * names with trigram Jaccard similarity 0.5 collide with probability ~0.99,
+ * which catches typos and reordered words that share no exact token.
+ */
+
+#include "candidate_index.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // 64-bit finalizer used to derive independent hash functions from one base hash
+        inline uint64_t mix64(uint64_t x) {
+            x += 0x9E3779B97F4A7C15ULL;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            return x ^ (x >> 31);
+        }
+
+        // Fixed per-function seeds so signatures are stable between runs
+        const array<uint64_t, CandidateIndex::MINHASH_SIZE>& minHashSeeds() {
+            static const array<uint64_t, CandidateIndex::MINHASH_SIZE> seeds = [] {
+                array<uint64_t, CandidateIndex::MINHASH_SIZE> values{};
+                for (size_t i = 0; i < values.size(); i++) {
+                    values[i] = mix64(0x5DEECE66DULL + i);
+                }
+                return values;
+            }();
+            return seeds;
+        }
+
+        // Postings and buckets holding more than this fraction of the index are too common to narrow the search
+        const double MAX_POSTING_FRACTION = 0.01;
+        const size_t MIN_POSTING_CUTOFF = 256;
+
+    } // namespace
+
+// CANDIDATE INDEX CLASS METHODS:
+
+    // Definition of a method to compute the MinHash signature of a name's trigrams; takes a processed name as parameter; returns Signature
+    CandidateIndex::Signature CandidateIndex::computeSignature(const string& processedName) {
+        Signature signature;
+        signature.fill(numeric_limits<uint64_t>::max());
+
+        // Pad with spaces so short names and word boundaries still produce trigrams
+        string padded;
+        padded.reserve(processedName.size() + 2);
+        padded.push_back(' ');
+        padded.append(processedName);
+        padded.push_back(' ');
+
+        if (padded.size() < 3) {
+            return signature;
+        }
+
+        const auto& seeds = minHashSeeds();
+        for (size_t i = 0; i + 3 <= padded.size(); i++) {
+            uint64_t trigram = (static_cast<uint64_t>(static_cast<unsigned char>(padded[i])) << 16) |
+                               (static_cast<uint64_t>(static_cast<unsigned char>(padded[i + 1])) << 8) |
+                               static_cast<uint64_t>(static_cast<unsigned char>(padded[i + 2]));
+            for (int h = 0; h < MINHASH_SIZE; h++) {
+                signature[h] = min(signature[h], mix64(trigram ^ seeds[h]));
+            }
+        }
+
+        return signature;
+    }
+
+    // Definition of a method to combine one band of a signature into a bucket key; takes a Signature and band number as parameters; returns uint64_t
+    uint64_t CandidateIndex::bandKey(const Signature& signature, int band) {
+        uint64_t key = static_cast<uint64_t>(band);
+        for (int row = 0; row < MINHASH_ROWS; row++) {
+            key = mix64(key ^ signature[band * MINHASH_ROWS + row]);
+        }
+        return key;
+    }
+
+    // Definition of a method to size the hash tables for the expected number of entries; takes an entry count as parameter; returns void
+    void CandidateIndex::reserve(size_t entries) {
+        tokenPostings.reserve(entries);
+        for (auto& buckets : bandBuckets) {
+            buckets.reserve(entries);
+        }
+    }
+
+    // Definition of a method to index the next entry; takes a processed name and its tokens as parameters; returns void
+    void CandidateIndex::add(const string& processedName, const vector<string>& tokens) {
+        uint32_t entry = entryCount++;
+
+        for (size_t i = 0; i < tokens.size(); i++) {
+            // Tokens are sorted, so duplicates are adjacent
+            if (i > 0 && tokens[i] == tokens[i - 1]) continue;
+            tokenPostings[tokens[i]].push_back(entry);
+        }
+
+        if (processedName.empty()) {
+            return;
+        }
+
+        Signature signature = computeSignature(processedName);
+        for (int band = 0; band < MINHASH_BANDS; band++) {
+            bandBuckets[band][bandKey(signature, band)].push_back(entry);
+        }
+    }
+
+    // Definition of a method to fix the common-token cutoff; takes no parameters; returns void
+    void CandidateIndex::finalize() {
+        maxPostingSize = max(MIN_POSTING_CUTOFF, static_cast<size_t>(entryCount * MAX_POSTING_FRACTION));
+    }
+
+    // Definition of a method to collect candidate entries for a query name; takes a processed name, its tokens, scratch space and an output vector as parameters; returns void
+    void CandidateIndex::query(const string& processedName, const vector<string>& tokens,
+                               QueryScratch& scratch, vector<uint32_t>& candidates) const {
+        candidates.clear();
+
+        if (scratch.marks.size() < entryCount) {
+            scratch.marks.assign(entryCount, 0);
+            scratch.stamp = 0;
+        }
+        if (++scratch.stamp == 0) {
+            // Stamp wrapped around; clear old marks
+            fill(scratch.marks.begin(), scratch.marks.end(), 0);
+            scratch.stamp = 1;
+        }
+
+        auto collect = [&](const vector<uint32_t>& entries) {
+            for (uint32_t entry : entries) {
+                if (scratch.marks[entry] != scratch.stamp) {
+                    scratch.marks[entry] = scratch.stamp;
+                    candidates.push_back(entry);
+                }
+            }
+        };
+
+        size_t cutoff = maxPostingSize ? maxPostingSize : numeric_limits<size_t>::max();
+        for (const string& token : tokens) {
+            auto it = tokenPostings.find(token);
+            if (it != tokenPostings.end() && it->second.size() <= cutoff) {
+                collect(it->second);
+            }
+        }
+
+        if (!processedName.empty()) {
+            Signature signature = computeSignature(processedName);
+            for (int band = 0; band < MINHASH_BANDS; band++) {
+                auto it = bandBuckets[band].find(bandKey(signature, band));
+                if (it != bandBuckets[band].end() && it->second.size() <= cutoff) {
+                    collect(it->second);
+                }
+            }
+        }
+
+        sort(candidates.begin(), candidates.end());
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Blocking index over preprocessed client names: returns the few entries worth scoring for a query name
+    class CandidateIndex {
+    public:
+        static constexpr int MINHASH_BANDS = 16; // Number of LSH bands
+        static constexpr int MINHASH_ROWS = 2; // MinHash values per band
+        static constexpr int MINHASH_SIZE = MINHASH_BANDS * MINHASH_ROWS; // MinHash signature length
+
+        using Signature = array<uint64_t, MINHASH_SIZE>;
+
+        // Per-thread scratch space for deduplicating candidates without allocating
+        struct QueryScratch {
+            vector<uint32_t> marks; // Stamp of the last query that returned each entry
+            uint32_t stamp = 0; // Current query stamp
+        };
+
+    private:
+        uint32_t entryCount = 0; // Number of indexed entries
+        size_t maxPostingSize = 0; // Postings longer than this are too common to narrow the search
+
+        unordered_map<string, vector<uint32_t>> tokenPostings; // Token to entries containing it
+        array<unordered_map<uint64_t, vector<uint32_t>>, MINHASH_BANDS> bandBuckets; // LSH band hash to entries
+
+        static uint64_t bandKey(const Signature& signature, int band); // Combine one band of a signature into a bucket key
+
+    public:
+        static Signature computeSignature(const string& processedName); // MinHash of the character trigrams of a name
+
+        void reserve(size_t entries); // Size the hash tables for the expected number of entries
+        void add(const string& processedName, const vector<string>& tokens); // Index the next entry; entries are numbered in insertion order
+        void finalize(); // Fix the common-token cutoff once all entries are added
+        size_t size() const { return entryCount; } // Number of indexed entries
+
+        // Collect entries sharing a token or an LSH bucket with the query, in ascending order
+        void query(const string& processedName, const vector<string>& tokens,
+                   QueryScratch& scratch, vector<uint32_t>& candidates) const;
+    };
+
+} // namespace TaxReturnSystem
@@ -14,6 +14,8 @@ namespace TaxReturnSystem {
     constexpr int RESET_ATTEMPT_WINDOW = 3600; // Window for reset attempts (1 hour)
     constexpr int PASSWORD_CHANGE_COOLDOWN = 86400; // Cooldown between password changes (24 hours)
     constexpr int USERNAME_RECOVERY_COOLDOWN = 86400; // Cooldown between username recoveries (24 hours)
+    constexpr int PASSWORD_HASHING_THREADS = 4; // Threads running bcrypt hashing and verification
+    constexpr int USER_CACHE_CAPACITY = 1024; // User records kept in memory by UserDatabase
 
     // Password and username requirements
     constexpr int MIN_PASSWORD_LENGTH = 8; // Minimum password length
@@ -30,6 +32,25 @@ namespace TaxReturnSystem {
     // JWT configuration
     constexpr const char *JWT_ISSUER = "auth_service"; // JWT issuer identifier
 
+    // Email outbox settings
+    constexpr const char *EMAIL_OUTBOX_PATH = "email_outbox.db"; // SQLite file holding queued emails
+    constexpr const char *EMAIL_LOG_PATH = "email_log.txt"; // File the local transport writes delivered emails to
+    constexpr int EMAIL_SENDER_THREADS = 2; // Threads delivering queued emails
+    constexpr int EMAIL_BATCH_SIZE = 50; // Most emails delivered to one recipient at a time
+    constexpr int EMAIL_MAX_ATTEMPTS = 5; // Delivery attempts before an email is marked failed
+    constexpr int EMAIL_RETRY_DELAY = 30; // Delay before the first retry in seconds; doubles per attempt
+    constexpr int EMAIL_MAX_RETRY_DELAY = 3600; // Longest delay between retries (1 hour)
+
+    // SQLite connection settings
+    constexpr int SQLITE_READER_CONNECTIONS = 4; // Read-only connections per database pool
+    constexpr int SQLITE_BUSY_TIMEOUT_MS = 5000; // How long a connection waits for a lock before failing
+    constexpr long long SQLITE_MMAP_SIZE = 268435456; // Bytes of the database file memory-mapped per connection (256 MB)
+    constexpr int SQLITE_CACHE_SIZE_KB = 16384; // Page cache per connection in KiB
+    constexpr size_t PROJECTS_ANALYZE_MIN_ROWS = 500; // Rows an import has to change before planner statistics are refreshed
+    constexpr size_t PROJECT_SEARCH_DEFAULT_LIMIT = 50; // Search results per page when the caller gives no limit
+    constexpr size_t PROJECT_SEARCH_MAX_LIMIT = 500; // Largest page a search may request
+    constexpr size_t PROJECT_SEARCH_MIN_INDEXED_LENGTH = 3; // Shorter search terms have no trigrams and fall back to LIKE
+
     // CSV column configuration
     static constexpr int EXPECTED_COLUMN_COUNT = 9; // Expected number of columns in CSV
 
@@ -53,13 +74,20 @@ namespace TaxReturnSystem {
     const int FILTER_BY_DUE_DATE = 6; // Filter by due date option
     const int FILTER_BY_NEXT_TASK = 7; // Filter by next task option
 
-    // Task status constants
-    const string TASK_BILLED = "Billed"; // Status for billed tasks
-    const string TASK_TAX_RETURN_FILED = "Tax Return Filed"; // Status for filed returns
-    const string TASK_EFILE_SENT = "E-file Sent to Client"; // Status for sent e-files
-    const string TASK_EFILE_SIGNED = "E-file Signed by Client"; // Status for signed e-files
-    const string TASK_CORRECTIONS_CLEARED = "Corrections Cleared"; // Status for cleared corrections
-    const string TASK_PARTNER_REVIEWED = "Partner Reviewed"; // Status for partner review
+    // Task status constants, in workflow order; TaskStatus codes are assigned from these strings
+    constexpr const char *TASK_SIGNED_ENGAGEMENT_LETTER = "Signed Engagement Letter"; // Status for signed engagement letters
+    constexpr const char *TASK_SENT_OPEN_ITEMS_EXTENSION = "Sent Open Items - Extension"; // Status for open items sent at extension
+    constexpr const char *TASK_INFORMATION_ENTERED = "Information Entered"; // Status for entered information
+    constexpr const char *TASK_SENT_OPEN_ITEMS_FINAL = "Sent Open Items - Final Preparation"; // Status for open items sent at final preparation
+    constexpr const char *TASK_FINAL_INFORMATION_ENTERED = "Final Information Entered"; // Status for entered final information
+    constexpr const char *TASK_READY_FOR_MANAGER_REVIEW = "Ready for Manager Review"; // Status for returns ready for manager review
+    constexpr const char *TASK_MANAGER_APPROVED = "Manager Approved - Ready for Partner Review"; // Status for manager-approved returns
+    constexpr const char *TASK_PARTNER_REVIEWED = "Partner Reviewed"; // Status for partner review
+    constexpr const char *TASK_CORRECTIONS_CLEARED = "Corrections Cleared"; // Status for cleared corrections
+    constexpr const char *TASK_EFILE_SENT = "E-file Sent to Client"; // Status for sent e-files
+    constexpr const char *TASK_EFILE_SIGNED = "E-file Signed by Client"; // Status for signed e-files
+    constexpr const char *TASK_TAX_RETURN_FILED = "Tax Return Filed"; // Status for filed returns
+    constexpr const char *TASK_BILLED = "Billed"; // Status for billed tasks
 
     // System configuration
     const vector<string> billingPartners = {"MOTI", "EFROIM", "JEFF", "JACOB"}; // List of billing partners
@@ -0,0 +1,261 @@
+/**
+ * @file cross_reference_jobs.cpp
+ * @brief Implementation of asynchronous cross-reference jobs
+ *
+ * This file contains implementations for:
+ * - CrossReferenceJob progress and error reporting
+ * - The CrossReferenceJobManager worker pool
+ * - Per-job results files
+ *
+ * A submitted upload is parsed, matched and written entirely on a worker
+ * thread. Request handlers only enqueue jobs and read their atomic
+ * counters, so a large file never holds a web server thread.
+ */
+
+#include "cross_reference_jobs.h"
+#include "csv_reader.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Quote a results field, doubling embedded quotes
+        string quoteResultField(const string& field) {
+            string quoted = "\"";
+            for (char c : field) {
+                if (c == '"') quoted += '"';
+                quoted += c;
+            }
+            quoted += '"';
+            return quoted;
+        }
+
+    } // namespace
+
+    // Definition of a function to name a job state; takes a JobState as parameter; returns string
+    string jobStateToString(JobState state) {
+        switch (state) {
+            case JobState::Queued: return "queued";
+            case JobState::Running: return "running";
+            case JobState::Completed: return "completed";
+            case JobState::Failed: return "failed";
+        }
+        return "unknown";
+    }
+
+// CROSS REFERENCE JOB STRUCT METHODS:
+
+    // Definition of a method to get the failure message; takes no parameters; returns string
+    string CrossReferenceJob::getError() const {
+        lock_guard<mutex> lock(errorMutex);
+        return error;
+    }
+
+    // Definition of a method to record a failure message; takes a message as parameter; returns void
+    void CrossReferenceJob::setError(const string& message) {
+        lock_guard<mutex> lock(errorMutex);
+        error = message;
+    }
+
+// CROSS REFERENCE JOB MANAGER CLASS METHODS:
+
+    // Definition of the constructor; takes the matcher, feature store, project manager and pool limits as parameters
+    CrossReferenceJobManager::CrossReferenceJobManager(LacerteCrossReference& matcher, FeatureStore& featureStore,
+                                                       ProjectManager& projectManager, size_t workerCount,
+                                                       const string& resultsDirectory,
+                                                       size_t maxQueuedJobs, size_t maxRetainedJobs)
+            : matcher(matcher), featureStore(featureStore), projectManager(projectManager),
+              resultsDirectory(resultsDirectory), maxQueuedJobs(maxQueuedJobs),
+              maxRetainedJobs(max(size_t(1), maxRetainedJobs)) {
+        error_code ec;
+        filesystem::create_directories(resultsDirectory, ec);
+        if (ec) {
+            throw runtime_error("Failed to create results directory " + resultsDirectory + ": " + ec.message());
+        }
+
+        workerCount = max(size_t(1), workerCount);
+        for (size_t i = 0; i < workerCount; i++) {
+            workers.emplace_back(&CrossReferenceJobManager::workerLoop, this);
+        }
+    }
+
+    // Definition of the destructor; stops and joins the workers
+    CrossReferenceJobManager::~CrossReferenceJobManager() {
+        {
+            lock_guard<mutex> lock(jobsMutex);
+            stopping = true;
+        }
+        jobsCondition.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    // Definition of a method to generate a job id; takes no parameters; returns string
+    string CrossReferenceJobManager::generateJobId() {
+        static mutex generatorMutex;
+        static mt19937_64 generator(random_device{}());
+
+        lock_guard<mutex> lock(generatorMutex);
+        stringstream ss;
+        ss << hex << setfill('0') << setw(16) << generator() << setw(16) << generator();
+        return ss.str();
+    }
+
+    // Definition of a method to queue an uploaded file; takes the file content and submitting username as parameters; returns the job id
+    string CrossReferenceJobManager::submit(string fileContent, string owner) {
+        auto job = make_shared<CrossReferenceJob>();
+        job->id = generateJobId();
+        job->owner = move(owner);
+        job->resultsPath = (filesystem::path(resultsDirectory) / (job->id + ".csv")).string();
+        job->submittedAt = chrono::system_clock::now();
+        job->fileContent = move(fileContent);
+
+        {
+            lock_guard<mutex> lock(jobsMutex);
+            if (queue.size() >= maxQueuedJobs) {
+                throw JobQueueFullError("Too many cross-reference jobs are waiting; try again later");
+            }
+            jobs[job->id] = job;
+            queue.push_back(job);
+        }
+        jobsCondition.notify_one();
+
+        return job->id;
+    }
+
+    // Definition of a method to look up a job; takes a job id as parameter; returns shared pointer to the job or nullptr
+    shared_ptr<const CrossReferenceJob> CrossReferenceJobManager::getJob(const string& id) const {
+        lock_guard<mutex> lock(jobsMutex);
+        auto it = jobs.find(id);
+        return it != jobs.end() ? it->second : nullptr;
+    }
+
+    // Definition of a method run by each worker thread; takes no parameters; returns void
+    void CrossReferenceJobManager::workerLoop() {
+        while (true) {
+            shared_ptr<CrossReferenceJob> job;
+            {
+                unique_lock<mutex> lock(jobsMutex);
+                jobsCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = queue.front();
+                queue.pop_front();
+            }
+
+            runJob(*job);
+            retireFinishedJob(job->id);
+        }
+    }
+
+    // Definition of a method to process one job; takes a job as parameter; returns void
+    void CrossReferenceJobManager::runJob(CrossReferenceJob& job) {
+        job.state.store(JobState::Running);
+        auto start = chrono::steady_clock::now();
+
+        try {
+            // Collect the names from the first column, skipping the header
+            vector<string> lacerteNames;
+            {
+                CSVReader reader = CSVReader::fromString(job.fileContent);
+                reader.readRow();
+                while (reader.readRow()) {
+                    string_view lacerteName = reader.getFields()[0];
+                    if (!lacerteName.empty()) {
+                        lacerteNames.emplace_back(lacerteName);
+                    }
+                }
+            }
+            string().swap(job.fileContent);
+            job.total.store(lacerteNames.size());
+
+            // Client features for the current projects, featurizing only new clients
+            auto featureSet = featureStore.getFeatures(*projectManager.getSnapshot());
+
+            vector<MatchResult> results = matcher.findMatches(lacerteNames, featureSet->features,
+                                                              featureSet->candidateIndex, &job.progress);
+
+            job.matchesFound.store(writeResults(job.resultsPath, results));
+            job.processingTimeMs.store(chrono::duration_cast<chrono::milliseconds>(
+                    chrono::steady_clock::now() - start).count());
+            job.state.store(JobState::Completed);
+
+            cout << "Cross-reference job " << job.id << " completed: " << lacerteNames.size()
+                 << " names, " << job.matchesFound.load() << " matches, "
+                 << job.processingTimeMs.load() << " ms" << endl;
+
+        } catch (const exception& e) {
+            cerr << "Cross-reference job " << job.id << " failed: " << e.what() << endl;
+            job.setError(e.what());
+            job.processingTimeMs.store(chrono::duration_cast<chrono::milliseconds>(
+                    chrono::steady_clock::now() - start).count());
+            job.state.store(JobState::Failed);
+        }
+    }
+
+    // Definition of a method to write a job's results CSV; takes a path and the match results as parameters; returns number of matches
+    size_t CrossReferenceJobManager::writeResults(const string& path, const vector<MatchResult>& results) {
+        ofstream outFile(path);
+        if (!outFile.is_open()) {
+            throw runtime_error("Unable to open results file " + path);
+        }
+
+        outFile << "Lacerte Name,Database Match,Confidence Score,Notes\n";
+
+        size_t matchesFound = 0;
+        for (const auto& match : results) {
+            outFile << quoteResultField(match.lacerteName) << ",";
+            if (match.confidence > MATCH_THRESHOLD) {
+                outFile << quoteResultField(match.databaseMatch) << ",";
+                matchesFound++;
+            } else {
+                outFile << "\"No Match\",";
+            }
+            outFile << fixed << setprecision(4) << match.confidence << ",";
+            if (match.confidence <= MATCH_THRESHOLD) {
+                outFile << quoteResultField("Closest match: " + match.databaseMatch);
+            }
+            outFile << "\n";
+        }
+
+        outFile.close();
+        if (!outFile) {
+            throw runtime_error("Failed to write results file " + path);
+        }
+        return matchesFound;
+    }
+
+    // Definition of a method to retire a finished job; takes a job id as parameter; returns void
+    void CrossReferenceJobManager::retireFinishedJob(const string& id) {
+        string droppedPath;
+        {
+            lock_guard<mutex> lock(jobsMutex);
+            finishedOrder.push_back(id);
+            if (finishedOrder.size() <= maxRetainedJobs) {
+                return;
+            }
+
+            auto oldest = jobs.find(finishedOrder.front());
+            if (oldest != jobs.end()) {
+                droppedPath = oldest->second->resultsPath;
+                jobs.erase(oldest);
+            }
+            finishedOrder.pop_front();
+        }
+
+        if (!droppedPath.empty()) {
+            error_code ec;
+            filesystem::remove(droppedPath, ec);
+        }
+    }
+
+} // namespace TaxReturnSystem
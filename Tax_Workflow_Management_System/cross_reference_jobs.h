@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <condition_variable>
+#include <unordered_map>
+#include "Lacerte_cross_ref.h"
+#include "feature_store.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Lifecycle of a cross-reference job
+    enum class JobState {
+        Queued,
+        Running,
+        Completed,
+        Failed
+    };
+
+    string jobStateToString(JobState state); // Lowercase name used in progress events
+
+    // Thrown by submit when the queue already holds the maximum number of waiting jobs
+    class JobQueueFullError : public runtime_error {
+    public:
+        using runtime_error::runtime_error;
+    };
+
+    // One uploaded Lacerte file, its live progress and where its results are written
+    struct CrossReferenceJob {
+        string id; // Random, unguessable job id
+        string owner; // Username of the user who submitted the job; only they may read its progress and results
+        string resultsPath; // Results CSV for this job only
+        chrono::system_clock::time_point submittedAt; // Time the job was accepted
+
+        atomic<JobState> state{JobState::Queued}; // Current state
+        atomic<size_t> total{0}; // Lacerte names in the upload, known once it is parsed
+        MatchProgress progress; // Updated by the matching threads
+        atomic<size_t> matchesFound{0}; // Results above the match threshold, set on completion
+        atomic<long long> processingTimeMs{0}; // Parse, match and write time, set on completion
+
+        string getError() const; // Failure message; empty unless state is Failed
+        void setError(const string& message); // Record a failure message
+
+    private:
+        friend class CrossReferenceJobManager;
+        string fileContent; // Uploaded CSV; only touched by the worker and released once parsed
+        mutable mutex errorMutex; // Guards error
+        string error; // Failure message
+    };
+
+    // Runs cross-reference jobs on a fixed set of worker threads so uploads never block request handlers
+    class CrossReferenceJobManager {
+    public:
+        static constexpr double MATCH_THRESHOLD = 0.7; // Confidence above which a result counts as a match
+
+    private:
+        LacerteCrossReference& matcher; // Scores Lacerte names against clients
+        FeatureStore& featureStore; // Client features for the current snapshot
+        ProjectManager& projectManager; // Source of the current snapshot
+        string resultsDirectory; // Directory holding one results CSV per job
+        size_t maxQueuedJobs; // Submissions beyond this many waiting jobs are rejected
+        size_t maxRetainedJobs; // Finished jobs kept for progress and download before the oldest is dropped
+
+        mutable mutex jobsMutex; // Guards the fields below
+        condition_variable jobsCondition; // Wakes workers when a job is queued or on shutdown
+        deque<shared_ptr<CrossReferenceJob>> queue; // Jobs waiting for a worker
+        unordered_map<string, shared_ptr<CrossReferenceJob>> jobs; // All retained jobs by id
+        deque<string> finishedOrder; // Finished job ids, oldest first
+        bool stopping = false; // Set by the destructor
+
+        vector<thread> workers; // Worker pool
+
+        void workerLoop(); // Body of each worker thread
+        void runJob(CrossReferenceJob& job); // Parse, match and write one job
+        void retireFinishedJob(const string& id); // Record a finished job and drop the oldest beyond the limit
+        static string generateJobId(); // Random 128-bit hex id
+        static size_t writeResults(const string& path, const vector<MatchResult>& results); // Write results CSV; returns matches found
+
+    public:
+        CrossReferenceJobManager(LacerteCrossReference& matcher, FeatureStore& featureStore,
+                                 ProjectManager& projectManager, size_t workerCount = 2,
+                                 const string& resultsDirectory = "cross_reference_results",
+                                 size_t maxQueuedJobs = 16, size_t maxRetainedJobs = 64); // Constructor; starts the workers
+        ~CrossReferenceJobManager(); // Stops the workers; queued jobs are dropped
+
+        CrossReferenceJobManager(const CrossReferenceJobManager&) = delete;
+        CrossReferenceJobManager& operator=(const CrossReferenceJobManager&) = delete;
+
+        string submit(string fileContent, string owner); // Queue a user's uploaded Lacerte CSV; returns the job id; throws JobQueueFullError if the queue is full
+        shared_ptr<const CrossReferenceJob> getJob(const string& id) const; // Look up a job; nullptr if unknown or dropped
+    };
+
+} // namespace TaxReturnSystem
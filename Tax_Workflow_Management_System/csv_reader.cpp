@@ -0,0 +1,303 @@
+/**
+ * @file csv_reader.cpp
+ * @brief Implementation of the shared streaming CSV tokenizer
+ *
+ * This file contains implementations for:
+ * - Block reading from disk and parsing from memory
+ * - RFC 4180 quoting: embedded commas, newlines and "" escapes
+ * - A vectorized scan for field delimiters with a scalar fallback
+ *
+ * Unquoted fields and quoted fields without escapes are returned as views
+ * straight into the input; only fields containing "" are copied.
+ */
+
+#include "csv_reader.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSV_READER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define CSV_READER_NEON 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Check whether a byte ends an unquoted field
+        inline bool isFieldEnd(char c) {
+            return c == ',' || c == '\n' || c == '\r';
+        }
+
+#if CSV_READER_SSE2
+        // Index of the lowest set bit of a non-zero mask
+        inline int lowestSetBit(unsigned mask) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+#endif
+
+        // Find the first comma, CR or LF in [p, end), 16 bytes at a time where supported
+        const char* findFieldEnd(const char* p, const char* end) {
+#if CSV_READER_SSE2
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i lineFeed = _mm_set1_epi8('\n');
+            const __m128i carriageReturn = _mm_set1_epi8('\r');
+
+            while (end - p >= 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, comma),
+                                                         _mm_cmpeq_epi8(chunk, lineFeed)),
+                                            _mm_cmpeq_epi8(chunk, carriageReturn));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+                if (mask != 0) {
+                    return p + lowestSetBit(mask);
+                }
+                p += 16;
+            }
+#elif CSV_READER_NEON
+            const uint8x16_t comma = vdupq_n_u8(',');
+            const uint8x16_t lineFeed = vdupq_n_u8('\n');
+            const uint8x16_t carriageReturn = vdupq_n_u8('\r');
+
+            while (end - p >= 16) {
+                uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+                uint8x16_t hits = vorrq_u8(vorrq_u8(vceqq_u8(chunk, comma), vceqq_u8(chunk, lineFeed)),
+                                           vceqq_u8(chunk, carriageReturn));
+                if (vmaxvq_u8(hits) != 0) {
+                    break; // The scalar loop below finds the exact position within this block
+                }
+                p += 16;
+            }
+#endif
+            while (p < end && !isFieldEnd(*p)) {
+                p++;
+            }
+            return p;
+        }
+
+        // Find the next double quote in [p, end); memchr is vectorized by the C library
+        inline const char* findQuote(const char* p, const char* end) {
+            const void* hit = memchr(p, '"', static_cast<size_t>(end - p));
+            return hit ? static_cast<const char*>(hit) : end;
+        }
+
+    } // namespace
+
+// CSV READER CLASS METHODS:
+
+    // Definition of a factory method to read CSV rows from a file; takes a filename as parameter; returns CSVReader
+    CSVReader CSVReader::fromFile(const string& filename) {
+        CSVReader reader;
+        reader.file.open(filename, ios::binary);
+        if (!reader.file.is_open()) {
+            throw runtime_error("Error: Could not open file " + filename);
+        }
+
+        reader.readingFile = true;
+        reader.refill();
+        reader.skipByteOrderMark();
+        return reader;
+    }
+
+    // Definition of a factory method to read CSV rows from memory; takes a string_view as parameter; returns CSVReader
+    CSVReader CSVReader::fromString(string_view data) {
+        CSVReader reader;
+        reader.content = data;
+        reader.limit = data.size();
+        reader.endOfInput = true;
+        reader.skipByteOrderMark();
+        return reader;
+    }
+
+    // Definition of a method to skip a UTF-8 byte order mark; takes no parameters; returns void
+    void CSVReader::skipByteOrderMark() {
+        if (limit - position >= 3 && memcmp(base() + position, "\xEF\xBB\xBF", 3) == 0) {
+            position += 3;
+        }
+    }
+
+    // Definition of a method to discard parsed bytes and append the next block from disk; takes no parameters; returns bool
+    bool CSVReader::refill() {
+        if (!readingFile || endOfInput) {
+            return false;
+        }
+
+        // Keep only the row that is still being parsed
+        buffer.erase(0, position);
+        limit -= position;
+        position = 0;
+
+        size_t oldSize = buffer.size();
+        buffer.resize(oldSize + BLOCK_SIZE);
+        file.read(&buffer[oldSize], BLOCK_SIZE);
+        size_t bytesRead = static_cast<size_t>(file.gcount());
+        buffer.resize(oldSize + bytesRead);
+        limit = buffer.size();
+
+        if (bytesRead == 0) {
+            endOfInput = true;
+        }
+        return bytesRead > 0;
+    }
+
+    // Definition of a method to get a scratch string for an unescaped field; takes no parameters; returns string reference
+    string& CSVReader::nextUnescaped() {
+        if (unescapedUsed == unescaped.size()) {
+            unescaped.emplace_back();
+        }
+        string& scratch = unescaped[unescapedUsed++];
+        scratch.clear();
+        return scratch;
+    }
+
+    // Definition of a method to tokenize one row; takes the window bounds and an output row end as parameters; returns RowStatus
+    CSVReader::RowStatus CSVReader::parseRow(const char* begin, const char* end, const char*& rowEnd) {
+        fields.clear();
+        unescapedUsed = 0;
+
+        if (begin == end) {
+            return endOfInput ? RowStatus::EndOfInput : RowStatus::Incomplete;
+        }
+
+        const char* p = begin;
+
+        while (true) {
+            if (p < end && *p == '"') {
+                // Quoted field: runs to the next quote that is not part of a "" pair
+                const char* start = p + 1;
+                const char* q = start;
+                bool hasEscapes = false;
+
+                while (true) {
+                    q = findQuote(q, end);
+                    if (q == end) {
+                        if (!endOfInput) {
+                            return RowStatus::Incomplete;
+                        }
+                        break; // Unterminated quote: take the rest of the input
+                    }
+                    if (q + 1 == end && !endOfInput) {
+                        return RowStatus::Incomplete; // Cannot tell yet whether this quote is doubled
+                    }
+                    if (q + 1 < end && q[1] == '"') {
+                        hasEscapes = true;
+                        q += 2;
+                        continue;
+                    }
+                    break;
+                }
+
+                const char* closing = q;
+                p = (q < end) ? q + 1 : end;
+
+                // Tolerate stray characters between the closing quote and the delimiter
+                const char* trailingEnd = findFieldEnd(p, end);
+                if (trailingEnd == end && !endOfInput) {
+                    return RowStatus::Incomplete;
+                }
+
+                if (!hasEscapes && trailingEnd == p) {
+                    fields.emplace_back(start, static_cast<size_t>(closing - start));
+                } else {
+                    string& value = nextUnescaped();
+                    value.reserve(static_cast<size_t>(trailingEnd - start));
+                    for (const char* c = start; c < closing; c++) {
+                        value.push_back(*c);
+                        if (*c == '"') {
+                            c++; // Skip the second quote of a "" pair
+                        }
+                    }
+                    value.append(p, trailingEnd);
+                    fields.emplace_back(value);
+                }
+                p = trailingEnd;
+            } else {
+                const char* fieldEnd = findFieldEnd(p, end);
+                if (fieldEnd == end && !endOfInput) {
+                    return RowStatus::Incomplete;
+                }
+                fields.emplace_back(p, static_cast<size_t>(fieldEnd - p));
+                p = fieldEnd;
+            }
+
+            if (p == end) {
+                rowEnd = p;
+                return RowStatus::Complete;
+            }
+            if (*p == ',') {
+                p++;
+                continue;
+            }
+
+            // Line break: accept LF, CRLF and a lone CR
+            if (*p == '\r') {
+                if (p + 1 == end && !endOfInput) {
+                    return RowStatus::Incomplete;
+                }
+                p++;
+                if (p < end && *p == '\n') {
+                    p++;
+                }
+            } else {
+                p++;
+            }
+            rowEnd = p;
+            return RowStatus::Complete;
+        }
+    }
+
+    // Definition of a method to advance to the next non-blank row; takes no parameters; returns bool
+    bool CSVReader::readRow() {
+        while (true) {
+            const char* rowEnd = nullptr;
+            RowStatus status = parseRow(base() + position, base() + limit, rowEnd);
+
+            if (status == RowStatus::EndOfInput) {
+                fields.clear();
+                return false;
+            }
+            if (status == RowStatus::Incomplete) {
+                // The row continues past the window; pull in more input and parse it again
+                refill();
+                continue;
+            }
+
+            position = static_cast<size_t>(rowEnd - base());
+            rowNumber++;
+
+            // Skip blank lines
+            if (fields.size() == 1 && fields[0].empty()) {
+                continue;
+            }
+            return true;
+        }
+    }
+
+    // Definition of a method to split a single CSV line into owned fields; takes a string_view as parameter; returns vector of strings
+    vector<string> CSVReader::splitLine(string_view line) {
+        vector<string> row;
+        CSVReader reader = fromString(line);
+        if (reader.readRow()) {
+            row.reserve(reader.getFields().size());
+            for (string_view field : reader.getFields()) {
+                row.emplace_back(field);
+            }
+        }
+        return row;
+    }
+
+} // namespace TaxReturnSystem
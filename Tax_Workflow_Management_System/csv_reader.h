@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Streaming RFC 4180 CSV tokenizer; fields are views into the input that stay valid until the next readRow() call
+    class CSVReader {
+    private:
+        static constexpr size_t BLOCK_SIZE = 1 << 16; // Bytes read from disk per refill
+
+        enum class RowStatus { Complete, Incomplete, EndOfInput };
+
+        ifstream file; // Source file, when reading from disk
+        bool readingFile = false; // Whether input comes from file or from a caller-owned string
+        string buffer; // Block buffer holding the unparsed tail of the file
+        string_view content; // Caller-owned input when not reading from a file
+        size_t position = 0; // Start of the next unparsed row
+        size_t limit = 0; // End of the bytes available to parse
+        bool endOfInput = false; // Whether everything has been read into the window
+        size_t rowNumber = 0; // Number of physical rows consumed, including blank ones
+
+        vector<string_view> fields; // Fields of the current row
+        deque<string> unescaped; // Storage for quoted fields containing "" escapes; deque keeps views stable
+        size_t unescapedUsed = 0; // Entries of unescaped used by the current row
+
+        CSVReader() = default;
+
+        const char* base() const { return readingFile ? buffer.data() : content.data(); } // Start of the parse window
+        bool refill(); // Drop consumed bytes and read the next block from disk
+        void skipByteOrderMark(); // Skip a UTF-8 BOM at the start of the input
+        RowStatus parseRow(const char* begin, const char* end, const char*& rowEnd); // Tokenize one row of the window
+        string& nextUnescaped(); // Reusable scratch string for an unescaped field
+
+    public:
+        static CSVReader fromFile(const string& filename); // Read a file block by block; throws if it cannot be opened
+        static CSVReader fromString(string_view data); // Read from memory; data must outlive the reader
+
+        CSVReader(CSVReader&&) = default;
+        CSVReader& operator=(CSVReader&&) = default;
+
+        bool readRow(); // Advance to the next non-blank row; returns false at end of input
+        const vector<string_view>& getFields() const { return fields; } // Fields of the current row
+        size_t getRowNumber() const { return rowNumber; } // Physical row number of the current row, starting at 1
+
+        static vector<string> splitLine(string_view line); // Split a single line into owned fields
+    };
+
+} // namespace TaxReturnSystem
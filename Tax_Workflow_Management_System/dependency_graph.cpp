@@ -0,0 +1,364 @@
+/**
+ * @file dependency_graph.cpp
+ * @brief Implementation of the project dependency graph
+ *
+ * This file contains implementations for:
+ * - Deriving dependency edges from a snapshot in one hashed pass
+ * - Incremental node and edge updates as projects change
+ * - The ready-to-work set and dependency-ordered work lists
+ *
+ * The dependency rule is the one Project::buildPTETDependency applies: a
+ * PTET project waits for the same client's "<year> Form" project. Nodes
+ * are indexed by (client, project type) and by the key they wait for, so
+ * adding or removing a project links it to its counterparts without a
+ * scan. Every node counts its unfinished dependencies, which keeps the
+ * ready set exact as statuses change.
+ */
+
+#include "dependency_graph.h"
+#include "project_snapshot.h"
+#include <algorithm>
+#include <deque>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Remove one occurrence of a value from an unordered list
+        void eraseValue(vector<string>& values, const string& value) {
+            auto it = find(values.begin(), values.end(), value);
+            if (it != values.end()) {
+                *it = move(values.back());
+                values.pop_back();
+            }
+        }
+
+    } // namespace
+
+// DEPENDENCY GRAPH CLASS METHODS:
+
+    // Definition of a method to build the key of a (client, project type) pair; takes two strings as parameters; returns string
+    string DependencyGraph::projectKey(const string& client, const string& projectType) {
+        string key;
+        key.reserve(client.size() + projectType.size() + 1);
+        key.append(client).push_back('\x1f');
+        key.append(projectType);
+        return key;
+    }
+
+    // Definition of a method to get the key a project depends on; takes a client and project type as parameters; returns optional key
+    optional<string> DependencyGraph::dependencyKey(const string& client, const string& projectType) {
+        if (projectType.find("PTET") == string::npos) {
+            return nullopt;
+        }
+        string formType = projectType.substr(0, 4) + " Form";
+        if (formType == projectType) {
+            // A project never waits for projects of its own kind
+            return nullopt;
+        }
+        return projectKey(client, formType);
+    }
+
+    // Definition of a method to derive the dependency edges of a snapshot; takes a ProjectSnapshot as parameter; returns vector of DependencyEdge
+    vector<DependencyEdge> DependencyGraph::deriveEdges(const ProjectSnapshot& snapshot) {
+        unordered_map<string, vector<uint32_t>> rowsByKey;
+        rowsByKey.reserve(snapshot.size());
+        for (uint32_t row = 0; row < snapshot.size(); row++) {
+            rowsByKey[projectKey(snapshot.getClient(row), snapshot.getProjectType(row))].push_back(row);
+        }
+
+        vector<DependencyEdge> edges;
+        for (uint32_t row = 0; row < snapshot.size(); row++) {
+            optional<string> key = dependencyKey(snapshot.getClient(row), snapshot.getProjectType(row));
+            if (!key) continue;
+
+            auto targets = rowsByKey.find(*key);
+            if (targets == rowsByKey.end()) continue;
+
+            for (uint32_t target : targets->second) {
+                edges.push_back({snapshot.getId(row), snapshot.getId(target), DependencyType::BEFORE});
+            }
+        }
+        return edges;
+    }
+
+    // Definition of a method to add an edge between two existing nodes; takes two ids and optional change record as parameters; returns void
+    void DependencyGraph::addEdge(const string& projectId, const string& dependsOnId, DependencyChanges* changes) {
+        Node& project = nodes.at(projectId);
+        Node& dependency = nodes.at(dependsOnId);
+        if (find(project.dependsOn.begin(), project.dependsOn.end(), dependsOnId) != project.dependsOn.end()) {
+            return;
+        }
+
+        project.dependsOn.push_back(dependsOnId);
+        dependency.dependents.push_back(projectId);
+        if (!dependency.completed) {
+            project.pendingDependencies++;
+            updateReady(projectId, project);
+        }
+
+        if (changes) {
+            changes->addedEdges.push_back({projectId, dependsOnId, DependencyType::BEFORE});
+            changes->affectedProjects.push_back(projectId);
+        }
+    }
+
+    // Definition of a method to keep a node's ready-set membership current; takes an id and its node as parameters; returns void
+    void DependencyGraph::updateReady(const string& id, const Node& node) {
+        if (!node.completed && node.pendingDependencies == 0) {
+            ready.insert(id);
+        } else {
+            ready.erase(id);
+        }
+    }
+
+    // Definition of a method to add a node and link it by the dependency rule; takes the project columns and change record as parameters; returns void
+    void DependencyGraph::insertNode(const string& id, const string& client, const string& projectType, bool completed, int deadline,
+                                     DependencyChanges& changes) {
+        Node& node = nodes[id];
+        node.key = projectKey(client, projectType);
+        node.dependencyKey = dependencyKey(client, projectType);
+        node.completed = completed;
+        node.deadline = deadline;
+        idsByKey[node.key].push_back(id);
+        updateReady(id, node);
+
+        // Copies of the keys, since adding edges may not move nodes but the lists below are read while linking
+        const string key = node.key;
+        const optional<string> waitsFor = node.dependencyKey;
+
+        if (waitsFor) {
+            waitingByKey[*waitsFor].push_back(id);
+            auto targets = idsByKey.find(*waitsFor);
+            if (targets != idsByKey.end()) {
+                for (const string& target : targets->second) {
+                    addEdge(id, target, &changes);
+                }
+            }
+        }
+
+        auto waiting = waitingByKey.find(key);
+        if (waiting != waitingByKey.end()) {
+            for (const string& waitingId : waiting->second) {
+                if (waitingId != id) {
+                    addEdge(waitingId, id, &changes);
+                }
+            }
+        }
+    }
+
+    // Definition of a method to remove a node and its edges; takes an id and change record as parameters; returns void
+    void DependencyGraph::eraseNode(const string& id, DependencyChanges& changes) {
+        auto it = nodes.find(id);
+        if (it == nodes.end()) {
+            return;
+        }
+        Node& node = it->second;
+
+        for (const string& dependencyId : node.dependsOn) {
+            eraseValue(nodes.at(dependencyId).dependents, id);
+            changes.removedEdges.push_back({id, dependencyId, DependencyType::BEFORE});
+        }
+
+        for (const string& dependentId : node.dependents) {
+            Node& dependent = nodes.at(dependentId);
+            eraseValue(dependent.dependsOn, id);
+            if (!node.completed) {
+                dependent.pendingDependencies--;
+                updateReady(dependentId, dependent);
+            }
+            changes.removedEdges.push_back({dependentId, id, DependencyType::BEFORE});
+            changes.affectedProjects.push_back(dependentId);
+        }
+
+        auto sameKey = idsByKey.find(node.key);
+        eraseValue(sameKey->second, id);
+        if (sameKey->second.empty()) idsByKey.erase(sameKey);
+
+        if (node.dependencyKey) {
+            auto waiting = waitingByKey.find(*node.dependencyKey);
+            eraseValue(waiting->second, id);
+            if (waiting->second.empty()) waitingByKey.erase(waiting);
+        }
+
+        ready.erase(id);
+        nodes.erase(it);
+    }
+
+    // Definition of a method to change a node's completion; takes an id, the new state and change record as parameters; returns void
+    void DependencyGraph::setCompleted(const string& id, bool completed, DependencyChanges& changes) {
+        Node& node = nodes.at(id);
+        if (node.completed == completed) {
+            return;
+        }
+        node.completed = completed;
+        updateReady(id, node);
+
+        for (const string& dependentId : node.dependents) {
+            Node& dependent = nodes.at(dependentId);
+            dependent.pendingDependencies += completed ? -1 : 1;
+            updateReady(dependentId, dependent);
+            changes.affectedProjects.push_back(dependentId);
+        }
+    }
+
+    // Definition of a method to replace the graph; takes a snapshot and its stored edges as parameters; returns void
+    void DependencyGraph::rebuild(const ProjectSnapshot& snapshot, const vector<DependencyEdge>& edges) {
+        lock_guard<mutex> lock(graphMutex);
+
+        nodes.clear();
+        idsByKey.clear();
+        waitingByKey.clear();
+        ready.clear();
+        nodes.reserve(snapshot.size());
+
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            const string& id = snapshot.getId(row);
+            Node& node = nodes[id];
+            node.key = projectKey(snapshot.getClient(row), snapshot.getProjectType(row));
+            node.dependencyKey = dependencyKey(snapshot.getClient(row), snapshot.getProjectType(row));
+            node.completed = snapshot.getTaskStatus(row) == TaskStatus::Billed;
+            node.deadline = snapshot.getRegularDeadlineValue(row);
+            idsByKey[node.key].push_back(id);
+            if (node.dependencyKey) {
+                waitingByKey[*node.dependencyKey].push_back(id);
+            }
+            updateReady(id, node);
+        }
+
+        // Stored edges whose projects no longer exist are skipped
+        for (const DependencyEdge& edge : edges) {
+            if (edge.projectId != edge.dependsOnId && nodes.count(edge.projectId) && nodes.count(edge.dependsOnId)) {
+                addEdge(edge.projectId, edge.dependsOnId, nullptr);
+            }
+        }
+    }
+
+    // Definition of a method to insert a project or update its status; takes the project columns and change record as parameters; returns void
+    void DependencyGraph::upsertProject(const string& id, const string& client, const string& projectType, TaskStatus status,
+                                        const Date& regularDeadline, DependencyChanges& changes) {
+        lock_guard<mutex> lock(graphMutex);
+        bool completed = status == TaskStatus::Billed;
+
+        auto existing = nodes.find(id);
+        if (existing != nodes.end()) {
+            if (existing->second.key == projectKey(client, projectType)) {
+                existing->second.deadline = regularDeadline.getValue();
+                setCompleted(id, completed, changes);
+                return;
+            }
+            eraseNode(id, changes);
+        }
+        insertNode(id, client, projectType, completed, regularDeadline.getValue(), changes);
+    }
+
+    // Definition of a method to update a project's status and deadline; takes an id, a TaskStatus, a Date and change record as parameters; returns void
+    void DependencyGraph::updateProject(const string& id, TaskStatus status, const Date& regularDeadline, DependencyChanges& changes) {
+        lock_guard<mutex> lock(graphMutex);
+        auto existing = nodes.find(id);
+        if (existing != nodes.end()) {
+            existing->second.deadline = regularDeadline.getValue();
+            setCompleted(id, status == TaskStatus::Billed, changes);
+        }
+    }
+
+    // Definition of a method to remove a project; takes an id and change record as parameters; returns void
+    void DependencyGraph::removeProject(const string& id, DependencyChanges& changes) {
+        lock_guard<mutex> lock(graphMutex);
+        eraseNode(id, changes);
+    }
+
+    // Definition of a method to get the projects a project waits for; takes an id as parameter; returns vector of ids
+    vector<string> DependencyGraph::getDependencies(const string& id) const {
+        lock_guard<mutex> lock(graphMutex);
+        auto it = nodes.find(id);
+        return it != nodes.end() ? it->second.dependsOn : vector<string>();
+    }
+
+    // Definition of a method to check whether a project waits on an unfinished dependency; takes an id as parameter; returns bool
+    bool DependencyGraph::isAwaitingDependencies(const string& id) const {
+        lock_guard<mutex> lock(graphMutex);
+        auto it = nodes.find(id);
+        return it != nodes.end() && it->second.pendingDependencies > 0;
+    }
+
+    // Definition of a method to count unfinished projects waiting on dependencies; takes no parameters; returns size_t
+    size_t DependencyGraph::countAwaitingDependencies() const {
+        lock_guard<mutex> lock(graphMutex);
+        size_t count = 0;
+        for (const auto& [id, node] : nodes) {
+            if (!node.completed && node.pendingDependencies > 0) count++;
+        }
+        return count;
+    }
+
+    // Definition of a method to list projects ready to work on; takes no parameters; returns vector of ids
+    vector<string> DependencyGraph::getReadyProjects() const {
+        lock_guard<mutex> lock(graphMutex);
+        return vector<string>(ready.begin(), ready.end());
+    }
+
+    // Definition of a method to list unfinished projects so each comes after its dependencies; takes no parameters; returns vector of ids
+    vector<string> DependencyGraph::getWorkOrder() const {
+        lock_guard<mutex> lock(graphMutex);
+
+        // Kahn's algorithm over unfinished projects, starting from the ready set
+        unordered_map<string, int> pending;
+        deque<const string*> queue;
+        for (const string& id : ready) {
+            queue.push_back(&id);
+        }
+
+        vector<string> order;
+        while (!queue.empty()) {
+            const string& id = *queue.front();
+            queue.pop_front();
+            order.push_back(id);
+
+            for (const string& dependentId : nodes.at(id).dependents) {
+                const Node& dependent = nodes.at(dependentId);
+                if (dependent.completed) continue;
+
+                auto count = pending.emplace(dependentId, dependent.pendingDependencies).first;
+                if (--count->second == 0) {
+                    queue.push_back(&dependentId);
+                }
+            }
+        }
+
+        // Projects caught in a cycle never become ready; list them last rather than dropping them
+        size_t unfinished = count_if(nodes.begin(), nodes.end(), [](const auto& entry) { return !entry.second.completed; });
+        if (order.size() < unfinished) {
+            vector<const string*> leftover;
+            for (const auto& [id, node] : nodes) {
+                if (!node.completed && node.pendingDependencies > 0) {
+                    auto count = pending.find(id);
+                    if (count == pending.end() || count->second > 0) leftover.push_back(&id);
+                }
+            }
+
+            // The hash map's order changes between runs, so sort them by deadline and then id
+            sort(leftover.begin(), leftover.end(), [this](const string* a, const string* b) {
+                int deadlineA = nodes.at(*a).deadline, deadlineB = nodes.at(*b).deadline;
+                return deadlineA != deadlineB ? deadlineA < deadlineB : *a < *b;
+            });
+            for (const string* id : leftover) {
+                order.push_back(*id);
+            }
+        }
+        return order;
+    }
+
+    // Definition of a method to visit every edge; takes a visitor as parameter; returns void
+    void DependencyGraph::forEachEdge(const function<void(const string& projectId, const string& dependsOnId)>& visit) const {
+        lock_guard<mutex> lock(graphMutex);
+        for (const auto& [id, node] : nodes) {
+            for (const string& dependencyId : node.dependsOn) {
+                visit(id, dependencyId);
+            }
+        }
+    }
+
+} // namespace TaxReturnSystem
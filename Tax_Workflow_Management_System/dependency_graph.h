@@ -0,0 +1,81 @@
+#pragma once
+
+#include <set>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include "CSV_management.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // One edge of the dependency graph, as stored in the project_dependencies table
+    struct DependencyEdge {
+        string projectId; // Project that waits
+        string dependsOnId; // Project that has to be finished first
+        DependencyType type = DependencyType::BEFORE; // Edge type
+    };
+
+    // What one or more graph updates changed
+    struct DependencyChanges {
+        vector<DependencyEdge> addedEdges; // Edges to insert into project_dependencies
+        vector<DependencyEdge> removedEdges; // Edges to delete from project_dependencies
+        vector<string> affectedProjects; // Projects whose dependencies, or their dependencies' status, changed
+    };
+
+    // In-memory project dependency graph with an incrementally maintained set of projects ready to work on
+    class DependencyGraph {
+    private:
+        // One project of the graph
+        struct Node {
+            string key; // (client, project type) key
+            optional<string> dependencyKey; // Key of the projects this one depends on, if any
+            bool completed = false; // Whether the project is billed
+            int deadline = 0; // Regular deadline in YYYYMMDD form, for ordering projects caught in a cycle
+            int pendingDependencies = 0; // Dependencies that are not completed
+            vector<string> dependsOn; // Projects this one waits for
+            vector<string> dependents; // Projects waiting for this one
+        };
+
+        mutable mutex graphMutex; // Guards every member below
+        unordered_map<string, Node> nodes; // Nodes by project id
+        unordered_map<string, vector<string>> idsByKey; // Project ids by (client, project type) key
+        unordered_map<string, vector<string>> waitingByKey; // Ids of projects by the key they depend on
+        set<string> ready; // Unfinished projects with every dependency finished, ordered by id
+
+        static string projectKey(const string& client, const string& projectType); // Key of a (client, project type) pair
+        static optional<string> dependencyKey(const string& client, const string& projectType); // Key a project depends on
+
+        void addEdge(const string& projectId, const string& dependsOnId, DependencyChanges* changes); // Link two nodes
+        void updateReady(const string& id, const Node& node); // Add or remove a node from the ready set
+        void insertNode(const string& id, const string& client, const string& projectType, bool completed, int deadline,
+                        DependencyChanges& changes); // Add a node and link it by the dependency rule
+        void eraseNode(const string& id, DependencyChanges& changes); // Remove a node and its edges
+        void setCompleted(const string& id, bool completed, DependencyChanges& changes); // Change a node's status
+
+    public:
+        static vector<DependencyEdge> deriveEdges(const ProjectSnapshot& snapshot); // Apply the dependency rule to a snapshot in one hashed pass
+
+        void rebuild(const ProjectSnapshot& snapshot, const vector<DependencyEdge>& edges); // Replace the graph with a snapshot's projects and stored edges
+
+        // Incremental updates; each appends what it changed to changes
+        void upsertProject(const string& id, const string& client, const string& projectType, TaskStatus status,
+                           const Date& regularDeadline, DependencyChanges& changes); // Insert a project or update its status and deadline
+        void updateProject(const string& id, TaskStatus status, const Date& regularDeadline,
+                           DependencyChanges& changes); // Update a project's status and deadline; no-op for unknown ids
+        void removeProject(const string& id, DependencyChanges& changes); // Remove a project; no-op for unknown ids
+
+        // Queries
+        vector<string> getDependencies(const string& id) const; // Projects a project waits for
+        bool isAwaitingDependencies(const string& id) const; // Whether any dependency is unfinished
+        size_t countAwaitingDependencies() const; // Unfinished projects waiting on an unfinished dependency
+        vector<string> getReadyProjects() const; // Unfinished projects that can be worked on now
+        vector<string> getWorkOrder() const; // Unfinished projects in dependency order; projects in a cycle come last by deadline and id
+        void forEachEdge(const function<void(const string& projectId, const string& dependsOnId)>& visit) const; // Visit every edge
+    };
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,121 @@
+/**
+ * @file edit_distance.cpp
+ * @brief Implementation of bounded Levenshtein distance
+ *
+ * This file contains implementations for:
+ * - Myers' bit-vector algorithm, in Hyyrö's form for global edit distance
+ * - Early cutoff once the distance can no longer come back under the bound
+ * - A two-row fallback for patterns longer than one machine word
+ *
+ * Patterns up to 64 bytes need no heap allocation: the position masks live
+ * in a fixed table and each text byte costs a handful of word operations.
+ */
+
+#include "edit_distance.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Plain dynamic programming over two rows, stopping once a whole row exceeds the bound
+        int rowByRowDistance(string_view a, string_view b, int maxDistance) {
+            vector<int> previous(b.size() + 1), current(b.size() + 1);
+            for (size_t j = 0; j <= b.size(); j++) {
+                previous[j] = static_cast<int>(j);
+            }
+
+            for (size_t i = 1; i <= a.size(); i++) {
+                current[0] = static_cast<int>(i);
+                int rowMinimum = current[0];
+                for (size_t j = 1; j <= b.size(); j++) {
+                    int substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                    current[j] = min({previous[j] + 1, current[j - 1] + 1, substitution});
+                    rowMinimum = min(rowMinimum, current[j]);
+                }
+                if (rowMinimum > maxDistance) {
+                    return maxDistance + 1;
+                }
+                swap(previous, current);
+            }
+
+            return min(previous[b.size()], maxDistance + 1);
+        }
+
+    } // namespace
+
+// LEVENSHTEIN PATTERN CLASS METHODS:
+
+    // Definition of the constructor; takes the pattern text as parameter
+    LevenshteinPattern::LevenshteinPattern(string_view pattern) : pattern(pattern) {
+        size_t length = min(pattern.size(), MAX_BIT_PARALLEL_LENGTH);
+        for (size_t i = 0; i < length; i++) {
+            peq[static_cast<unsigned char>(pattern[i])] |= uint64_t(1) << i;
+        }
+    }
+
+    // Definition of a method to compute the edit distance to a text with a cutoff; takes a text and a maximum distance as parameters; returns int
+    int LevenshteinPattern::boundedDistance(string_view text, int maxDistance) const {
+        const int m = static_cast<int>(pattern.size());
+        const int n = static_cast<int>(text.size());
+
+        // The length difference alone is a lower bound
+        if (abs(m - n) > maxDistance) {
+            return maxDistance + 1;
+        }
+        if (m == 0) {
+            return n;
+        }
+        if (pattern.size() > MAX_BIT_PARALLEL_LENGTH) {
+            return rowByRowDistance(pattern, text, maxDistance);
+        }
+
+        const uint64_t lastBit = uint64_t(1) << (m - 1);
+        uint64_t positiveVertical = ~uint64_t(0);
+        uint64_t negativeVertical = 0;
+        int score = m;
+
+        for (int j = 0; j < n; j++) {
+            const uint64_t equal = peq[static_cast<unsigned char>(text[j])];
+            const uint64_t xv = equal | negativeVertical;
+            const uint64_t xh = (((equal & positiveVertical) + positiveVertical) ^ positiveVertical) | equal;
+
+            uint64_t positiveHorizontal = negativeVertical | ~(xh | positiveVertical);
+            uint64_t negativeHorizontal = positiveVertical & xh;
+
+            if (positiveHorizontal & lastBit) {
+                score++;
+            } else if (negativeHorizontal & lastBit) {
+                score--;
+            }
+
+            // Each remaining text byte can lower the score by at most one
+            if (score - (n - j - 1) > maxDistance) {
+                return maxDistance + 1;
+            }
+
+            // Shifting in a one makes the first row count insertions, giving global distance
+            positiveHorizontal = (positiveHorizontal << 1) | 1;
+            negativeHorizontal <<= 1;
+
+            positiveVertical = negativeHorizontal | ~(xv | positiveHorizontal);
+            negativeVertical = positiveHorizontal & xv;
+        }
+
+        return min(score, maxDistance + 1);
+    }
+
+    // Definition of a function to compute the bounded edit distance between two strings; takes two strings and a maximum distance as parameters; returns int
+    int boundedLevenshtein(string_view a, string_view b, int maxDistance) {
+        // Use the shorter string as the pattern so more inputs fit in one machine word
+        if (a.size() > b.size()) {
+            swap(a, b);
+        }
+        return LevenshteinPattern(a).boundedDistance(b, maxDistance);
+    }
+
+} // namespace TaxReturnSystem
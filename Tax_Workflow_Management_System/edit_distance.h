@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Pattern prepared for bit-parallel (Myers/Hyyrö) Levenshtein distance against many texts
+    class LevenshteinPattern {
+    public:
+        static constexpr size_t MAX_BIT_PARALLEL_LENGTH = 64; // Longer patterns fall back to a row-by-row DP
+
+    private:
+        string_view pattern; // Pattern text; must outlive this object
+        array<uint64_t, 256> peq{}; // Bit mask of pattern positions for each byte value
+
+    public:
+        explicit LevenshteinPattern(string_view pattern); // Constructor
+
+        // Edit distance to text, or maxDistance + 1 as soon as the distance is known to exceed maxDistance
+        int boundedDistance(string_view text, int maxDistance) const;
+
+        bool isWithin(string_view text, int maxDistance) const { // Check whether text is at most maxDistance edits away
+            return boundedDistance(text, maxDistance) <= maxDistance;
+        }
+
+        // Check whether any text is within the distance returned by maxDistanceFor(text); a negative limit skips the text
+        template <typename Container, typename ThresholdFunction>
+        bool anyWithin(const Container& texts, ThresholdFunction maxDistanceFor) const {
+            for (const auto& text : texts) {
+                int maxDistance = maxDistanceFor(text);
+                if (maxDistance >= 0 && isWithin(text, maxDistance)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    int boundedLevenshtein(string_view a, string_view b, int maxDistance); // Bounded edit distance between two strings
+
+} // namespace TaxReturnSystem
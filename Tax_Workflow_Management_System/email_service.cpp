@@ -3,42 +3,331 @@
  * @brief Implementation of email service functionality for the Tax Return System
  *
  * This file contains implementations for:
- * - Email sending simulation
- * - Email logging
- * - Network delay simulation
- * - Success/failure rate simulation
+ * - The SQLite-backed outbox behind sendEmail
+ * - Sender threads with per-recipient batching and retry backoff
+ * - The local file transport used in place of an SMTP server
+ *
+ * sendEmail only inserts a row into the outbox, so request threads never
+ * wait on delivery. Sender threads claim the due emails of one recipient
+ * at a time, mark them as sending and hand them to the transport as one
+ * batch. Delivered emails are removed from the outbox; failed ones are
+ * retried after a delay that doubles per attempt, up to EMAIL_MAX_ATTEMPTS.
+ * Emails still marked as sending when the process stopped are requeued on
+ * the next start.
  */
 
 #include "email_service.h"
-#include <thread>
 #include <chrono>
-#include <cstdlib>
+#include <algorithm>
 
 namespace TaxReturnSystem {
 
-    // Method to simulate sending an email; takes recipient email address, subject, and body as parameters; returns true if the email was "sent" successfully, false otherwise
-    bool EmailService::sendEmail(const string& to, const string& subject, const string& body) {
-        // Simulate network delay
-        this_thread::sleep_for(chrono::milliseconds(500));
-        // Log the email
-        logEmail(to, subject, body);
-        // Simulate occasional failure
-        return (rand() % 100) < 95;  // 95% success rate
-    }
-
-    // Method to log email details; takes recipient email address, subject, and body as parameters
-    void EmailService::logEmail(const string& to, const string& subject, const string& body) {
-        ofstream logFile("email_log.txt", ios::app);
-        if (logFile.is_open()) {
-            time_t now = time(0);
-            char* dt = ctime(&now);
+    namespace {
+
+        // Current time in seconds since the epoch
+        int64_t nowSeconds() {
+            return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        // Bind a string to a statement parameter
+        void bindText(sqlite3_stmt* stmt, int index, const string& text) {
+            sqlite3_bind_text(stmt, index, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+        }
+
+        // Read a text column, treating NULL as empty
+        string columnText(sqlite3_stmt* stmt, int column) {
+            const unsigned char* text = sqlite3_column_text(stmt, column);
+            return text ? reinterpret_cast<const char*>(text) : string();
+        }
+
+    } // namespace
+
+// FILE EMAIL TRANSPORT CLASS METHODS:
+
+    // Definition of a constructor to open the delivery file; takes a path as parameter; returns nothing
+    FileEmailTransport::FileEmailTransport(const string& path) {
+        logFile.open(path, ios::app);
+    }
+
+    // Method to write a batch of emails for one recipient; takes recipient email address and the emails as parameters; returns true if written, false otherwise
+    bool FileEmailTransport::deliver(const string& to, const vector<OutgoingEmail>& messages) {
+        lock_guard<mutex> lock(fileMutex);
+        if (!logFile.is_open()) {
+            return false;
+        }
+
+        time_t now = time(0);
+        char dt[26];
+        ctime_r(&now, dt);
+
+        for (const OutgoingEmail& message : messages) {
             logFile << "Time: " << dt;
-            logFile << "To: " << to << endl;
-            logFile << "Subject: " << subject << endl;
-            logFile << "Body: " << body << endl;
-            logFile << "--------------------" << endl;
-            logFile.close();
+            logFile << "To: " << to << '\n';
+            logFile << "Subject: " << message.subject << '\n';
+            logFile << "Body: " << message.body << '\n';
+            logFile << "--------------------" << '\n';
+        }
+        logFile.flush();
+        return logFile.good();
+    }
+
+// EMAIL SERVICE CLASS METHODS:
+
+    // Definition of a constructor to open the outbox and start the senders; takes the outbox path, a transport and a thread count as parameters; returns nothing
+    EmailService::EmailService(const string& outboxPath, unique_ptr<EmailTransport> emailTransport, size_t senderCount)
+            : transport(move(emailTransport)) {
+        if (!transport) {
+            transport = make_unique<FileEmailTransport>(EMAIL_LOG_PATH);
+        }
+
+        if (sqlite3_open(outboxPath.c_str(), &db) != SQLITE_OK) {
+            string error = db ? sqlite3_errmsg(db) : "out of memory";
+            sqlite3_close(db);
+            throw runtime_error("Failed to open email outbox: " + error);
+        }
+        createOutboxTable();
+
+        for (size_t i = 0; i < max<size_t>(senderCount, 1); i++) {
+            senders.emplace_back(&EmailService::senderLoop, this);
+        }
+    }
+
+    // Definition of a destructor to stop the senders and close the outbox; takes no parameters; returns nothing
+    EmailService::~EmailService() {
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& sender : senders) {
+            sender.join();
+        }
+        sqlite3_close(db);
+    }
+
+    // Definition of a method to create the outbox table; takes no parameters; returns void
+    void EmailService::createOutboxTable() {
+        const char* sql = R"(
+        PRAGMA journal_mode = WAL;
+        PRAGMA synchronous = NORMAL;
+        CREATE TABLE IF NOT EXISTS email_outbox (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            recipient TEXT NOT NULL,
+            subject TEXT NOT NULL,
+            body TEXT NOT NULL,
+            status INTEGER NOT NULL DEFAULT 0,
+            attempts INTEGER NOT NULL DEFAULT 0,
+            next_attempt INTEGER NOT NULL,
+            created INTEGER NOT NULL,
+            last_error TEXT
+        );
+        CREATE INDEX IF NOT EXISTS idx_email_outbox_due ON email_outbox(status, next_attempt);
+        CREATE INDEX IF NOT EXISTS idx_email_outbox_recipient ON email_outbox(recipient, status);
+        UPDATE email_outbox SET status = 0 WHERE status = 1;
+    )";
+
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            string errorMsg = errMsg ? errMsg : "Unknown error";
+            sqlite3_free(errMsg);
+            sqlite3_close(db);
+            throw runtime_error("Failed to create email outbox: " + errorMsg);
+        }
+    }
+
+    // Method to queue an email; takes recipient email address, subject, and body as parameters; returns true if the email was stored in the outbox, false otherwise
+    bool EmailService::sendEmail(const string& to, const string& subject, const string& body) {
+        {
+            lock_guard<mutex> lock(dbMutex);
+
+            sqlite3_stmt* stmt;
+            const char* query = "INSERT INTO email_outbox (recipient, subject, body, status, attempts, next_attempt, created) "
+                                "VALUES (?, ?, ?, 0, 0, ?, ?);";
+            if (sqlite3_prepare_v2(db, query, -1, &stmt, nullptr) != SQLITE_OK) {
+                cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+                return false;
+            }
+
+            int64_t now = nowSeconds();
+            bindText(stmt, 1, to);
+            bindText(stmt, 2, subject);
+            bindText(stmt, 3, body);
+            sqlite3_bind_int64(stmt, 4, now);
+            sqlite3_bind_int64(stmt, 5, now);
+
+            int result = sqlite3_step(stmt);
+            sqlite3_finalize(stmt);
+            if (result != SQLITE_DONE) {
+                cerr << "Failed to queue email: " << sqlite3_errmsg(db) << endl;
+                return false;
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            enqueueCount++;
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    // Definition of a method to count emails waiting for delivery; takes no parameters; returns size_t
+    size_t EmailService::getPendingCount() const {
+        lock_guard<mutex> lock(dbMutex);
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM email_outbox WHERE status IN (0, 1);", -1, &stmt, nullptr) != SQLITE_OK) {
+            return 0;
+        }
+        size_t count = sqlite3_step(stmt) == SQLITE_ROW ? static_cast<size_t>(sqlite3_column_int64(stmt, 0)) : 0;
+        sqlite3_finalize(stmt);
+        return count;
+    }
+
+    // Definition of a method to claim the due emails of one recipient; takes the next due time as output parameter; returns vector of OutgoingEmail
+    vector<OutgoingEmail> EmailService::claimBatch(int64_t& nextDue) {
+        lock_guard<mutex> lock(dbMutex);
+        vector<OutgoingEmail> batch;
+        int64_t now = nowSeconds();
+        nextDue = 0;
+
+        // Oldest due email picks the recipient
+        sqlite3_stmt* stmt;
+        const char* nextQuery = "SELECT recipient, next_attempt FROM email_outbox WHERE status = 0 ORDER BY next_attempt, id LIMIT 1;";
+        if (sqlite3_prepare_v2(db, nextQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+            return batch;
+        }
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            sqlite3_finalize(stmt);
+            return batch;
+        }
+        string recipient = columnText(stmt, 0);
+        int64_t dueAt = sqlite3_column_int64(stmt, 1);
+        sqlite3_finalize(stmt);
+
+        if (dueAt > now) {
+            nextDue = dueAt;
+            return batch;
+        }
+
+        if (sqlite3_exec(db, "BEGIN IMMEDIATE TRANSACTION;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Failed to begin transaction: " << sqlite3_errmsg(db) << endl;
+            return batch;
+        }
+
+        const char* claimQuery = "SELECT id, subject, body, attempts FROM email_outbox "
+                                 "WHERE recipient = ? AND status = 0 AND next_attempt <= ? ORDER BY id LIMIT ?;";
+        if (sqlite3_prepare_v2(db, claimQuery, -1, &stmt, nullptr) == SQLITE_OK) {
+            bindText(stmt, 1, recipient);
+            sqlite3_bind_int64(stmt, 2, now);
+            sqlite3_bind_int(stmt, 3, EMAIL_BATCH_SIZE);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                OutgoingEmail email;
+                email.id = sqlite3_column_int64(stmt, 0);
+                email.to = recipient;
+                email.subject = columnText(stmt, 1);
+                email.body = columnText(stmt, 2);
+                email.attempts = sqlite3_column_int(stmt, 3);
+                batch.push_back(move(email));
+            }
+            sqlite3_finalize(stmt);
+        }
+
+        bool claimed = sqlite3_prepare_v2(db, "UPDATE email_outbox SET status = 1 WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK;
+        for (size_t i = 0; claimed && i < batch.size(); i++) {
+            sqlite3_bind_int64(stmt, 1, batch[i].id);
+            claimed = sqlite3_step(stmt) == SQLITE_DONE;
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+
+        if (!claimed || sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Failed to claim emails: " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            batch.clear();
+        }
+        return batch;
+    }
+
+    // Definition of a method to record a delivery result; takes the batch and whether it was delivered as parameters; returns void
+    void EmailService::recordResult(const vector<OutgoingEmail>& batch, bool delivered) {
+        lock_guard<mutex> lock(dbMutex);
+        sqlite3_exec(db, "BEGIN IMMEDIATE TRANSACTION;", nullptr, nullptr, nullptr);
+
+        sqlite3_stmt* stmt;
+        if (delivered) {
+            if (sqlite3_prepare_v2(db, "DELETE FROM email_outbox WHERE id = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+                for (const OutgoingEmail& email : batch) {
+                    sqlite3_bind_int64(stmt, 1, email.id);
+                    sqlite3_step(stmt);
+                    sqlite3_reset(stmt);
+                }
+                sqlite3_finalize(stmt);
+            }
+        } else {
+            const char* retryQuery = "UPDATE email_outbox SET status = ?, attempts = ?, next_attempt = ?, "
+                                     "last_error = 'Transport failed' WHERE id = ?;";
+            if (sqlite3_prepare_v2(db, retryQuery, -1, &stmt, nullptr) == SQLITE_OK) {
+                int64_t now = nowSeconds();
+                for (const OutgoingEmail& email : batch) {
+                    int attempts = email.attempts + 1;
+                    int64_t delay = min<int64_t>(static_cast<int64_t>(EMAIL_RETRY_DELAY) << min(attempts - 1, 20),
+                                                 EMAIL_MAX_RETRY_DELAY);
+                    sqlite3_bind_int(stmt, 1, attempts >= EMAIL_MAX_ATTEMPTS ? Failed : Pending);
+                    sqlite3_bind_int(stmt, 2, attempts);
+                    sqlite3_bind_int64(stmt, 3, now + delay);
+                    sqlite3_bind_int64(stmt, 4, email.id);
+                    sqlite3_step(stmt);
+                    sqlite3_reset(stmt);
+                }
+                sqlite3_finalize(stmt);
+            }
+        }
+
+        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            cerr << "Failed to record email delivery: " << sqlite3_errmsg(db) << endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        }
+    }
+
+    // Definition of the sender thread body; takes no parameters; returns void
+    void EmailService::senderLoop() {
+        while (true) {
+            uint64_t seen;
+            {
+                lock_guard<mutex> lock(wakeMutex);
+                if (stopping) {
+                    return;
+                }
+                seen = enqueueCount;
+            }
+
+            int64_t nextDue = 0;
+            vector<OutgoingEmail> batch = claimBatch(nextDue);
+
+            if (batch.empty()) {
+                // Sleep until new mail arrives or the earliest retry is due
+                chrono::seconds wait(EMAIL_RETRY_DELAY);
+                if (nextDue != 0) {
+                    wait = chrono::seconds(max<int64_t>(nextDue - nowSeconds(), 1));
+                }
+                unique_lock<mutex> lock(wakeMutex);
+                wake.wait_for(lock, wait, [&]() { return stopping || enqueueCount != seen; });
+                continue;
+            }
+
+            bool delivered = false;
+            try {
+                delivered = transport->deliver(batch.front().to, batch);
+            } catch (const exception& e) {
+                cerr << "Email transport error: " << e.what() << endl;
+            }
+            if (!delivered) {
+                cerr << "Failed to deliver " << batch.size() << " email(s) to " << batch.front().to << endl;
+            }
+            recordResult(batch, delivered);
         }
     }
 
-}
\ No newline at end of file
+}
@@ -4,18 +4,79 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <condition_variable>
+#include <sqlite3.h>
+#include "config.h"
 
 using namespace std;
 
 namespace TaxReturnSystem {
 
+    // One email in the outbox
+    struct OutgoingEmail {
+        int64_t id = 0; // Outbox row id
+        string to; // Recipient address
+        string subject; // Subject line
+        string body; // Message body
+        int attempts = 0; // Delivery attempts made before this one
+    };
+
+    // Delivers emails; implementations are called from the sender threads, one recipient batch at a time
+    class EmailTransport {
+    public:
+        virtual ~EmailTransport() = default;
+        virtual bool deliver(const string& to, const vector<OutgoingEmail>& messages) = 0; // Deliver a batch to one recipient; returns success
+    };
+
+    // Local transport that appends delivered emails to a file, standing in for an SMTP server
+    class FileEmailTransport : public EmailTransport {
+    private:
+        mutex fileMutex; // Serializes batches from different sender threads
+        ofstream logFile; // Delivered emails
+
+    public:
+        explicit FileEmailTransport(const string& path); // Constructor; opens the file in append mode
+        bool deliver(const string& to, const vector<OutgoingEmail>& messages) override; // Write a batch to the file
+    };
+
+    // Durable outbound email queue: sendEmail stores the email in a SQLite outbox and sender threads deliver it
     class EmailService {
     private:
-        void logEmail(const string& to, const string& subject, const string& body); // Log email sending attempts
+        // Outbox row states
+        enum OutboxStatus { Pending = 0, Sending = 1, Failed = 2 };
+
+        sqlite3* db = nullptr; // Outbox database connection
+        mutable mutex dbMutex; // Guards the connection
+        unique_ptr<EmailTransport> transport; // Delivery backend
+
+        vector<thread> senders; // Sender threads
+        mutex wakeMutex; // Guards the fields below and pairs with wake
+        condition_variable wake; // Wakes idle senders
+        uint64_t enqueueCount = 0; // Emails queued since start; lets senders notice new mail
+        bool stopping = false; // Set by the destructor
+
+        void createOutboxTable(); // Create the outbox table and index if they don't exist
+        vector<OutgoingEmail> claimBatch(int64_t& nextDue); // Claim one recipient's due emails; sets nextDue when none are due
+        void recordResult(const vector<OutgoingEmail>& batch, bool delivered); // Remove delivered emails or schedule a retry
+        void senderLoop(); // Body of each sender thread
 
     public:
+        // Constructor; opens the outbox, requeues emails left mid-delivery and starts the senders
+        EmailService(const string& outboxPath = EMAIL_OUTBOX_PATH, unique_ptr<EmailTransport> transport = nullptr,
+                     size_t senderCount = EMAIL_SENDER_THREADS);
+        ~EmailService(); // Stops the senders; undelivered emails stay in the outbox for the next start
+
+        EmailService(const EmailService&) = delete;
+        EmailService& operator=(const EmailService&) = delete;
+
         // Email operations
-        bool sendEmail(const string& to, const string& subject, const string& body); // Send email and return success status
+        bool sendEmail(const string& to, const string& subject, const string& body); // Queue an email; returns whether it was stored
+        size_t getPendingCount() const; // Emails waiting for delivery
     };
 
-} // namespace TaxReturnSystem
\ No newline at end of file
+} // namespace TaxReturnSystem
@@ -0,0 +1,294 @@
+/**
+ * @file feature_store.cpp
+ * @brief Implementation of the persistent client feature store
+ *
+ * This file contains implementations for:
+ * - Incremental refresh of client features against the project snapshot
+ * - Building the candidate index for each feature set
+ * - Saving and loading features in a compact binary file
+ *
+ * Cache file layout (native byte order):
+ *   magic "TRFS", format version, feature dimension, entry count,
+ *   then per entry: client name, processed name, token list, feature values.
+ * Strings are a uint32 length followed by the bytes.
+ */
+
+#include "feature_store.h"
+#include "task_executor.h"
+#include <fstream>
+#include <cstdio>
+#include <chrono>
+#include <unordered_set>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        const char FILE_MAGIC[4] = {'T', 'R', 'F', 'S'};
+        const uint32_t FEATURE_DIMENSION = 5; // Length of nameToFeatures vectors
+        const uint32_t MAX_STRING_LENGTH = 1 << 20; // Sanity limit when reading strings
+
+        // Write a plain value in native byte order
+        template <typename T>
+        void writeValue(ofstream& out, T value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        // Read a plain value in native byte order
+        template <typename T>
+        bool readValue(ifstream& in, T& value) {
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        // Write a length-prefixed string
+        void writeString(ofstream& out, const string& value) {
+            writeValue<uint32_t>(out, static_cast<uint32_t>(value.size()));
+            out.write(value.data(), static_cast<streamsize>(value.size()));
+        }
+
+        // Read a length-prefixed string
+        bool readString(ifstream& in, string& value) {
+            uint32_t length;
+            if (!readValue(in, length) || length > MAX_STRING_LENGTH) {
+                return false;
+            }
+            value.resize(length);
+            return length == 0 || static_cast<bool>(in.read(&value[0], length));
+        }
+
+    } // namespace
+
+// FEATURE STORE CLASS METHODS:
+
+    // Definition of a method to index a list of features; takes a vector of PrecomputedFeatures as parameter; returns shared pointer to FeatureSet
+    shared_ptr<const FeatureStore::FeatureSet> FeatureStore::makeSet(vector<PrecomputedFeatures> features) {
+        auto set = make_shared<FeatureSet>();
+        set->features = move(features);
+        set->byClient.reserve(set->features.size());
+        set->candidateIndex.reserve(set->features.size());
+
+        for (uint32_t i = 0; i < set->features.size(); i++) {
+            const PrecomputedFeatures& entry = set->features[i];
+            set->byClient.emplace(entry.clientName, i);
+            set->candidateIndex.add(entry.processedName, entry.tokens);
+        }
+        set->candidateIndex.finalize();
+
+        return set;
+    }
+
+    // Definition of a method to get features for a snapshot, featurizing only new clients; takes a ProjectSnapshot as parameter; returns shared pointer to FeatureSet
+    shared_ptr<const FeatureStore::FeatureSet> FeatureStore::getFeatures(const ProjectSnapshot& snapshot) {
+        {
+            lock_guard<mutex> lock(storeMutex);
+            if (current && currentVersion == snapshot.getVersion()) {
+                return current;
+            }
+        }
+
+        // One rebuild at a time; callers that need the current set are not blocked by it
+        lock_guard<mutex> refreshLock(refreshMutex);
+
+        shared_ptr<const FeatureSet> base;
+        {
+            lock_guard<mutex> lock(storeMutex);
+            if (current && currentVersion == snapshot.getVersion()) {
+                return current;
+            }
+            base = current;
+        }
+
+        auto startTime = chrono::steady_clock::now();
+
+        // Distinct clients in table order, and how many of them are not featurized yet
+        vector<const string*> clients;
+        unordered_set<string> seen;
+        seen.reserve(snapshot.size());
+        size_t missing = 0;
+
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            const string& client = snapshot.getClient(row);
+            if (!seen.insert(client).second) {
+                continue;
+            }
+            clients.push_back(&client);
+            if (!base || base->byClient.find(client) == base->byClient.end()) {
+                missing++;
+            }
+        }
+
+        // Same clients as before: keep the existing set and index
+        if (base && missing == 0 && clients.size() == base->features.size()) {
+            lock_guard<mutex> lock(storeMutex);
+            currentVersion = snapshot.getVersion();
+            return base;
+        }
+
+        vector<PrecomputedFeatures> features(clients.size());
+        TaskExecutor::shared().parallelFor(0, clients.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                if (base) {
+                    auto it = base->byClient.find(*clients[i]);
+                    if (it != base->byClient.end()) {
+                        features[i] = base->features[it->second];
+                        continue;
+                    }
+                }
+                features[i] = matcher.computeFeatures(*clients[i]);
+            }
+        });
+
+        size_t reused = clients.size() - missing;
+        size_t removed = base ? base->features.size() - reused : 0;
+        auto set = makeSet(move(features));
+        {
+            lock_guard<mutex> lock(storeMutex);
+            current = set;
+            currentVersion = snapshot.getVersion();
+        }
+
+        auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+        cout << "Feature store refreshed: " << clients.size() << " clients, " << missing << " featurized, "
+             << removed << " dropped in " << duration.count() << "ms" << endl;
+
+        if (!cachePath.empty() && !saveToFile(cachePath, set->features)) {
+            cerr << "Failed to write feature cache: " << cachePath << endl;
+        }
+
+        return set;
+    }
+
+    // Definition of a method to warm the store from the cache file; takes no parameters; returns bool
+    bool FeatureStore::load() {
+        if (cachePath.empty()) {
+            return false;
+        }
+
+        lock_guard<mutex> refreshLock(refreshMutex);
+        auto startTime = chrono::steady_clock::now();
+
+        vector<PrecomputedFeatures> features;
+        if (!loadFromFile(cachePath, features)) {
+            return false;
+        }
+
+        auto set = makeSet(move(features));
+        auto duration = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+        cout << "Loaded " << set->features.size() << " client features from " << cachePath
+             << " in " << duration.count() << "ms" << endl;
+
+        lock_guard<mutex> lock(storeMutex);
+        current = move(set);
+        currentVersion = 0;
+        return true;
+    }
+
+    // Definition of a method to write the current features to the cache file; takes no parameters; returns bool
+    bool FeatureStore::save() const {
+        lock_guard<mutex> refreshLock(refreshMutex);
+
+        shared_ptr<const FeatureSet> set;
+        {
+            lock_guard<mutex> lock(storeMutex);
+            set = current;
+        }
+        return set && !cachePath.empty() && saveToFile(cachePath, set->features);
+    }
+
+    // Definition of a method to count the clients in the current feature set; takes no parameters; returns size_t
+    size_t FeatureStore::size() const {
+        lock_guard<mutex> lock(storeMutex);
+        return current ? current->features.size() : 0;
+    }
+
+    // Definition of a method to write features to a binary file; takes a path and a vector of PrecomputedFeatures as parameters; returns bool
+    bool FeatureStore::saveToFile(const string& path, const vector<PrecomputedFeatures>& features) {
+        // Write to a temporary file and rename, so a crash never leaves a truncated cache
+        string tempPath = path + ".tmp";
+        {
+            ofstream out(tempPath, ios::binary | ios::trunc);
+            if (!out.is_open()) {
+                return false;
+            }
+
+            out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+            writeValue<uint32_t>(out, FORMAT_VERSION);
+            writeValue<uint32_t>(out, FEATURE_DIMENSION);
+            writeValue<uint64_t>(out, features.size());
+
+            for (const auto& entry : features) {
+                writeString(out, entry.clientName);
+                writeString(out, entry.processedName);
+                writeValue<uint32_t>(out, static_cast<uint32_t>(entry.tokens.size()));
+                for (const auto& token : entry.tokens) {
+                    writeString(out, token);
+                }
+                for (uint32_t i = 0; i < FEATURE_DIMENSION; i++) {
+                    writeValue<double>(out, i < entry.features.size() ? entry.features(i) : 0.0);
+                }
+            }
+
+            if (!out) {
+                return false;
+            }
+        }
+
+        return rename(tempPath.c_str(), path.c_str()) == 0;
+    }
+
+    // Definition of a method to read features from a binary file; takes a path and an output vector as parameters; returns bool
+    bool FeatureStore::loadFromFile(const string& path, vector<PrecomputedFeatures>& features) {
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        char magic[sizeof(FILE_MAGIC)];
+        uint32_t version, dimension;
+        uint64_t count;
+        if (!in.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), FILE_MAGIC) ||
+            !readValue(in, version) || version != FORMAT_VERSION ||
+            !readValue(in, dimension) || dimension != FEATURE_DIMENSION ||
+            !readValue(in, count)) {
+            cerr << "Ignoring stale or unrecognized feature cache: " << path << endl;
+            return false;
+        }
+
+        vector<PrecomputedFeatures> loaded;
+        loaded.reserve(static_cast<size_t>(min<uint64_t>(count, 1 << 20)));
+
+        for (uint64_t n = 0; n < count; n++) {
+            PrecomputedFeatures entry;
+            uint32_t tokenCount;
+            if (!readString(in, entry.clientName) || !readString(in, entry.processedName) ||
+                !readValue(in, tokenCount) || tokenCount > MAX_STRING_LENGTH) {
+                return false;
+            }
+
+            entry.tokens.resize(tokenCount);
+            for (auto& token : entry.tokens) {
+                if (!readString(in, token)) {
+                    return false;
+                }
+            }
+            entry.tokenSet = unordered_set<string>(entry.tokens.begin(), entry.tokens.end());
+
+            entry.features.set_size(FEATURE_DIMENSION);
+            for (uint32_t i = 0; i < FEATURE_DIMENSION; i++) {
+                double value;
+                if (!readValue(in, value)) {
+                    return false;
+                }
+                entry.features(i) = value;
+            }
+
+            loaded.push_back(move(entry));
+        }
+
+        features = move(loaded);
+        return true;
+    }
+
+} // namespace TaxReturnSystem
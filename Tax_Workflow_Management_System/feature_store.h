@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include "Lacerte_cross_ref.h"
+#include "candidate_index.h"
+#include "project_snapshot.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Per-client matching features for the whole projects table, kept in step with the project snapshot
+    class FeatureStore {
+    public:
+        using PrecomputedFeatures = LacerteCrossReference::PrecomputedFeatures;
+
+        // Immutable set of features for one snapshot version, shared with running cross-references
+        struct FeatureSet {
+            vector<PrecomputedFeatures> features; // One entry per distinct client
+            unordered_map<string, uint32_t> byClient; // Client name to entry in features
+            CandidateIndex candidateIndex; // Blocking index over features, in the same order
+        };
+
+        // Bump when preprocessing or featurization changes so stale cache files are ignored
+        static constexpr uint32_t FORMAT_VERSION = 2;
+
+    private:
+        LacerteCrossReference& matcher; // Computes features for new clients
+        string cachePath; // Binary cache file; empty disables persistence
+
+        mutable mutex refreshMutex; // Serializes rebuilds and cache file writes; never taken while holding storeMutex
+        mutable mutex storeMutex; // Guards the fields below
+        shared_ptr<const FeatureSet> current; // Latest feature set
+        uint64_t currentVersion = 0; // Snapshot version current matches; 0 if not yet checked against a snapshot
+
+        static shared_ptr<const FeatureSet> makeSet(vector<PrecomputedFeatures> features); // Index a list of features
+
+    public:
+        FeatureStore(LacerteCrossReference& matcher, const string& cachePath = "client_features.bin") // Constructor
+            : matcher(matcher), cachePath(cachePath) {}
+
+        // Get features for the snapshot, featurizing only clients that are new since the last refresh
+        shared_ptr<const FeatureSet> getFeatures(const ProjectSnapshot& snapshot);
+
+        bool load(); // Warm the store from the cache file; returns false if it is missing or stale
+        bool save() const; // Write the current features to the cache file
+        size_t size() const; // Number of clients in the current feature set
+
+        // Binary cache format shared with benchmarkPrecompute
+        static bool saveToFile(const string& path, const vector<PrecomputedFeatures>& features);
+        static bool loadFromFile(const string& path, vector<PrecomputedFeatures>& features);
+    };
+
+} // namespace TaxReturnSystem
@@ -7,12 +7,17 @@
  * - Timestamp generation
  * - Event logging with automatic file handling
  *
- * The Logger class provides thread-safe logging capabilities
- * with automatic file management and timestamp formatting.
+ * Logging is asynchronous. log() claims a slot of a bounded ring buffer
+ * with one atomic compare-and-swap and copies the event into it; request
+ * threads never format timestamps or touch the file. A background writer
+ * drains the ring into one buffer, formats timestamps once per second and
+ * writes and flushes the file once per batch, either when WRITE_BATCH
+ * events are waiting or every FLUSH_INTERVAL. When the ring is full log()
+ * wakes the writer and yields until a slot frees up, so events are never
+ * dropped. The destructor writes everything still queued.
  */
 
 #include "logger.h"
-#include <ctime>
 
 using namespace std;
 
@@ -21,12 +26,23 @@ namespace TaxReturnSystem {
 // LOGGER CLASS METHODS:
 
     // Definition of constructor; takes filename as parameter
-    Logger::Logger(const string &filename) {
+    Logger::Logger(const string &filename) : slots(new Slot[CAPACITY]) {
         logFile.open(filename, ios::app); // Open file in append mode
+        for (size_t i = 0; i < CAPACITY; i++) {
+            slots[i].sequence.store(i, memory_order_relaxed);
+        }
+        writer = thread(&Logger::writerLoop, this);
     }
 
-    // Definition of destructor; ensures file is closed if still open
+    // Definition of destructor; writes pending events and closes the file
     Logger::~Logger() {
+        {
+            lock_guard<mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+
         if (logFile.is_open()) {
             logFile.close(); // Close the file if it's open
         }
@@ -34,12 +50,118 @@ namespace TaxReturnSystem {
 
     // Definition of method to log an event; takes event description as parameter
     void Logger::log(const string &event) {
-        if (logFile.is_open()) {
-            time_t now = time(0); // Get current time
-            char timestamp[20];
-            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now)); // Format timestamp
-            logFile << timestamp << " - " << event << endl; // Write timestamp and event to log file
+        if (!logFile.is_open()) {
+            return;
+        }
+
+        // Claim a slot; a slot is free for position pos when its sequence equals pos
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[pos & (CAPACITY - 1)];
+            size_t sequence = slot->sequence.load(memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (difference == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // Ring is full: let the writer catch up
+                wake.notify_one();
+                this_thread::yield();
+                pos = enqueuePos.load(memory_order_relaxed);
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+
+        slot->time = time(nullptr);
+        slot->event.assign(event);
+        slot->sequence.store(pos + 1, memory_order_release);
+
+        if (((pos + 1) & (WRITE_BATCH - 1)) == 0) {
+            wake.notify_one();
+        }
+    }
+
+    // Definition of method to wait until earlier events are on disk; takes no parameters; returns void
+    void Logger::flush() {
+        size_t target = enqueuePos.load(memory_order_acquire);
+        unique_lock<mutex> lock(wakeMutex);
+        if (writtenPos >= target) {
+            return;
+        }
+        if (flushTarget < target) {
+            flushTarget = target;
+        }
+        wake.notify_one();
+        written.wait(lock, [&]() { return writtenPos >= target; });
+    }
+
+    // Definition of method to format a timestamp, reusing the text while the second is unchanged; takes a time as parameter; returns C string
+    const char* Logger::formatTimestamp(time_t time) {
+        if (time != cachedSecond) {
+            tm local{};
+            localtime_r(&time, &local);
+            strftime(cachedTimestamp, sizeof(cachedTimestamp), "%Y-%m-%d %H:%M:%S", &local);
+            cachedSecond = time;
+        }
+        return cachedTimestamp;
+    }
+
+    // Definition of method to move published events into a batch; takes the batch buffer as parameter; returns whether a claimed slot is still being filled
+    bool Logger::drain(string& batch) {
+        while (true) {
+            Slot& slot = slots[dequeuePos & (CAPACITY - 1)];
+            size_t sequence = slot.sequence.load(memory_order_acquire);
+            if (sequence != dequeuePos + 1) {
+                // Either nothing more was logged, or a producer claimed this slot and is still copying into it
+                return dequeuePos != enqueuePos.load(memory_order_acquire);
+            }
+
+            batch.append(formatTimestamp(slot.time)).append(" - ").append(slot.event).push_back('\n');
+            slot.sequence.store(dequeuePos + CAPACITY, memory_order_release);
+            dequeuePos++;
+        }
+    }
+
+    // Definition of the writer thread body; takes no parameters; returns void
+    void Logger::writerLoop() {
+        string batch;
+        bool pending = false; // A claimed slot was still being filled at the last drain
+
+        while (true) {
+            bool stop;
+            {
+                unique_lock<mutex> lock(wakeMutex);
+                if (!pending) {
+                    wake.wait_for(lock, FLUSH_INTERVAL, [&]() {
+                        return stopping || flushTarget > writtenPos ||
+                               enqueuePos.load(memory_order_relaxed) - dequeuePos >= WRITE_BATCH;
+                    });
+                }
+                stop = stopping;
+            }
+
+            batch.clear();
+            pending = drain(batch);
+            if (!batch.empty()) {
+                logFile.write(batch.data(), static_cast<streamsize>(batch.size()));
+                logFile.flush();
+            }
+
+            {
+                lock_guard<mutex> lock(wakeMutex);
+                writtenPos = dequeuePos;
+            }
+            written.notify_all();
+
+            if (pending) {
+                this_thread::yield();
+            } else if (stop) {
+                return;
+            }
         }
     }
 
-}
\ No newline at end of file
+}
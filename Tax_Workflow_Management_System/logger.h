@@ -2,20 +2,63 @@
 
 #include <fstream>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <condition_variable>
 
 using namespace std;
 
 namespace TaxReturnSystem {
 
+    // Asynchronous file logger: callers enqueue into a lock-free ring buffer and a background thread writes in batches
     class Logger {
     private:
-        ofstream logFile; // File stream for logging
+        // One ring buffer slot; sequence tells producers and the writer whose turn the slot is
+        struct Slot {
+            atomic<size_t> sequence{0}; // Position the slot is free for, or position + 1 once filled
+            time_t time = 0; // When the event was logged
+            string event; // Event text; its buffer is reused by later events
+        };
+
+        static constexpr size_t CAPACITY = 4096; // Ring buffer slots; power of two
+        static constexpr size_t WRITE_BATCH = 256; // Events that wake the writer early
+        static constexpr chrono::milliseconds FLUSH_INTERVAL{200}; // Longest time an event waits before being written
+
+        ofstream logFile; // File stream for logging; only the writer thread touches it after construction
+        unique_ptr<Slot[]> slots; // Ring buffer
+        atomic<size_t> enqueuePos{0}; // Next position producers claim
+        size_t dequeuePos = 0; // Next position the writer reads; writer thread only
+
+        mutex wakeMutex; // Guards the fields below and pairs with the condition variables
+        condition_variable wake; // Wakes the writer
+        condition_variable written; // Signals flush() callers after a batch is written
+        size_t writtenPos = 0; // Every event before this position is in the file
+        size_t flushTarget = 0; // Position flush() callers are waiting for
+        bool stopping = false; // Set by the destructor
+        thread writer; // Background writer
+
+        // Cached timestamp text of the last second formatted; writer thread only
+        time_t cachedSecond = -1;
+        char cachedTimestamp[20] = {};
+
+        void writerLoop(); // Body of the writer thread
+        bool drain(string& batch); // Move every published event into batch; returns whether a claimed slot is still being filled
+        const char* formatTimestamp(time_t time); // Timestamp text of a second, formatted once per second
 
     public:
         // Core logging methods
-        Logger(const string &filename); // Initialize logger with file
-        ~Logger(); // Clean up and close log file
-        void log(const string &event); // Log event with timestamp
+        Logger(const string &filename); // Initialize logger with file and start the writer
+        ~Logger(); // Write pending events and close log file
+        void log(const string &event); // Log event with timestamp; never waits on the disk
+        void flush(); // Block until every event logged before the call is written and flushed
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
     };
 
-} // namespace TaxReturnSystem
\ No newline at end of file
+} // namespace TaxReturnSystem
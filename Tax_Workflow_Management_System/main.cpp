@@ -28,6 +28,9 @@
 #include <inja/inja.hpp>
 #include <nlohmann/json.hpp>
 #include "Lacerte_cross_ref.h"
+#include "feature_store.h"
+#include "cross_reference_jobs.h"
+#include "project_snapshot.h"
 
 using namespace std;
 
@@ -36,9 +39,6 @@ using namespace TaxReturnSystem;
 // Global shared pointer to CSV data
 shared_ptr<Project> globalCsvData;
 
-// Global ReminderSystem object
-ReminderSystem reminderSystem;
-
 int main() {
     try {
         cout << "Starting the application..." << endl;
@@ -53,12 +53,13 @@ int main() {
         UserDatabase userDatabase("./users.db");
         cout << "UserDatabase initialized successfully." << endl;
 
+        // The only instance on projects.db: it owns the single writer connection, the snapshot and the caches
         cout << "Initializing ProjectsDatabase..." << endl;
         ProjectsDatabase projectsDatabase("./projects.db");
         cout << "ProjectsDatabase initialized successfully." << endl;
 
         cout << "Initializing ProjectManager..." << endl;
-        ProjectManager projectManager("./projects.db");
+        ProjectManager projectManager(projectsDatabase);
 
         // Import CSV data
         cout << "Importing CSV data..." << endl;
@@ -88,6 +89,8 @@ int main() {
         cout << "Initializing LacerteCrossReference..." << endl;
         LacerteCrossReference lacerteCrossRef(projectsDatabase);
         try {
+            // Bring the training file up to date with feedback recorded by earlier runs
+            projectsDatabase.exportFeedbackToTrainingFile("training_data.csv");
             lacerteCrossRef.loadTrainingData("training_data.csv");
             lacerteCrossRef.trainModel();
             cout << "LacerteCrossReference model trained successfully." << endl;
@@ -96,17 +99,32 @@ int main() {
             return 1;
         }
 
+        cout << "Warming client feature store..." << endl;
+        FeatureStore featureStore(lacerteCrossRef, "client_features.bin");
+        if (!featureStore.load()) {
+            cout << "No usable feature cache; client features will be computed now." << endl;
+        }
+        featureStore.getFeatures(*projectManager.getSnapshot());
+        cout << "Client feature store ready." << endl;
+
+        cout << "Starting cross-reference job workers..." << endl;
+        CrossReferenceJobManager crossReferenceJobs(lacerteCrossRef, featureStore, projectManager);
+        cout << "Cross-reference job workers started." << endl;
+
         cout << "Initializing ReminderSystem..." << endl;
-        ReminderSystem reminderSystem;
+        ReminderSystem reminderSystem(&emailService, &userDatabase);
         cout << "ReminderSystem initialized successfully." << endl;
 
         cout << "Setting up routes..." << endl;
-        setupRoutes(app, auth, reminderSystem, projectManager, lacerteCrossRef, projectsDatabase);
+        setupRoutes(app, auth, reminderSystem, projectManager, lacerteCrossRef, crossReferenceJobs, projectsDatabase);
         cout << "Routes set up successfully." << endl;
 
         // Run the app on localhost port 8080
         cout << "Starting the server on port 8080..." << endl;
         app.port(8080).multithreaded().run();
+
+        // Put every queued auth event on disk before the objects that log are torn down
+        logger.flush();
     }
     catch (const exception& e) {
         cerr << "An error occurred: " << e.what() << endl;
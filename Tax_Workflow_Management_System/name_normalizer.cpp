@@ -0,0 +1,178 @@
+/**
+ * @file name_normalizer.cpp
+ * @brief Implementation of the client name normalizer used for cross-referencing
+ *
+ * This file contains implementations for:
+ * - A byte classification table for lowercasing and separators
+ * - A trie of business designators built at compile time
+ * - The single-pass normalizer
+ *
+ * Each byte is looked up once in the classification table and, while it is
+ * part of a token, advances the designator trie by one step. When a token
+ * ends in an accepting trie state, the output is truncated back to the
+ * token's start, so designators are removed as whole tokens only ("co" in
+ * "cooper" is kept). Dotted initialisms such as "l.l.c." or "j.p." are read
+ * as one token ("llc", "jp").
+ */
+
+#include "name_normalizer.h"
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Tokens dropped from names before matching
+        constexpr string_view BUSINESS_DESIGNATORS[] = {
+                "llc", "ltd", "inc", "corp", "corporation", "incorporated",
+                "limited", "company", "co", "lp", "llp"
+        };
+
+        constexpr size_t TRIE_CAPACITY = 64;
+        constexpr int16_t NO_NODE = -1;
+
+        struct TrieNode {
+            int16_t next[26]; // Child for each letter a-z, or NO_NODE
+            bool accepting; // A designator ends here
+        };
+
+        struct DesignatorTrie {
+            array<TrieNode, TRIE_CAPACITY> nodes;
+            size_t size;
+        };
+
+        constexpr DesignatorTrie buildDesignatorTrie() {
+            DesignatorTrie trie{};
+            for (size_t n = 0; n < TRIE_CAPACITY; n++) {
+                for (int c = 0; c < 26; c++) {
+                    trie.nodes[n].next[c] = NO_NODE;
+                }
+                trie.nodes[n].accepting = false;
+            }
+            trie.size = 1;
+
+            for (string_view word : BUSINESS_DESIGNATORS) {
+                size_t node = 0;
+                for (char ch : word) {
+                    int c = ch - 'a';
+                    if (trie.nodes[node].next[c] == NO_NODE) {
+                        trie.nodes[node].next[c] = static_cast<int16_t>(trie.size++);
+                    }
+                    node = static_cast<size_t>(trie.nodes[node].next[c]);
+                }
+                trie.nodes[node].accepting = true;
+            }
+            return trie;
+        }
+
+        constexpr DesignatorTrie DESIGNATOR_TRIE = buildDesignatorTrie();
+        static_assert(DESIGNATOR_TRIE.size <= TRIE_CAPACITY, "TRIE_CAPACITY is too small for BUSINESS_DESIGNATORS");
+
+        // Byte classes: separators collapse to one space; every other byte is kept, lowercased
+        constexpr uint8_t SEPARATOR = 0;
+        constexpr uint8_t DOT = 1;
+        constexpr uint8_t LETTER = 2;
+        constexpr uint8_t OTHER = 3;
+
+        struct ByteTable {
+            array<uint8_t, 256> kind;
+            array<char, 256> lower;
+        };
+
+        constexpr ByteTable buildByteTable() {
+            ByteTable table{};
+            for (int b = 0; b < 256; b++) {
+                table.kind[b] = OTHER;
+                table.lower[b] = static_cast<char>(b);
+            }
+            for (int b = 'A'; b <= 'Z'; b++) {
+                table.kind[b] = LETTER;
+                table.lower[b] = static_cast<char>(b - 'A' + 'a');
+            }
+            for (int b = 'a'; b <= 'z'; b++) {
+                table.kind[b] = LETTER;
+            }
+            for (unsigned char b : {',', ';', ':', '\'', '"', '-', '_', ' ', '\t', '\n', '\v', '\f', '\r'}) {
+                table.kind[b] = SEPARATOR;
+            }
+            table.kind[static_cast<unsigned char>('.')] = DOT;
+            return table;
+        }
+
+        constexpr ByteTable BYTE_TABLE = buildByteTable();
+
+        inline uint8_t kindAt(string_view name, size_t i) {
+            return i < name.size() ? BYTE_TABLE.kind[static_cast<unsigned char>(name[i])] : SEPARATOR;
+        }
+
+        // Advance the designator trie by one lowercase byte
+        inline int16_t step(int16_t node, char c) {
+            if (node == NO_NODE || c < 'a' || c > 'z') {
+                return NO_NODE;
+            }
+            return DESIGNATOR_TRIE.nodes[node].next[c - 'a'];
+        }
+
+    } // namespace
+
+// NAME NORMALIZER CLASS METHODS:
+
+    // Definition of a method to normalize a client name into a caller-provided buffer; takes a name and an output string as parameters; returns void
+    void NameNormalizer::normalize(string_view name, string& out) {
+        out.clear();
+        out.reserve(name.size());
+
+        size_t tokenStart = 0; // Output position where the current token (and its leading space) begins
+        size_t tokenLength = 0; // Bytes written for the current token
+        size_t tokenDots = 0; // Dots swallowed inside an initialism
+        int16_t node = 0; // Designator trie state for the current token
+
+        auto endToken = [&]() {
+            if (tokenLength > 0 && node != NO_NODE && DESIGNATOR_TRIE.nodes[node].accepting) {
+                out.resize(tokenStart);
+            }
+            tokenLength = 0;
+            tokenDots = 0;
+            node = 0;
+        };
+
+        for (size_t i = 0; i < name.size(); i++) {
+            unsigned char byte = static_cast<unsigned char>(name[i]);
+            uint8_t kind = BYTE_TABLE.kind[byte];
+
+            if (kind == DOT) {
+                // Inside an initialism ("l.l.c."), a dot that is followed by a single letter and another boundary joins the letters
+                bool initialism = tokenLength == tokenDots + 1 &&
+                                  kindAt(name, i + 1) == LETTER &&
+                                  (kindAt(name, i + 2) == DOT || kindAt(name, i + 2) == SEPARATOR);
+                if (initialism) {
+                    tokenDots++;
+                    continue;
+                }
+                kind = SEPARATOR;
+            }
+
+            if (kind == SEPARATOR) {
+                endToken();
+                continue;
+            }
+
+            if (tokenLength == 0) {
+                tokenStart = out.size();
+                if (!out.empty()) {
+                    out.push_back(' ');
+                }
+            }
+
+            char c = BYTE_TABLE.lower[byte];
+            out.push_back(c);
+            tokenLength++;
+            node = step(node, c);
+        }
+        endToken();
+    }
+
+} // namespace TaxReturnSystem
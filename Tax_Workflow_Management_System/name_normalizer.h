@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Single-pass client name normalizer: lowercases, collapses punctuation and drops business designators
+    class NameNormalizer {
+    public:
+        // Write the normalized form of name into out, reusing its capacity; tokens are separated by single spaces
+        static void normalize(string_view name, string& out);
+
+        static string normalize(string_view name) { // Convenience overload returning a new string
+            string out;
+            normalize(name, out);
+            return out;
+        }
+    };
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,151 @@
+/**
+ * @file project_filter.cpp
+ * @brief Implementation of compiled project filters
+ *
+ * This file contains implementations for:
+ * - Resolving filter criteria to dictionary codes and deadline ranges
+ * - Choosing the most selective snapshot index
+ * - Evaluating all criteria in a single pass
+ */
+
+#include "project_filter.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+// PROJECT FILTER CLASS METHODS:
+
+    // Definition of the constructor; takes a snapshot and filter criteria as parameters
+    ProjectFilter::ProjectFilter(shared_ptr<const ProjectSnapshot> snapshot, const FilterCriteria& criteria)
+        : snapshot(move(snapshot)), criteria(criteria) {
+        const ProjectSnapshot& data = *this->snapshot;
+
+        // Resolve a dictionary criterion to its code; a value that never occurs can match nothing
+        auto resolve = [this](const optional<string>& value, const StringDictionary& dictionary) -> optional<uint32_t> {
+            if (!value) {
+                return nullopt;
+            }
+            optional<uint32_t> code = dictionary.find(*value);
+            if (!code) {
+                matchesNothing = true;
+            }
+            return code;
+        };
+
+        groupCode = resolve(criteria.group, data.getGroups());
+        managerCode = resolve(criteria.manager, data.getManagers());
+        partnerCode = resolve(criteria.partner, data.getPartners());
+        nextTaskCode = resolve(criteria.nextTask, data.getNextTasks());
+
+        if (matchesNothing) {
+            return;
+        }
+
+        // The start/end range applies to the regular deadline, and only when both ends are set
+        if (criteria.startDate && criteria.endDate) {
+            regularRange = make_pair(criteria.startDate->getValue(), criteria.endDate->getValue());
+        }
+        if (criteria.regularDeadline) {
+            int value = criteria.regularDeadline->getValue();
+            regularRange = regularRange ? make_pair(max(regularRange->first, value), min(regularRange->second, value))
+                                        : make_pair(value, value);
+        }
+        if (criteria.internalDeadline) {
+            int value = criteria.internalDeadline->getValue();
+            internalRange = make_pair(value, value);
+        }
+
+        if (regularRange && regularRange->first > regularRange->second) {
+            matchesNothing = true;
+            return;
+        }
+
+        // Drive the scan from whichever index yields the fewest rows
+        auto consider = [this](RowRange range) {
+            if (scanAll || range.size() < candidates.size()) {
+                candidates = range;
+                scanAll = false;
+            }
+        };
+
+        if (groupCode) consider(data.getGroupRows(*groupCode));
+        if (managerCode) consider(data.getManagerRows(*managerCode));
+        if (partnerCode) consider(data.getPartnerRows(*partnerCode));
+        if (nextTaskCode) consider(data.getNextTaskRows(*nextTaskCode));
+        if (regularRange) consider(data.getRegularDeadlineRows(regularRange->first, regularRange->second));
+        if (internalRange) consider(data.getInternalDeadlineRows(internalRange->first, internalRange->second));
+    }
+
+    // Definition of a method to check one row against every criterion; takes a row index as parameter; returns bool
+    bool ProjectFilter::matches(size_t row) const {
+        const ProjectSnapshot& data = *snapshot;
+
+        if (groupCode && data.getGroupCode(row) != *groupCode) return false;
+        if (managerCode && data.getManagerCode(row) != *managerCode) return false;
+        if (partnerCode && data.getPartnerCode(row) != *partnerCode) return false;
+        if (nextTaskCode && data.getNextTaskCode(row) != *nextTaskCode) return false;
+
+        if (regularRange) {
+            int deadline = data.getRegularDeadlineValue(row);
+            if (deadline < regularRange->first || deadline > regularRange->second) return false;
+        }
+        if (internalRange) {
+            int deadline = data.getInternalDeadlineValue(row);
+            if (deadline < internalRange->first || deadline > internalRange->second) return false;
+        }
+
+        if (criteria.reportType && data.getReportType(row) != *criteria.reportType) return false;
+        if (criteria.extended && data.isExtended(row) != *criteria.extended) return false;
+        if (criteria.projectType && data.getProjectType(row) != *criteria.projectType) return false;
+        if (criteria.billingPartner && data.getBillingPartner(row) != *criteria.billingPartner) return false;
+
+        return true;
+    }
+
+    // Definition of a method to collect the matching rows; takes no parameters; returns vector of row indexes in table order
+    vector<uint32_t> ProjectFilter::getRows() const {
+        vector<uint32_t> rows;
+        if (matchesNothing) {
+            return rows;
+        }
+
+        if (scanAll) {
+            for (uint32_t row = 0; row < snapshot->size(); row++) {
+                if (matches(row)) {
+                    rows.push_back(row);
+                }
+            }
+            return rows;
+        }
+
+        rows.reserve(candidates.size());
+        for (uint32_t row : candidates) {
+            if (matches(row)) {
+                rows.push_back(row);
+            }
+        }
+
+        // Deadline indexes are ordered by date rather than by row
+        if ((regularRange || internalRange) && !is_sorted(rows.begin(), rows.end())) {
+            sort(rows.begin(), rows.end());
+        }
+
+        return rows;
+    }
+
+    // Definition of a method to materialize the matching rows; takes no parameters; returns vector of Projects
+    vector<Project> ProjectFilter::getProjects() const {
+        vector<Project> projects;
+        vector<uint32_t> rows = getRows();
+        projects.reserve(rows.size());
+
+        for (uint32_t row : rows) {
+            projects.push_back(snapshot->toProject(row));
+        }
+
+        return projects;
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include "CSV_management.h"
+#include "project_snapshot.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // FilterCriteria compiled against one snapshot; immutable and safe to share between threads
+    class ProjectFilter {
+    private:
+        shared_ptr<const ProjectSnapshot> snapshot; // Snapshot the filter was compiled for
+        FilterCriteria criteria; // Criteria the filter was compiled from
+
+        bool matchesNothing = false; // True when a criterion names a value that is not in the snapshot
+
+        // Dictionary-encoded criteria
+        optional<uint32_t> groupCode, managerCode, partnerCode, nextTaskCode;
+
+        // Deadline criteria as inclusive YYYYMMDD bounds
+        optional<pair<int, int>> regularRange, internalRange;
+
+        RowRange candidates; // Smallest index range that covers every match
+        bool scanAll = true; // True when no index narrows the search
+
+    public:
+        ProjectFilter(shared_ptr<const ProjectSnapshot> snapshot, const FilterCriteria& criteria); // Constructor
+
+        bool matches(size_t row) const; // Check every criterion against one row
+        vector<uint32_t> getRows() const; // Get matching rows in table order
+        vector<Project> getProjects() const; // Materialize matching rows as Projects
+
+        const ProjectSnapshot& getSnapshot() const { return *snapshot; } // Get the snapshot the filter runs against
+        const FilterCriteria& getCriteria() const { return criteria; } // Get the criteria the filter was built from
+    };
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,173 @@
+/**
+ * @file project_snapshot.cpp
+ * @brief Implementation of the in-memory columnar project snapshot
+ *
+ * This file contains implementations for:
+ * - String dictionary encoding
+ * - Building snapshot columns row by row
+ * - Row indexes by dictionary code and by deadline
+ * - Materializing snapshot rows back into Project objects
+ *
+ * A snapshot is built once from the projects table and shared read-only
+ * between requests until the underlying data changes.
+ */
+
+#include "project_snapshot.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+// STRING DICTIONARY CLASS METHODS:
+
+    // Definition of a method to get the code for a value, interning it if needed; takes a string as parameter; returns uint32_t
+    uint32_t StringDictionary::encode(const string& value) {
+        auto it = codes.find(value);
+        if (it != codes.end()) {
+            return it->second;
+        }
+
+        uint32_t code = static_cast<uint32_t>(values.size());
+        values.push_back(value);
+        codes.emplace(value, code);
+        return code;
+    }
+
+    // Definition of a method to look up the code for a value without interning it; takes a string as parameter; returns optional uint32_t
+    optional<uint32_t> StringDictionary::find(const string& value) const {
+        auto it = codes.find(value);
+        if (it == codes.end()) {
+            return nullopt;
+        }
+        return it->second;
+    }
+
+// PROJECT SNAPSHOT CLASS METHODS:
+
+    // Definition of a method to append a row to all columns; takes every project field as parameter; returns void
+    void ProjectSnapshot::appendRow(const string& id, const string& group, const string& client, const string& projectType,
+                                    const string& billingPartner, const string& partner, const string& manager,
+                                    const string& nextTask, const string& memo, const Date& regularDeadline,
+                                    const Date& internalDeadline, bool extended, ReportType reportType) {
+        ids.push_back(id);
+        clients.push_back(client);
+        projectTypes.push_back(projectType);
+        billingPartners.push_back(billingPartner);
+        memos.push_back(memo);
+
+        uint32_t row = static_cast<uint32_t>(ids.size() - 1);
+
+        groupCodes.push_back(groups.encode(group));
+        managerCodes.push_back(managers.encode(manager));
+        partnerCodes.push_back(partners.encode(partner));
+        nextTaskCodes.push_back(nextTasks.encode(nextTask));
+
+        // Parse the status only the first time a next task value is seen
+        if (nextTaskCodes.back() == taskStatusByCode.size()) {
+            taskStatusByCode.push_back(parseTaskStatus(nextTask));
+        }
+        taskStatuses.push_back(taskStatusByCode[nextTaskCodes.back()]);
+
+        addPosting(groupRows, groupCodes.back(), row);
+        addPosting(managerRows, managerCodes.back(), row);
+        addPosting(partnerRows, partnerCodes.back(), row);
+        addPosting(nextTaskRows, nextTaskCodes.back(), row);
+
+        regularDeadlines.push_back(regularDeadline.getValue());
+        internalDeadlines.push_back(internalDeadline.getValue());
+
+        extendedFlags.push_back(extended ? 1 : 0);
+        reportTypes.push_back(static_cast<uint8_t>(reportType));
+    }
+
+    // Definition of a method to record a row under a dictionary code; takes the postings, a code and a row as parameters; returns void
+    void ProjectSnapshot::addPosting(vector<vector<uint32_t>>& postings, uint32_t code, uint32_t row) {
+        if (code >= postings.size()) {
+            postings.resize(code + 1);
+        }
+        postings[code].push_back(row);
+    }
+
+    // Definition of a method to build the deadline-ordered row indexes; takes no parameters; returns void
+    void ProjectSnapshot::buildIndexes() {
+        auto sortByDeadline = [this](vector<uint32_t>& order, const vector<int>& deadlines) {
+            order.resize(size());
+            for (uint32_t row = 0; row < order.size(); row++) {
+                order[row] = row;
+            }
+            // Stable so rows sharing a deadline stay in table order
+            stable_sort(order.begin(), order.end(), [&deadlines](uint32_t a, uint32_t b) {
+                return deadlines[a] < deadlines[b];
+            });
+        };
+
+        sortByDeadline(rowsByRegularDeadline, regularDeadlines);
+        sortByDeadline(rowsByInternalDeadline, internalDeadlines);
+    }
+
+    // Definition of a method to find the rows whose deadline falls in a range; takes an ordering, a deadline column and two YYYYMMDD values as parameters; returns RowRange
+    RowRange ProjectSnapshot::deadlineRange(const vector<uint32_t>& order, const vector<int>& deadlines, int from, int to) {
+        auto first = lower_bound(order.begin(), order.end(), from, [&deadlines](uint32_t row, int value) {
+            return deadlines[row] < value;
+        });
+        auto last = upper_bound(first, order.end(), to, [&deadlines](int value, uint32_t row) {
+            return value < deadlines[row];
+        });
+        return RowRange{order.data() + (first - order.begin()), order.data() + (last - order.begin())};
+    }
+
+    // Definition of methods to look up the rows for a dictionary code; take a code as parameter; return RowRange
+    static RowRange postingRange(const vector<vector<uint32_t>>& postings, uint32_t code) {
+        if (code >= postings.size()) {
+            return RowRange();
+        }
+        return RowRange{postings[code].data(), postings[code].data() + postings[code].size()};
+    }
+
+    RowRange ProjectSnapshot::getGroupRows(uint32_t code) const { return postingRange(groupRows, code); }
+    RowRange ProjectSnapshot::getManagerRows(uint32_t code) const { return postingRange(managerRows, code); }
+    RowRange ProjectSnapshot::getPartnerRows(uint32_t code) const { return postingRange(partnerRows, code); }
+    RowRange ProjectSnapshot::getNextTaskRows(uint32_t code) const { return postingRange(nextTaskRows, code); }
+
+    // Definition of methods to look up the rows in a deadline range; take two YYYYMMDD values as parameters; return RowRange
+    RowRange ProjectSnapshot::getRegularDeadlineRows(int from, int to) const {
+        return deadlineRange(rowsByRegularDeadline, regularDeadlines, from, to);
+    }
+
+    RowRange ProjectSnapshot::getInternalDeadlineRows(int from, int to) const {
+        return deadlineRange(rowsByInternalDeadline, internalDeadlines, from, to);
+    }
+
+    // Definition of a method to materialize a single row as a Project; takes a row index as parameter; returns Project
+    Project ProjectSnapshot::toProject(size_t row) const {
+        Project project;
+        project.setId(ids[row]);
+        project.setGroup(getGroup(row));
+        project.setClient(clients[row]);
+        project.setProjectType(projectTypes[row]);
+        project.setBillingPartner(billingPartners[row]);
+        project.setPartner(getPartner(row));
+        project.setManager(getManager(row));
+        project.setNextTask(getNextTask(row), taskStatuses[row]);
+        project.setMemo(memos[row]);
+        project.setRegularDeadline(getRegularDeadline(row));
+        project.setInternalDeadline(getInternalDeadline(row));
+        project.setExtended(isExtended(row));
+        project.setReportType(getReportType(row));
+        return project;
+    }
+
+    // Definition of a method to materialize every row as Projects; takes no parameters; returns vector of Projects
+    vector<Project> ProjectSnapshot::toProjects() const {
+        vector<Project> projects;
+        projects.reserve(size());
+
+        for (size_t row = 0; row < size(); row++) {
+            projects.push_back(toProject(row));
+        }
+
+        return projects;
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include "CSV_management.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Interns repeated string values and hands out dense integer codes for them
+    class StringDictionary {
+    private:
+        vector<string> values; // Distinct values, indexed by code
+        unordered_map<string, uint32_t> codes; // Value to code mapping
+
+    public:
+        uint32_t encode(const string& value); // Get the code for a value, adding it if it is new
+        optional<uint32_t> find(const string& value) const; // Get the code for a value without adding it
+        const string& decode(uint32_t code) const { return values[code]; } // Get the value for a code
+        size_t size() const { return values.size(); } // Number of distinct values
+        const vector<string>& getValues() const { return values; } // All distinct values in code order
+    };
+
+    // Contiguous run of row numbers inside one of the snapshot indexes
+    struct RowRange {
+        const uint32_t* first = nullptr;
+        const uint32_t* last = nullptr;
+
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    // Immutable, column-oriented copy of the projects table
+    class ProjectSnapshot {
+    private:
+        uint64_t version; // Version of the data this snapshot was built from
+
+        // Plain string columns
+        vector<string> ids, clients, projectTypes, billingPartners, memos;
+
+        // Dictionary-encoded columns
+        StringDictionary groups, managers, partners, nextTasks;
+        vector<uint32_t> groupCodes, managerCodes, partnerCodes, nextTaskCodes;
+
+        // Deadline columns stored in YYYYMMDD form
+        vector<int> regularDeadlines, internalDeadlines;
+
+        // Flag columns
+        vector<uint8_t> extendedFlags, reportTypes;
+
+        // Interned next task per row, and per next task dictionary code so each distinct value is parsed once
+        vector<TaskStatus> taskStatuses, taskStatusByCode;
+
+        // Row indexes: ascending row numbers per dictionary code, and rows ordered by deadline
+        vector<vector<uint32_t>> groupRows, managerRows, partnerRows, nextTaskRows;
+        vector<uint32_t> rowsByRegularDeadline, rowsByInternalDeadline;
+
+        static void addPosting(vector<vector<uint32_t>>& postings, uint32_t code, uint32_t row); // Record a row under a dictionary code
+        static RowRange deadlineRange(const vector<uint32_t>& order, const vector<int>& deadlines, int from, int to); // Rows whose deadline is in [from, to]
+
+    public:
+        explicit ProjectSnapshot(uint64_t version) : version(version) {} // Constructor
+
+        // Append one row to every column; used while the snapshot is being built
+        void appendRow(const string& id, const string& group, const string& client, const string& projectType,
+                       const string& billingPartner, const string& partner, const string& manager,
+                       const string& nextTask, const string& memo, const Date& regularDeadline,
+                       const Date& internalDeadline, bool extended, ReportType reportType);
+        void buildIndexes(); // Sort the deadline indexes; called once after the last row is appended
+
+        uint64_t getVersion() const { return version; } // Get snapshot version
+        size_t size() const { return ids.size(); } // Get number of rows
+
+        // Row accessors
+        const string& getId(size_t row) const { return ids[row]; }
+        const string& getClient(size_t row) const { return clients[row]; }
+        const string& getProjectType(size_t row) const { return projectTypes[row]; }
+        const string& getBillingPartner(size_t row) const { return billingPartners[row]; }
+        const string& getMemo(size_t row) const { return memos[row]; }
+        const string& getGroup(size_t row) const { return groups.decode(groupCodes[row]); }
+        const string& getManager(size_t row) const { return managers.decode(managerCodes[row]); }
+        const string& getPartner(size_t row) const { return partners.decode(partnerCodes[row]); }
+        const string& getNextTask(size_t row) const { return nextTasks.decode(nextTaskCodes[row]); }
+        Date getRegularDeadline(size_t row) const { return Date::fromValue(regularDeadlines[row]); }
+        Date getInternalDeadline(size_t row) const { return Date::fromValue(internalDeadlines[row]); }
+        bool isExtended(size_t row) const { return extendedFlags[row] != 0; }
+        TaskStatus getTaskStatus(size_t row) const { return taskStatuses[row]; }
+        ReportType getReportType(size_t row) const { return static_cast<ReportType>(reportTypes[row]); }
+
+        // Dictionary code accessors
+        uint32_t getGroupCode(size_t row) const { return groupCodes[row]; }
+        uint32_t getManagerCode(size_t row) const { return managerCodes[row]; }
+        uint32_t getPartnerCode(size_t row) const { return partnerCodes[row]; }
+        uint32_t getNextTaskCode(size_t row) const { return nextTaskCodes[row]; }
+
+        // Raw YYYYMMDD deadline accessors
+        int getRegularDeadlineValue(size_t row) const { return regularDeadlines[row]; }
+        int getInternalDeadlineValue(size_t row) const { return internalDeadlines[row]; }
+
+        // Index lookups
+        RowRange getGroupRows(uint32_t code) const; // Rows with the given group code
+        RowRange getManagerRows(uint32_t code) const; // Rows with the given manager code
+        RowRange getPartnerRows(uint32_t code) const; // Rows with the given partner code
+        RowRange getNextTaskRows(uint32_t code) const; // Rows with the given next task code
+        RowRange getRegularDeadlineRows(int from, int to) const; // Rows whose regular deadline is in [from, to]
+        RowRange getInternalDeadlineRows(int from, int to) const; // Rows whose internal deadline is in [from, to]
+
+        // Dictionaries, for listing distinct values without scanning rows
+        const StringDictionary& getGroups() const { return groups; }
+        const StringDictionary& getManagers() const { return managers; }
+        const StringDictionary& getPartners() const { return partners; }
+        const StringDictionary& getNextTasks() const { return nextTasks; }
+
+        Project toProject(size_t row) const; // Materialize one row as a Project
+        vector<Project> toProjects() const; // Materialize every row as Projects
+    };
+
+} // namespace TaxReturnSystem
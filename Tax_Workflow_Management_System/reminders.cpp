@@ -7,19 +7,29 @@
  * - Logging reminder system events
  * - Adding, removing, and retrieving reminders
  * - Loading reminders from CSV files
- * - Sending email reminders (placeholder)
+ * - Scheduling reminders and emailing them at their due time
  *
  * The ReminderSystem class provides comprehensive functionality for handling
- * project reminders, including logging, CSV integration, and basic email notification.
+ * project reminders, including logging, CSV integration, and email notification.
+ *
+ * Reminders are stored by id with per-project and per-user indexes, and in
+ * two sets ordered by due date: all reminders, and those not fired yet. A
+ * scheduler thread sleeps until the earliest unfired due date, takes every
+ * reminder that is due from the front of the pending set and queues its
+ * email, so nothing is ever found by scanning the whole collection.
  */
 
 #include "reminders.h"
+#include "csv_reader.h"
+#include "email_service.h"
+#include "user_database.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
 #include <iomanip>
+#include <cstdint>
 
 namespace TaxReturnSystem {
 
@@ -47,15 +57,25 @@ namespace TaxReturnSystem {
         return userName;
     }
 
-    // Definition of a constructor to initialize reminder system and logging; takes no parameters; returns nothing
-    ReminderSystem::ReminderSystem() {
+    // Definition of a constructor to initialize reminder system, logging and the scheduler; takes the email service and user database as parameters; returns nothing
+    ReminderSystem::ReminderSystem(EmailService* emailService, UserDatabase* userDatabase)
+            : emailService(emailService), userDatabase(userDatabase) {
         // Open log file in append mode
         logFile.open("reminder_system.log", ios::app);
+        scheduler = thread(&ReminderSystem::schedulerLoop, this);
         log("ReminderSystem initialized");
     }
 
     // Definition of a destructor to clean up reminder system resources; takes no parameters; returns nothing
     ReminderSystem::~ReminderSystem() {
+        // Stop the scheduler; reminders not fired yet are dropped with the system
+        {
+            lock_guard<mutex> lock(remindersMutex);
+            stopping = true;
+        }
+        schedulerWake.notify_one();
+        scheduler.join();
+
         // Close log file if it's open
         if (logFile.is_open()) {
             logFile.close();
@@ -65,9 +85,11 @@ namespace TaxReturnSystem {
     // Definition of a method to log system messages with timestamps; takes a string as parameter; returns void
     void ReminderSystem::log(const string& message) const {
         // Write timestamped message to log file if it's open
+        lock_guard<mutex> lock(logMutex);
         if (logFile.is_open()) {
             time_t now = time(0);
-            logFile << ctime(&now) << ": " << message << endl;
+            char timestamp[26];
+            logFile << ctime_r(&now, timestamp) << ": " << message << endl;
         }
     }
 
@@ -77,8 +99,10 @@ namespace TaxReturnSystem {
         time_t time = chrono::system_clock::to_time_t(date);
 
         // Format date and time using stringstream
+        tm local{};
+        localtime_r(&time, &local);
         stringstream ss;
-        ss << put_time(localtime(&time), "%Y-%m-%d %H:%M:%S");
+        ss << put_time(&local, "%Y-%m-%d %H:%M:%S");
 
         return ss.str();
     }
@@ -86,8 +110,23 @@ namespace TaxReturnSystem {
     // Definition of a method to add a new reminder to the system; takes an int, a time_point, and two strings as parameters; returns void
     void ReminderSystem::addReminder(int projectId, const chrono::system_clock::time_point& dueDate, const string& message, const string& userName) {
         try {
-            // Create and add new reminder to the collection
-            reminders.emplace_back(projectId, dueDate, message, userName);
+            bool earliest;
+            {
+                lock_guard<mutex> lock(remindersMutex);
+
+                // Store the reminder and index it by project, user and due date
+                uint64_t id = nextReminderId++;
+                reminders.emplace(id, Reminder(projectId, dueDate, message, userName));
+                idsByProject[projectId].push_back(id);
+                idsByUser[userName].push_back(id);
+                byDueDate.emplace(dueDate, id);
+                earliest = pending.emplace(dueDate, id).first == pending.begin();
+            }
+
+            // The scheduler only needs waking when it is sleeping past this reminder's due date
+            if (earliest) {
+                schedulerWake.notify_one();
+            }
 
             // Log successful reminder creation
             log("Reminder added for project " + to_string(projectId) + " due " + formatDate(dueDate));
@@ -100,16 +139,33 @@ namespace TaxReturnSystem {
 
     // Definition of a method to remove all reminders for a project; takes an int as parameter; returns void
     void ReminderSystem::removeReminder(int projectId) {
-        // Store initial count of reminders
-        auto initialSize = reminders.size();
-
-        // Remove all reminders matching the project ID
-        reminders.erase(remove_if(reminders.begin(), reminders.end(),
-                                  [projectId](const Reminder& r) { return r.getProjectId() == projectId; }),
-                        reminders.end());
+        bool removed = false;
+        {
+            lock_guard<mutex> lock(remindersMutex);
+
+            auto ids = idsByProject.find(projectId);
+            if (ids != idsByProject.end()) {
+                for (uint64_t id : ids->second) {
+                    auto reminder = reminders.find(id);
+                    DueKey key(reminder->second.getDueDate(), id);
+                    byDueDate.erase(key);
+                    pending.erase(key);
+
+                    auto userIds = idsByUser.find(reminder->second.getUserName());
+                    userIds->second.erase(find(userIds->second.begin(), userIds->second.end(), id));
+                    if (userIds->second.empty()) {
+                        idsByUser.erase(userIds);
+                    }
+
+                    reminders.erase(reminder);
+                }
+                idsByProject.erase(ids);
+                removed = true;
+            }
+        }
 
         // Log result based on whether any reminders were removed
-        if (reminders.size() < initialSize) {
+        if (removed) {
             log("Reminder(s) removed for project " + to_string(projectId));
         } else {
             log("No reminders found to remove for project " + to_string(projectId));
@@ -121,10 +177,14 @@ namespace TaxReturnSystem {
         // Create vector to store matching reminders
         vector<Reminder> projectReminders;
 
-        // Collect all reminders for the specified project
-        for (const auto& reminder : reminders) {
-            if (reminder.getProjectId() == projectId) {
-                projectReminders.push_back(reminder);
+        // Collect the project's reminders through the project index
+        {
+            lock_guard<mutex> lock(remindersMutex);
+            auto ids = idsByProject.find(projectId);
+            if (ids != idsByProject.end()) {
+                for (uint64_t id : ids->second) {
+                    projectReminders.push_back(reminders.at(id));
+                }
             }
         }
 
@@ -142,10 +202,12 @@ namespace TaxReturnSystem {
         // Get current time for comparison
         auto now = chrono::system_clock::now();
 
-        // Collect all reminders that are past due
-        for (const auto& reminder : reminders) {
-            if (reminder.getDueDate() < now) {
-                overdueReminders.push_back(reminder);
+        // Overdue reminders are the front of the due date order, up to now
+        {
+            lock_guard<mutex> lock(remindersMutex);
+            auto last = byDueDate.lower_bound(DueKey(now, 0));
+            for (auto it = byDueDate.begin(); it != last; ++it) {
+                overdueReminders.push_back(reminders.at(it->second));
             }
         }
 
@@ -160,16 +222,97 @@ namespace TaxReturnSystem {
         // Log start of email sending process
         log("Sending email reminders for user " + userName + " (Role: " + userRole + ")");
 
+        // Collect the user's reminders through the user index
+        vector<Reminder> userReminders;
+        {
+            lock_guard<mutex> lock(remindersMutex);
+            auto ids = idsByUser.find(userName);
+            if (ids != idsByUser.end()) {
+                for (uint64_t id : ids->second) {
+                    userReminders.push_back(reminders.at(id));
+                }
+            }
+        }
+
         // Process each reminder for email sending
-        for (const auto& reminder : reminders) {
-            // TODO: Implement actual email sending logic
-            cout << "Sending email to " << reminder.getUserName() << " for project " << reminder.getProjectId() << endl;
+        for (const auto& reminder : userReminders) {
+            deliverReminder(reminder);
         }
 
         // Log completion of email sending
         log("Email reminders sent");
     }
 
+    // Definition of a method to get the email address of a reminder's user; takes a user name and an output string as parameters; returns bool
+    bool ReminderSystem::resolveEmail(const string& userName, string& email) const {
+        if (userName.find('@') != string::npos) {
+            email = userName;
+            return true;
+        }
+        return userDatabase && userDatabase->getUserEmailFromDatabase(userName, email);
+    }
+
+    // Definition of a method to email a reminder; takes a Reminder as parameter; returns void
+    void ReminderSystem::deliverReminder(const Reminder& reminder) {
+        string email;
+        if (!emailService || !resolveEmail(reminder.getUserName(), email)) {
+            log("No email sent for reminder of project " + to_string(reminder.getProjectId()) +
+                ": no address for user " + reminder.getUserName());
+            return;
+        }
+
+        string subject = "Reminder: project " + to_string(reminder.getProjectId()) + " due " + formatDate(reminder.getDueDate());
+        string body = "Hello " + reminder.getUserName() + ",\n\n" + reminder.getMessage();
+        if (emailService->sendEmail(email, subject, body)) {
+            log("Reminder queued for " + email + " for project " + to_string(reminder.getProjectId()));
+        } else {
+            log("Failed to queue reminder for " + email + " for project " + to_string(reminder.getProjectId()));
+        }
+    }
+
+    // Definition of a method to take due reminders off the pending set; takes the current time and an optional user name as parameters; returns vector of Reminders
+    vector<Reminder> ReminderSystem::takeDueReminders(const chrono::system_clock::time_point& now, const string* userName) {
+        // Caller holds remindersMutex; pending is ordered by due date, so due reminders are its front
+        vector<Reminder> due;
+        auto last = pending.upper_bound(DueKey(now, UINT64_MAX));
+        for (auto it = pending.begin(); it != last;) {
+            const Reminder& reminder = reminders.at(it->second);
+            if (userName && reminder.getUserName() != *userName) {
+                ++it;
+                continue;
+            }
+            due.push_back(reminder);
+            it = pending.erase(it);
+        }
+        return due;
+    }
+
+    // Definition of the scheduler thread body; takes no parameters; returns void
+    void ReminderSystem::schedulerLoop() {
+        unique_lock<mutex> lock(remindersMutex);
+        while (!stopping) {
+            if (pending.empty()) {
+                schedulerWake.wait(lock);
+                continue;
+            }
+
+            auto now = chrono::system_clock::now();
+            auto nextDue = pending.begin()->first;
+            if (nextDue > now) {
+                schedulerWake.wait_until(lock, nextDue);
+                continue;
+            }
+
+            // Send outside the lock so adding reminders never waits on the email path
+            vector<Reminder> due = takeDueReminders(now, nullptr);
+            lock.unlock();
+            for (const Reminder& reminder : due) {
+                deliverReminder(reminder);
+            }
+            lock.lock();
+        }
+    }
+
     // Definition of a method to validate CSV row data; takes a vector of strings as parameter; returns bool
     bool ReminderSystem::validateCSVRow(const vector<string>& row) {
         // Check for correct number of columns
@@ -189,19 +332,7 @@ namespace TaxReturnSystem {
 
     // Definition of a method to split CSV line into fields; takes a string as parameter; returns vector of strings
     vector<string> ReminderSystem::splitCSVLine(const string& line) {
-        // Initialize vector to store CSV fields
-        vector<string> row;
-
-        // Create string stream from input line
-        stringstream ss(line);
-        string cell;
-
-        // Split line by commas and collect fields
-        while (getline(ss, cell, ',')) {
-            row.push_back(cell);
-        }
-
-        return row;
+        return CSVReader::splitLine(line);
     }
 
     // Definition of a method to parse date string into time_point; takes a string as parameter; returns system_clock time_point
@@ -228,21 +359,19 @@ namespace TaxReturnSystem {
         log("Loading reminders from CSV file: " + filename);
 
         // Open CSV file for reading
-        ifstream file(filename);
-        if (!file.is_open()) {
+        CSVReader reader = CSVReader::fromString("");
+        try {
+            reader = CSVReader::fromFile(filename);
+        } catch (const exception&) {
             log("Error: Unable to open file " + filename);
             throw runtime_error("Unable to open file: " + filename);
         }
 
-        string line;
-        int lineNumber = 0;
-
-        // Read and process each line in the CSV file
-        while (getline(file, line)) {
-            lineNumber++;
+        // Read and process each row in the CSV file
+        while (reader.readRow()) {
+            size_t lineNumber = reader.getRowNumber();
             try {
-                // Split line into fields
-                vector<string> row = splitCSVLine(line);
+                vector<string> row(reader.getFields().begin(), reader.getFields().end());
 
                 // Validate and process CSV row
                 if (validateCSVRow(row)) {
@@ -264,7 +393,17 @@ namespace TaxReturnSystem {
 
     // Definition of a method to check and trigger reminders for a user; takes two strings as parameters; returns void
     void ReminderSystem::checkAndTriggerReminders(const string& userRole, const string& userName) {
-        // TODO: Implement reminder checking and triggering logic
+        // Fire the user's due reminders now; the scheduler skips them afterwards
+        vector<Reminder> due;
+        {
+            lock_guard<mutex> lock(remindersMutex);
+            due = takeDueReminders(chrono::system_clock::now(), &userName);
+        }
+
+        log("Triggering " + to_string(due.size()) + " due reminders for user " + userName + " (Role: " + userRole + ")");
+        for (const Reminder& reminder : due) {
+            deliverReminder(reminder);
+        }
     }
 
 }
\ No newline at end of file
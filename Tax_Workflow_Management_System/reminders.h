@@ -10,6 +10,11 @@
 #include <algorithm>
 #include <ctime>
 #include <iomanip>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <condition_variable>
 #include "CSV_management.h"
 
 using namespace std;
@@ -35,13 +40,39 @@ namespace TaxReturnSystem {
         string getUserName() const; // Get associated username
     };
 
+    class EmailService;
+    class UserDatabase;
+
     // Class for managing the reminder system
     class ReminderSystem {
     private:
+        using DueKey = pair<chrono::system_clock::time_point, uint64_t>; // (due date, reminder id)
+
         // System data members
         vector<Project> projects; // List of projects
-        vector<Reminder> reminders; // List of reminders
         mutable ofstream logFile; // Logging file stream
+        mutable mutex logMutex; // Serializes writes to the log file
+
+        // Reminder storage and indexes; every member below is guarded by remindersMutex
+        mutable mutex remindersMutex;
+        uint64_t nextReminderId = 0; // Id given to the next reminder
+        unordered_map<uint64_t, Reminder> reminders; // Reminders by id
+        unordered_map<int, vector<uint64_t>> idsByProject; // Reminder ids by project
+        unordered_map<string, vector<uint64_t>> idsByUser; // Reminder ids by user name
+        set<DueKey> byDueDate; // Every reminder, ordered by due date
+        set<DueKey> pending; // Reminders not fired yet, ordered by due date
+
+        // Scheduler
+        EmailService* emailService; // Where fired reminders are sent; nullptr only logs them
+        UserDatabase* userDatabase; // Resolves user names to email addresses
+        condition_variable schedulerWake; // Wakes the scheduler when the earliest due date changes
+        bool stopping = false; // Set by the destructor; guarded by remindersMutex
+        thread scheduler; // Fires reminders at their due time
+
+        void schedulerLoop(); // Body of the scheduler thread
+        vector<Reminder> takeDueReminders(const chrono::system_clock::time_point& now, const string* userName); // Mark due reminders fired and return them
+        void deliverReminder(const Reminder& reminder); // Send a fired reminder by email
+        bool resolveEmail(const string& userName, string& email) const; // Email address of a reminder's user
 
         // CSV handling methods
         bool validateCSVRow(const vector<string>& row); // Validate CSV row data
@@ -51,8 +82,11 @@ namespace TaxReturnSystem {
         void log(const string& message) const; // Log system events
 
     public:
-        ReminderSystem(); // Constructor
-        ~ReminderSystem(); // Destructor
+        ReminderSystem(EmailService* emailService = nullptr, UserDatabase* userDatabase = nullptr); // Constructor; starts the scheduler
+        ~ReminderSystem(); // Destructor; stops the scheduler
+
+        ReminderSystem(const ReminderSystem&) = delete;
+        ReminderSystem& operator=(const ReminderSystem&) = delete;
 
         // Reminder management methods
         void addReminder(int projectId, const chrono::system_clock::time_point& dueDate, const string& message, const string& userName); // Add new reminder
@@ -63,7 +97,7 @@ namespace TaxReturnSystem {
         // Utility methods
         string formatDate(const chrono::system_clock::time_point& date); // Format date for display
         void sendEmailReminder(const string& userRole, const string& userName); // Send email reminder
-        void checkAndTriggerReminders(const string& userRole, const string& userName); // Check and trigger due reminders
+        void checkAndTriggerReminders(const string& userRole, const string& userName); // Fire a user's due reminders now instead of waiting for the scheduler
         void loadRemindersFromCSV(const string& filename); // Load reminders from CSV file
     };
 
@@ -15,23 +15,12 @@
 #include "report_generator.h"
 #include <chrono>
 #include <regex>
-#include <unordered_set>
 #include <stdexcept>
 
 using namespace std;
 
 namespace TaxReturnSystem {
 
-    // Task sets for different report types
-    const unordered_set<string> TASKS_FILED = {
-            "Billed", "Tax Return Filed", "E-file Sent to Client", "E-file Signed by Client", "Corrections Cleared"
-    };
-
-    const unordered_set<string> TASKS_PARTNER_FILED = {
-            "Billed", "Tax Return Filed", "E-file Sent to Client", "E-file Signed by Client", "Corrections Cleared",
-            "Partner Reviewed"
-    };
-
     // Method for checking if a project is extended; takes billing partner string as parameter; returns bool
     bool ReportConditions::isExtended(const string &billingPartner) {
         return billingPartner.find("Extended") != string::npos;
@@ -39,27 +28,32 @@ namespace TaxReturnSystem {
 
     // Method for checking if a project is not filed; takes Project as parameter; returns bool
     bool ReportConditions::isNotFiled(const Project &project) {
-        return TASKS_FILED.find(project.getNextTask()) == TASKS_FILED.end();
+        return isNotFiled(project.getTaskStatus());
     }
 
     // Method for checking if a project is not reviewed; takes Project as parameter; returns bool
     bool ReportConditions::isNotReviewed(const Project &project) {
-        return TASKS_PARTNER_FILED.find(project.getNextTask()) == TASKS_PARTNER_FILED.end();
+        return isNotReviewed(project.getTaskStatus());
     }
 
     // Method for checking if a project is awaiting corrections; takes Project as parameter; returns bool
     bool ReportConditions::isAwaitingCorrections(const Project &project) {
-        return project.getNextTask() == "Corrections Cleared";
+        return isAwaitingCorrections(project.getTaskStatus());
     }
 
     // Method for checking if a project is awaiting e-file authorization; takes Project as parameter; returns bool
     bool ReportConditions::isAwaitingEFileAuthorization(const Project &project) {
-        return project.getNextTask() == "E-file Signed by Client";
+        return isAwaitingEFileAuthorization(project.getTaskStatus());
     }
 
     // Method for checking if a project is unextended; takes Project as parameter; returns bool
     bool ReportConditions::isUnextended(const Project &project) {
-        return !isExtended(project.getBillingPartner());
+        return isUnextended(project.getBillingPartner());
+    }
+
+    // Method for checking if billing partner tags mean the project is unextended; takes billing partner string as parameter; returns bool
+    bool ReportConditions::isUnextended(const string &billingPartner) {
+        return !isExtended(billingPartner);
     }
 
     // Method for checking if a project is in a specific deadline; takes Project and Date as parameters; returns bool
@@ -25,6 +25,15 @@ namespace TaxReturnSystem {
         static bool isAwaitingEFileAuthorization(const Project &project); // Check if project awaits e-file auth
         static bool isUnextended(const Project &project); // Check if project is unextended
         static bool isInDeadline(const Project &project, const Date &deadline); // Check if project is in specific deadline
+
+        // Check on the raw billing partner column, for callers reading the project snapshot
+        static bool isUnextended(const string &billingPartner); // Check if billing partner tags mean unextended
+
+        // Status checks on interned next tasks; each is a single bitmask test
+        static bool isNotFiled(TaskStatus status) { return !taskStatusIn(status, TASKS_FILED_MASK); }
+        static bool isNotReviewed(TaskStatus status) { return !taskStatusIn(status, TASKS_PARTNER_REVIEWED_MASK); }
+        static bool isAwaitingCorrections(TaskStatus status) { return status == TaskStatus::CorrectionsCleared; }
+        static bool isAwaitingEFileAuthorization(TaskStatus status) { return status == TaskStatus::EFileSigned; }
     };
 
     // Class for generating various reports
@@ -1,8 +1,14 @@
 #include "routes.h"
 #include "report_generator.h"
 #include "statistics.h"
+#include "statistics_aggregates.h"
 #include "crow/mustache.h"
 #include "Lacerte_cross_ref.h"
+#include "project_snapshot.h"
+#include "project_filter.h"
+#include "dependency_graph.h"
+#include "csv_reader.h"
+#include "cross_reference_jobs.h"
 #include <chrono>
 #include <thread>
 
@@ -15,7 +21,19 @@ void addCorsHeaders(crow::response& res) {
     res.add_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
 }
 
-void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSystem, ProjectManager& projectManager, LacerteCrossReference& lacerteCrossRef, ProjectsDatabase& projectsDatabase) {
+// Token from the Authorization header, or from the token query parameter for clients such as EventSource that cannot set headers
+string getRequestToken(const crow::request& req) {
+    string token = req.get_header_value("Authorization");
+    if (token.substr(0, 7) == "Bearer ") {
+        token = token.substr(7);
+    }
+    if (token.empty() && req.url_params.get("token")) {
+        token = req.url_params.get("token");
+    }
+    return token;
+}
+
+void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSystem, ProjectManager& projectManager, LacerteCrossReference& lacerteCrossRef, CrossReferenceJobManager& crossReferenceJobs, ProjectsDatabase& projectsDatabase) {
 
     CROW_ROUTE(app, "/<path>").methods("OPTIONS"_method)
             ([](const crow::request& req, crow::response& res, string path) {
@@ -81,23 +99,24 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         return res;
                     }
 
-                    vector<Project> projects = projectManager.getAllProjects();
-
-                    set<string> groups;
-                    set<string> projectTypes;
-                    set<string> managers;
-                    set<string> partners;
+                    auto snapshot = projectManager.getSnapshot();
 
-                    for (const auto& project : projects) {
-                        if (!project.getGroup().empty()) groups.insert(project.getGroup());
-                        if (!project.getProjectType().empty()) projectTypes.insert(project.getProjectType());
-                        if (!project.getManager().empty()) managers.insert(project.getManager());
-                        if (!project.getPartner().empty()) {
-                            partners.insert(project.getPartner());
+                    // Dictionary-encoded columns already hold their distinct values
+                    auto distinctValues = [](const StringDictionary& dictionary) {
+                        set<string> values;
+                        for (const auto& value : dictionary.getValues()) {
+                            if (!value.empty()) values.insert(value);
                         }
-                    }
+                        return values;
+                    };
 
-                    for (const auto& partner : partners) {
+                    set<string> groups = distinctValues(snapshot->getGroups());
+                    set<string> managers = distinctValues(snapshot->getManagers());
+                    set<string> partners = distinctValues(snapshot->getPartners());
+                    set<string> projectTypes;
+
+                    for (size_t row = 0; row < snapshot->size(); row++) {
+                        if (!snapshot->getProjectType(row).empty()) projectTypes.insert(snapshot->getProjectType(row));
                     }
 
                     crow::json::wvalue response_body;
@@ -362,8 +381,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         return res;
                     }
 
-                    User user = auth.getUserFromToken(token);
-                    if (user.getRole() != UserRole::Admin) {
+                    if (auth.getRoleFromToken(token) != UserRole::Admin) {
                         res.code = 403;
                         res.body = "Unauthorized access";
                         return res;
@@ -385,7 +403,8 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                             reportType = static_cast<ReportType>(x["reportType"].i());
                         }
 
-                        bool success = projectManager.importFromCSV(filename, reportType);
+                        ImportReport report;
+                        bool success = projectManager.importFromCSV(filename, reportType, &report);
 
                         if (!success) {
                             res.code = 500;
@@ -394,10 +413,12 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         }
 
                         // Get count of imported projects
-                        vector<Project> projects = projectManager.getAllProjects();
+                        size_t projectCount = projectManager.getSnapshot()->size();
 
                         res.code = 200;
-                        res.body = "CSV data loaded successfully. Imported " + to_string(projects.size()) + " projects.";
+                        res.body = "CSV data loaded successfully. Imported " + to_string(projectCount) + " projects (" +
+                                   to_string(report.added) + " added, " + to_string(report.updated) + " updated, " +
+                                   to_string(report.removed) + " removed).";
                     } else {
                         res.code = 400;
                         res.body = "Unsupported Content-Type";
@@ -427,24 +448,26 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         return res;
                     }
 
-                    vector<Project> projects = projectManager.getAllProjects();
+                    // Compile this session's filter against the current snapshot
+                    ProjectFilter filter(projectManager.getSnapshot(), *projectManager.getSessionFilter(token));
+                    const ProjectSnapshot* snapshot = &filter.getSnapshot();
                     crow::json::wvalue response_body;
                     int i = 0;
-                    for (const auto& project : projects) {
+                    for (uint32_t row : filter.getRows()) {
                         crow::json::wvalue projectJson;
-                        projectJson["id"] = project.getId();
-                        projectJson["group"] = project.getGroup();
-                        projectJson["client"] = project.getClient();
-                        projectJson["projectType"] = project.getProjectType();
-                        projectJson["billingPartner"] = project.getBillingPartner();
-                        projectJson["partner"] = project.getPartner();
-                        projectJson["manager"] = project.getManager();
-                        projectJson["nextTask"] = project.getNextTask();
-                        projectJson["memo"] = project.getMemo();
-                        projectJson["regularDeadline"] = project.getRegularDeadline().getDateStr();
-                        projectJson["internalDeadline"] = project.getInternalDeadline().getDateStr();
-                        projectJson["extended"] = project.isExtended();
-                        projectJson["reportType"] = static_cast<int>(project.getReportType());
+                        projectJson["id"] = snapshot->getId(row);
+                        projectJson["group"] = snapshot->getGroup(row);
+                        projectJson["client"] = snapshot->getClient(row);
+                        projectJson["projectType"] = snapshot->getProjectType(row);
+                        projectJson["billingPartner"] = snapshot->getBillingPartner(row);
+                        projectJson["partner"] = snapshot->getPartner(row);
+                        projectJson["manager"] = snapshot->getManager(row);
+                        projectJson["nextTask"] = snapshot->getNextTask(row);
+                        projectJson["memo"] = snapshot->getMemo(row);
+                        projectJson["regularDeadline"] = snapshot->getRegularDeadline(row).getDateStr();
+                        projectJson["internalDeadline"] = snapshot->getInternalDeadline(row).getDateStr();
+                        projectJson["extended"] = snapshot->isExtended(row);
+                        projectJson["reportType"] = static_cast<int>(snapshot->getReportType(row));
                         response_body[i++] = std::move(projectJson);
                     }
                     res.body = response_body.dump();
@@ -482,22 +505,27 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         return res;
                     }
 
-                    if (x.has("group")) projectManager.setFilter(FilterType::Group, x["group"].s());
-                    if (x.has("projectType")) projectManager.setFilter(FilterType::ProjectType, x["projectType"].s());
-                    if (x.has("billingPartner")) projectManager.setFilter(FilterType::BillingPartner, x["billingPartner"].s());
-                    if (x.has("partner")) projectManager.setFilter(FilterType::Partner, x["partner"].s());
-                    if (x.has("manager")) projectManager.setFilter(FilterType::Manager, x["manager"].s());
-                    if (x.has("nextTask")) projectManager.setFilter(FilterType::NextTask, x["nextTask"].s());
+                    // Build on this session's criteria; other sessions are unaffected
+                    FilterCriteria criteria = *projectManager.getSessionFilter(token);
+
+                    if (x.has("group")) criteria.set(FilterType::Group, x["group"].s());
+                    if (x.has("projectType")) criteria.set(FilterType::ProjectType, x["projectType"].s());
+                    if (x.has("billingPartner")) criteria.set(FilterType::BillingPartner, x["billingPartner"].s());
+                    if (x.has("partner")) criteria.set(FilterType::Partner, x["partner"].s());
+                    if (x.has("manager")) criteria.set(FilterType::Manager, x["manager"].s());
+                    if (x.has("nextTask")) criteria.set(FilterType::NextTask, x["nextTask"].s());
                     if (x.has("startDate") && x.has("endDate")) {
-                        projectManager.setDateRangeFilter(x["startDate"].s(), x["endDate"].s());
+                        criteria.setDateRange(x["startDate"].s(), x["endDate"].s());
                     }
                     if (x.has("extended")) {
-                        projectManager.setFilter(FilterType::Extended, x["extended"].s());
+                        criteria.set(FilterType::Extended, x["extended"].s());
                     }
                     if (x.has("reportType")) {
-                        projectManager.setFilter(FilterType::ReportType, x["reportType"].s());
+                        criteria.set(FilterType::ReportType, x["reportType"].s());
                     }
 
+                    projectManager.setSessionFilter(token, criteria);
+
                     res.code = 200;
                     res.body = "Filters applied successfully";
                 } catch (const std::exception& e) {
@@ -525,7 +553,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         return res;
                     }
 
-                    projectManager.resetFilter();
+                    projectManager.clearSessionFilter(token);
                     res.code = 200;
                     res.body = "Filters reset successfully";
                 } catch (const std::exception& e) {
@@ -554,7 +582,28 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                     }
 
                     string searchTerm = req.url_params.get("term") ? req.url_params.get("term") : "";
-                    vector<Project> projects = projectManager.searchProjects(searchTerm);
+
+                    // A limit or cursor asks for one page; the cursor for the next page is returned in a header
+                    vector<Project> projects;
+                    if (req.url_params.get("limit") || req.url_params.get("cursor")) {
+                        size_t limit = 0;
+                        if (req.url_params.get("limit")) {
+                            try {
+                                limit = stoul(req.url_params.get("limit"));
+                            } catch (const std::exception&) {
+                                res.code = 400;
+                                res.body = "Invalid limit";
+                                return res;
+                            }
+                        }
+                        string cursor = req.url_params.get("cursor") ? req.url_params.get("cursor") : "";
+                        ProjectSearchPage page = projectManager.searchProjects(searchTerm, limit, cursor);
+                        projects = std::move(page.projects);
+                        res.add_header("X-Next-Cursor", page.nextCursor);
+                        res.add_header("Access-Control-Expose-Headers", "X-Next-Cursor");
+                    } else {
+                        projects = projectManager.searchProjects(searchTerm);
+                    }
                     crow::json::wvalue response_body;
                     int i = 0;
                     for (const auto& project : projects) {
@@ -605,42 +654,47 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                     string startDate = req.url_params.get("startDate") ? req.url_params.get("startDate") : "";
                     string endDate = req.url_params.get("endDate") ? req.url_params.get("endDate") : "";
 
-                    vector<Project> projects = projectManager.getAllProjects();
-
-                    projects.erase(std::remove_if(projects.begin(), projects.end(),
-                                                  [&](const Project& p) {
-                                                      return (!group.empty() && p.getGroup() != group) ||
-                                                             (!projectType.empty() && p.getProjectType() != projectType) ||
-                                                             (!manager.empty() && p.getManager() != manager) ||
-                                                             (!startDate.empty() && p.getRegularDeadline() < Date(startDate)) ||
-                                                             (!endDate.empty() && p.getRegularDeadline() > Date(endDate));
-                                                  }), projects.end());
-
-                    int totalProjects = projects.size();
-                    int notFiled = 0;
-                    int notReviewed = 0;
-                    int awaitingCorrections = 0;
-                    int awaitingEFileAuth = 0;
-                    int unextended = 0;
-                    int extended = 0;
+                    Date start(startDate);
+                    Date end(endDate);
+                    DashboardCounts counts;
 
-                    for (const auto& project : projects) {
-                        if (ReportConditions::isNotFiled(project)) notFiled++;
-                        if (ReportConditions::isNotReviewed(project)) notReviewed++;
-                        if (ReportConditions::isAwaitingCorrections(project)) awaitingCorrections++;
-                        if (ReportConditions::isAwaitingEFileAuthorization(project)) awaitingEFileAuth++;
-                        if (ReportConditions::isUnextended(project)) unextended++;
-                        if (project.isExtended()) extended++;
+                    if (group.empty() && projectType.empty()) {
+                        // Served from the counters maintained on every write
+                        counts = projectManager.getAggregates().getDashboardCounts(
+                                manager.empty() ? nullopt : optional<string>(manager),
+                                startDate.empty() ? nullopt : optional<int>(start.getValue()),
+                                endDate.empty() ? nullopt : optional<int>(end.getValue()));
+                    } else {
+                        // The counters are not keyed on group or project type, so scan the snapshot
+                        auto snapshot = projectManager.getSnapshot();
+                        for (size_t row = 0; row < snapshot->size(); row++) {
+                            if ((!group.empty() && snapshot->getGroup(row) != group) ||
+                                (!projectType.empty() && snapshot->getProjectType(row) != projectType) ||
+                                (!manager.empty() && snapshot->getManager(row) != manager) ||
+                                (!startDate.empty() && snapshot->getRegularDeadline(row) < start) ||
+                                (!endDate.empty() && snapshot->getRegularDeadline(row) > end)) {
+                                continue;
+                            }
+
+                            counts.totalProjects++;
+                            TaskStatus status = snapshot->getTaskStatus(row);
+                            if (ReportConditions::isNotFiled(status)) counts.notFiled++;
+                            if (ReportConditions::isNotReviewed(status)) counts.notReviewed++;
+                            if (ReportConditions::isAwaitingCorrections(status)) counts.awaitingCorrections++;
+                            if (ReportConditions::isAwaitingEFileAuthorization(status)) counts.awaitingEFileAuth++;
+                            if (ReportConditions::isUnextended(snapshot->getBillingPartner(row))) counts.unextended++;
+                            if (snapshot->isExtended(row)) counts.extended++;
+                        }
                     }
 
                     crow::json::wvalue response_body;
-                    response_body["totalProjects"] = totalProjects;
-                    response_body["notFiled"] = notFiled;
-                    response_body["notReviewed"] = notReviewed;
-                    response_body["awaitingCorrections"] = awaitingCorrections;
-                    response_body["awaitingEFileAuth"] = awaitingEFileAuth;
-                    response_body["unextended"] = unextended;
-                    response_body["extended"] = extended;
+                    response_body["totalProjects"] = counts.totalProjects;
+                    response_body["notFiled"] = counts.notFiled;
+                    response_body["notReviewed"] = counts.notReviewed;
+                    response_body["awaitingCorrections"] = counts.awaitingCorrections;
+                    response_body["awaitingEFileAuth"] = counts.awaitingEFileAuth;
+                    response_body["unextended"] = counts.unextended;
+                    response_body["extended"] = counts.extended;
 
                     res.body = response_body.dump();
                     res.code = 200;
@@ -654,7 +708,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
             });
 
     CROW_ROUTE(app, "/logout").methods("POST"_method)
-            ([&auth](const crow::request& req) {
+            ([&auth, &projectManager](const crow::request& req) {
                 crow::response res;
                 addCorsHeaders(res);
 
@@ -665,6 +719,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                     }
 
                     auth.invalidateToken(token);
+                    projectManager.clearSessionFilter(token);
 
                     res.code = 200;
                     res.body = "Logged out successfully";
@@ -771,7 +826,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
             });
 
     CROW_ROUTE(app, "/cross-reference-lacerte").methods("POST"_method)
-            ([&auth, &projectManager, &lacerteCrossRef](const crow::request& req) {
+            ([&auth, &crossReferenceJobs](const crow::request& req) {
                 crow::response res;
                 addCorsHeaders(res);
 
@@ -785,123 +840,102 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                         res.body = "Invalid token";
                         return res;
                     }
-                    // 2. Get projects and precompute features
-                    vector<Project> projects = projectManager.getAllProjects();
 
-                    // 3-4. Parse uploaded file content and collect names
+                    // 2. Get uploaded file content
                     auto x = crow::json::load(req.body);
-                    if (!x || !x.has("fileContent")) {
+                    if (!x || !x.has("fileContent") || x["fileContent"].t() != crow::json::type::String ||
+                        x["fileContent"].s().size() == 0) {
                         cout << "Error: Missing file content in request" << endl << flush;
                         res.code = 400;
                         res.body = "Missing file content";
                         return res;
                     }
 
-                    string fileContent = x["fileContent"].s();
-                    istringstream stream(fileContent);
-                    string line;
-                    vector<string> lacerteNames;
-
-                    getline(stream, line); // Skip header
-                    while (getline(stream, line)) {
-                        istringstream lineStream(line);
-                        string lacerteName;
-                        getline(lineStream, lacerteName, ',');
-                        if (!lacerteName.empty()) {
-                            lacerteNames.push_back(lacerteName);
-                        }
-                    }
-
-                    // 5. Precompute database features
-                    auto startPrecompute = chrono::high_resolution_clock::now();
-                    auto precomputedFeatures = lacerteCrossRef.precomputeDatabaseFeatures(projects);
-                    auto endPrecompute = chrono::high_resolution_clock::now();
-                    auto precomputeTime = chrono::duration_cast<chrono::milliseconds>(endPrecompute - startPrecompute);
-
-                    // 6. Parallel matching process
-                    cout << "DEBUG: Input validation:"
-                         << "\n - lacerteNames size: " << lacerteNames.size()
-                         << "\n - First few lacerte names: ";
-                    for (size_t i = 0; i < min(size_t(3), lacerteNames.size()); i++) {
-                        cout << "\n   " << i + 1 << ". " << lacerteNames[i];
-                    }
-                    cout << "\n - precomputedFeatures size: " << precomputedFeatures.size()
-                         << "\n - First few precomputed features: ";
-                    for (size_t i = 0; i < min(size_t(3), precomputedFeatures.size()); i++) {
-                        cout << "\n   " << i + 1 << ". Client: " << precomputedFeatures[i].clientName;
-                    }
-                    cout << endl << flush;
-
-                    auto startMatching = chrono::high_resolution_clock::now();
-
-                    // Call findMatches
-                    vector<MatchResult> results = lacerteCrossRef.findMatches(lacerteNames, precomputedFeatures);
-
-                    auto endMatching = chrono::high_resolution_clock::now();
-                    auto matchingTime = chrono::duration_cast<chrono::milliseconds>(endMatching - startMatching);
-                    cout << "\nParallel matching completed in " << matchingTime.count() << "ms" << endl << flush;
-
-                    // 7. Write results to CSV
-                    ofstream outFile("cross_reference_results.csv");
-                    outFile << "Lacerte Name,Database Match,Confidence Score,Notes\n";
-
-                    int matchesFound = 0;
-                    for (const auto& match : results) {
-                        outFile << "\"" << match.lacerteName << "\",";
-                        if (match.confidence > 0.7) {
-                            outFile << "\"" << match.databaseMatch << "\",";
-                            matchesFound++;
-                        } else {
-                            outFile << "\"No Match\",";
-                        }
-                        outFile << fixed << setprecision(4) << match.confidence << ",";
-                        if (match.confidence <= 0.7) {
-                            outFile << "\"Closest match: " << match.databaseMatch << "\"";
-                        }
-                        outFile << "\n";
-                    }
-                    outFile.close();
+                    // 3. Queue the job for the submitting user; parsing and matching run on the job workers
+                    string username = auth.getUserFromToken(token).getUsername();
+                    string jobId = crossReferenceJobs.submit(x["fileContent"].s(), username);
 
-                    // 8. Prepare response
-                    auto metrics = lacerteCrossRef.getModelMetrics();
                     crow::json::wvalue response;
                     response["success"] = true;
-                    response["message"] = "Cross reference completed";
-                    response["totalProcessed"] = lacerteNames.size();
-                    response["matchesFound"] = matchesFound;
-                    response["metrics"]["accuracy"] = metrics.getAccuracyRate();
-                    response["metrics"]["matchRate"] = metrics.getMatchRate();
-                    response["metrics"]["totalPredictions"] = metrics.totalPredictions;
-                    response["metrics"]["correctMatches"] = metrics.correctMatches;
-                    response["resultsFile"] = "cross_reference_results.csv";
-                    response["processingTimeMs"] = matchingTime.count();
+                    response["jobId"] = jobId;
+                    response["progressUrl"] = "/cross-reference-progress/" + jobId;
 
-                    res.code = 200;
+                    res.code = 202;
+                    res.add_header("Content-Type", "application/json");
                     res.body = response.dump();
 
-                    cout << "\n=== Cross-Reference Process Summary ===" << endl
-                         << "Total names processed: " << lacerteNames.size() << endl
-                         << "Matches found: " << matchesFound << endl
-                         << "Processing time: " << matchingTime.count() << "ms" << endl
-                         << "Average time per name: "
-                         << (lacerteNames.size() > 0 ? matchingTime.count() / lacerteNames.size() : 0)
-                         << "ms" << endl
-                         << "=================================" << endl << flush;
-
+                } catch (const JobQueueFullError& e) {
+                    cout << "ERROR: Could not queue cross-reference job: " << e.what() << endl << flush;
+                    res.code = 503;
+                    res.body = string("Error processing Lacerte file: ") + e.what();
                 } catch (const exception& e) {
-                    cout << "ERROR: Cross-reference process failed: " << e.what() << endl << flush;
+                    cout << "ERROR: Could not queue cross-reference job: " << e.what() << endl << flush;
                     res.code = 500;
                     res.body = string("Error processing Lacerte file: ") + e.what();
                 }
                 return res;
             });
 
-    CROW_ROUTE(app, "/cross-reference-progress")
-            ([](const crow::request& req) {
+    // Server-sent event with a job's progress. Each response carries one event and a retry delay,
+    // so the browser's EventSource reconnects and receives the next update without holding a server thread.
+    CROW_ROUTE(app, "/cross-reference-progress/<string>")
+            ([&auth, &crossReferenceJobs, &lacerteCrossRef](const crow::request& req, string jobId) {
                 crow::response res;
+                addCorsHeaders(res);
+
+                // EventSource cannot send headers, so the page passes its token as a query parameter
+                string token = getRequestToken(req);
+                if (!auth.validateToken(token)) {
+                    res.code = 401;
+                    res.body = "Invalid token";
+                    return res;
+                }
+
+                auto job = crossReferenceJobs.getJob(jobId);
+                if (!job) {
+                    res.code = 404;
+                    res.body = "Unknown cross-reference job";
+                    return res;
+                }
+                if (job->owner != auth.getUserFromToken(token).getUsername()) {
+                    res.code = 403;
+                    res.body = "Cross-reference job belongs to another user";
+                    return res;
+                }
+
+                JobState state = job->state.load();
+                size_t total = job->total.load();
+                size_t processed = job->progress.processed.load();
+
+                crow::json::wvalue event;
+                event["jobId"] = jobId;
+                event["state"] = jobStateToString(state);
+                event["processed"] = processed;
+                event["total"] = total;
+                event["percentage"] = state == JobState::Completed ? 100.0 :
+                                      (total > 0 ? 100.0 * processed / total : 0.0);
+                event["comparisons"] = job->progress.comparisons.load();
+                event["earlyExits"] = job->progress.earlyExits.load();
+
+                if (state == JobState::Completed) {
+                    auto metrics = lacerteCrossRef.getModelMetrics();
+                    event["success"] = true;
+                    event["totalProcessed"] = total;
+                    event["matchesFound"] = job->matchesFound.load();
+                    event["processingTimeMs"] = job->processingTimeMs.load();
+                    event["resultsFile"] = "/cross-reference-results/" + jobId;
+                    event["metrics"]["accuracy"] = metrics.getAccuracyRate();
+                    event["metrics"]["matchRate"] = metrics.getMatchRate();
+                    event["metrics"]["totalPredictions"] = metrics.totalPredictions;
+                    event["metrics"]["correctMatches"] = metrics.correctMatches;
+                } else if (state == JobState::Failed) {
+                    event["success"] = false;
+                    event["message"] = job->getError();
+                }
+
                 res.add_header("Content-Type", "text/event-stream");
                 res.add_header("Cache-Control", "no-cache");
-                res.add_header("Connection", "keep-alive");
+                res.body = "retry: 500\ndata: " + event.dump() + "\n\n";
                 return res;
             });
 
@@ -984,7 +1018,7 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
 
                     crow::json::wvalue response;
                     response["success"] = true;
-                    response["message"] = "Feedback session completed and model retrained";
+                    response["message"] = "Feedback session completed; model retraining started";
                     response["metrics"]["accuracy"] = metrics.accuracy;
                     response["metrics"]["total_predictions"] = metrics.totalPredictions;
                     response["metrics"]["correct_matches"] = metrics.correctMatches;
@@ -1020,12 +1054,32 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
         return res;
     });
 
-    CROW_ROUTE(app, "/cross_reference_results.csv")
+    CROW_ROUTE(app, "/cross-reference-results/<string>")
             .methods("GET"_method)
-                    ([](const crow::request& req) {
+                    ([&auth, &crossReferenceJobs](const crow::request& req, string jobId) {
                         crow::response res;
+                        addCorsHeaders(res);
 
-                        std::ifstream file("cross_reference_results.csv");
+                        string token = getRequestToken(req);
+                        if (!auth.validateToken(token)) {
+                            res.code = 401;
+                            res.body = "Invalid token";
+                            return res;
+                        }
+
+                        auto job = crossReferenceJobs.getJob(jobId);
+                        if (!job || job->state.load() != JobState::Completed) {
+                            res.code = 404;
+                            res.body = "Results file not found";
+                            return res;
+                        }
+                        if (job->owner != auth.getUserFromToken(token).getUsername()) {
+                            res.code = 403;
+                            res.body = "Cross-reference job belongs to another user";
+                            return res;
+                        }
+
+                        std::ifstream file(job->resultsPath);
                         if (!file) {
                             res.code = 404;
                             res.body = "Results file not found";
@@ -1136,25 +1190,25 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                     string group = req.url_params.get("group") ? req.url_params.get("group") : "";
                     string projectType = req.url_params.get("projectType") ? req.url_params.get("projectType") : "";
 
-                    vector<Project> projects = projectManager.getAllProjects();
+                    auto snapshot = projectManager.getSnapshot();
                     vector<crow::json::wvalue> awaitingEFileAuth;
 
-                    for (const auto& project : projects) {
+                    for (size_t row = 0; row < snapshot->size(); row++) {
                         // Apply filters
-                        if ((!manager.empty() && project.getManager() != manager) ||
-                            (!group.empty() && project.getGroup() != group) ||
-                            (!projectType.empty() && project.getProjectType() != projectType)) {
+                        if ((!manager.empty() && snapshot->getManager(row) != manager) ||
+                            (!group.empty() && snapshot->getGroup(row) != group) ||
+                            (!projectType.empty() && snapshot->getProjectType(row) != projectType)) {
                             continue;
                         }
 
                         // Check if project is awaiting e-file authorization
-                        if (project.getNextTask() == "E-file Sent to Client") {
+                        if (snapshot->getTaskStatus(row) == TaskStatus::EFileSent) {
                             crow::json::wvalue projectJson;
-                            projectJson["id"] = project.getId();
-                            projectJson["client"] = project.getClient();
-                            projectJson["manager"] = project.getManager();
-                            projectJson["deadline"] = project.getRegularDeadline().getDateStr();
-                            projectJson["projectType"] = project.getProjectType();
+                            projectJson["id"] = snapshot->getId(row);
+                            projectJson["client"] = snapshot->getClient(row);
+                            projectJson["manager"] = snapshot->getManager(row);
+                            projectJson["deadline"] = snapshot->getRegularDeadline(row).getDateStr();
+                            projectJson["projectType"] = snapshot->getProjectType(row);
                             awaitingEFileAuth.push_back(std::move(projectJson));
                         }
                     }
@@ -1171,5 +1225,68 @@ void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSyste
                 return res;
             });
 
+    // Route to get the projects ready to work on and the order to work through the rest
+    CROW_ROUTE(app, "/work-queue").methods("GET"_method)
+            ([&auth, &projectManager](const crow::request& req) {
+                crow::response res;
+                addCorsHeaders(res);
+
+                try {
+                    string token = req.get_header_value("Authorization");
+                    if (token.substr(0, 7) == "Bearer ") {
+                        token = token.substr(7);
+                    }
+                    if (!auth.validateToken(token)) {
+                        res.code = 401;
+                        res.body = "Invalid token";
+                        return res;
+                    }
+
+                    auto snapshot = projectManager.getSnapshot();
+                    const DependencyGraph& graph = projectManager.getDependencyGraph();
+
+                    unordered_map<string, size_t> rowsById;
+                    rowsById.reserve(snapshot->size());
+                    for (size_t row = 0; row < snapshot->size(); row++) {
+                        rowsById.emplace(snapshot->getId(row), row);
+                    }
+
+                    // Projects written after the snapshot was taken are left out until the next request
+                    auto toJson = [&snapshot, &rowsById](const vector<string>& ids) {
+                        vector<crow::json::wvalue> projects;
+                        for (const string& id : ids) {
+                            auto found = rowsById.find(id);
+                            if (found == rowsById.end()) continue;
+
+                            size_t row = found->second;
+                            crow::json::wvalue projectJson;
+                            projectJson["id"] = id;
+                            projectJson["client"] = snapshot->getClient(row);
+                            projectJson["projectType"] = snapshot->getProjectType(row);
+                            projectJson["manager"] = snapshot->getManager(row);
+                            projectJson["nextTask"] = snapshot->getNextTask(row);
+                            projectJson["deadline"] = snapshot->getRegularDeadline(row).getDateStr();
+                            projects.push_back(std::move(projectJson));
+                        }
+                        return crow::json::wvalue(projects);
+                    };
+
+                    crow::json::wvalue response_body;
+                    response_body["ready"] = toJson(graph.getReadyProjects());
+                    response_body["workOrder"] = toJson(graph.getWorkOrder());
+                    response_body["awaitingDependencies"] = graph.countAwaitingDependencies();
+
+                    res.code = 200;
+                    res.body = response_body.dump();
+                    res.add_header("Content-Type", "application/json");
+
+                } catch (const std::exception& e) {
+                    res.code = 500;
+                    res.body = std::string("Error retrieving work queue: ") + e.what();
+                }
+
+                return res;
+            });
+
 
 }
\ No newline at end of file
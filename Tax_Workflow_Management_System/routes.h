@@ -5,11 +5,12 @@
 #include "CSV_management.h"
 #include "reminders.h"
 #include "Lacerte_cross_ref.h"
+#include "cross_reference_jobs.h"
 #include <vector>
 
  namespace TaxReturnSystem{
 
     // Function to set up routes for the web application
-    void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSystem, ProjectManager& projectManager, LacerteCrossReference& lacerteCrossRef, ProjectsDatabase& projectsDatabase);
+    void setupRoutes(crow::SimpleApp& app, Auth& auth, ReminderSystem& reminderSystem, ProjectManager& projectManager, LacerteCrossReference& lacerteCrossRef, CrossReferenceJobManager& crossReferenceJobs, ProjectsDatabase& projectsDatabase);
 
 }
\ No newline at end of file
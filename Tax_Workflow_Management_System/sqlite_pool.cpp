@@ -0,0 +1,160 @@
+/**
+ * @file sqlite_pool.cpp
+ * @brief Implementation of the SQLite connection pool
+ *
+ * This file contains implementations for:
+ * - Opening and tuning connections
+ * - Per-connection prepared-statement caches
+ * - Leasing the writer and reader connections
+ *
+ * The database is switched to WAL so readers work on the last committed
+ * state while the writer appends to the log; a reader never blocks the
+ * writer and the writer never blocks readers. Every connection is owned by
+ * one lease at a time, so connections are opened without SQLite's own
+ * mutex. Statements are compiled once per connection and reset when the
+ * CachedStatement that borrowed them goes out of scope.
+ */
+
+#include "sqlite_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+// CACHED STATEMENT CLASS METHODS:
+
+    // Definition of the destructor; resets the statement and clears its bindings; returns nothing
+    CachedStatement::~CachedStatement() {
+        reset();
+    }
+
+    // Definition of the move assignment; takes another statement as parameter; returns this statement
+    CachedStatement& CachedStatement::operator=(CachedStatement&& other) noexcept {
+        if (this != &other) {
+            reset();
+            stmt = other.stmt;
+            other.stmt = nullptr;
+        }
+        return *this;
+    }
+
+    // Definition of a method to reset the statement and clear its bindings; takes no parameters; returns void
+    void CachedStatement::reset() {
+        if (stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+    }
+
+// SQLITE CONNECTION CLASS METHODS:
+
+    // Definition of the constructor; takes the database path and whether the connection is read-only; returns nothing
+    SqliteConnection::SqliteConnection(const string& path, bool readOnly) {
+        int flags = SQLITE_OPEN_NOMUTEX | (readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+        if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+            string errorMsg = db ? sqlite3_errmsg(db) : "out of memory";
+            sqlite3_close(db);
+            db = nullptr;
+            throw runtime_error("Failed to open database " + path + ": " + errorMsg);
+        }
+
+        sqlite3_busy_timeout(db, SQLITE_BUSY_TIMEOUT_MS);
+
+        // NORMAL is durable across application crashes in WAL mode; only an OS crash can lose the last commits
+        string pragmas = "PRAGMA synchronous = NORMAL;"
+                         "PRAGMA mmap_size = " + to_string(SQLITE_MMAP_SIZE) + ";"
+                         "PRAGMA cache_size = -" + to_string(SQLITE_CACHE_SIZE_KB) + ";";
+        if (!execute(pragmas.c_str())) {
+            cerr << "Continuing with default connection settings for " << path << endl;
+        }
+    }
+
+    // Definition of the destructor; finalizes cached statements and closes the connection; returns nothing
+    SqliteConnection::~SqliteConnection() {
+        for (auto& [sql, stmt] : statements) {
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(db);
+    }
+
+    // Definition of a method to get a cached prepared statement; takes the SQL text as parameter; returns CachedStatement
+    CachedStatement SqliteConnection::prepare(const string& sql) {
+        auto cached = statements.find(sql);
+        if (cached != statements.end()) {
+            return CachedStatement(cached->second);
+        }
+
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v3(db, sql.c_str(), static_cast<int>(sql.size()), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+            return CachedStatement();
+        }
+        statements.emplace(sql, stmt);
+        return CachedStatement(stmt);
+    }
+
+    // Definition of a method to run SQL that returns no rows; takes the SQL text as parameter; returns bool
+    bool SqliteConnection::execute(const char* sql) {
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            cerr << "SQL error: " << (errMsg ? errMsg : sqlite3_errmsg(db)) << endl;
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
+    }
+
+// LEASE CLASS METHODS:
+
+    // Definition of the read lease destructor; returns the connection to the pool; returns nothing
+    ReadLease::~ReadLease() {
+        if (pool) {
+            pool->releaseReader(connection);
+        }
+    }
+
+// SQLITE POOL CLASS METHODS:
+
+    // Definition of the constructor; takes the database path and the number of readers; returns nothing
+    SqlitePool::SqlitePool(const string& path, size_t readerCount) : path(path) {
+        writerConnection = make_unique<SqliteConnection>(path, false);
+
+        // WAL is stored in the file, so the readers opened below find it already enabled
+        if (!writerConnection->execute("PRAGMA journal_mode = WAL;")) {
+            throw runtime_error("Failed to enable WAL for " + path);
+        }
+
+        readerCount = max<size_t>(readerCount, 1);
+        for (size_t i = 0; i < readerCount; i++) {
+            readerConnections.push_back(make_unique<SqliteConnection>(path, true));
+            idleReaders.push_back(readerConnections.back().get());
+        }
+    }
+
+    // Definition of a method to lease the writer connection; takes no parameters; returns WriteLease
+    WriteLease SqlitePool::writer() {
+        return WriteLease(unique_lock<mutex>(writerMutex), writerConnection.get());
+    }
+
+    // Definition of a method to lease a reader connection; takes no parameters; returns ReadLease
+    ReadLease SqlitePool::reader() {
+        unique_lock<mutex> lock(readersMutex);
+        readerReturned.wait(lock, [this]() { return !idleReaders.empty(); });
+        SqliteConnection* connection = idleReaders.back();
+        idleReaders.pop_back();
+        return ReadLease(this, connection);
+    }
+
+    // Definition of a method to return a reader connection; takes the connection as parameter; returns void
+    void SqlitePool::releaseReader(SqliteConnection* connection) {
+        {
+            lock_guard<mutex> lock(readersMutex);
+            idleReaders.push_back(connection);
+        }
+        readerReturned.notify_one();
+    }
+
+} // namespace TaxReturnSystem
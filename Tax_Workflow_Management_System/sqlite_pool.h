@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <condition_variable>
+#include <sqlite3.h>
+#include "config.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Prepared statement borrowed from a connection's cache; reset and unbound when it goes out of scope
+    class CachedStatement {
+    private:
+        sqlite3_stmt* stmt = nullptr; // Statement owned by the connection's cache
+
+    public:
+        CachedStatement() = default; // Empty statement, returned when preparing failed
+        explicit CachedStatement(sqlite3_stmt* stmt) : stmt(stmt) {} // Wrap a cached statement
+        ~CachedStatement(); // Reset the statement and clear its bindings for the next user
+
+        CachedStatement(CachedStatement&& other) noexcept : stmt(other.stmt) { other.stmt = nullptr; }
+        CachedStatement& operator=(CachedStatement&& other) noexcept;
+        CachedStatement(const CachedStatement&) = delete;
+        CachedStatement& operator=(const CachedStatement&) = delete;
+
+        sqlite3_stmt* get() const { return stmt; } // Statement handle for binding and stepping
+        explicit operator bool() const { return stmt != nullptr; } // Whether preparing succeeded
+        void reset(); // Reset and unbind early so the statement can be run again
+    };
+
+    // One SQLite connection with its own prepared-statement cache. A connection is not thread-safe:
+    // it is opened without SQLite's internal mutex and must only be used by the thread holding its lease.
+    class SqliteConnection {
+    private:
+        sqlite3* db = nullptr; // Connection handle
+        unordered_map<string, sqlite3_stmt*> statements; // Prepared statements keyed by SQL text
+
+    public:
+        SqliteConnection(const string& path, bool readOnly); // Open and tune a connection; throws runtime_error on failure
+        ~SqliteConnection(); // Finalize the cached statements and close the connection
+
+        SqliteConnection(const SqliteConnection&) = delete;
+        SqliteConnection& operator=(const SqliteConnection&) = delete;
+
+        sqlite3* handle() const { return db; } // Raw handle, for error messages and one-off calls
+        CachedStatement prepare(const string& sql); // Get a statement, compiling it only the first time; empty on failure
+        bool execute(const char* sql); // Run SQL that returns no rows, logging failures; returns success
+        const char* errorMessage() const { return sqlite3_errmsg(db); } // Message of the last failed call
+    };
+
+    class SqlitePool;
+
+    // Exclusive use of one reader connection; returned to the pool when the lease goes out of scope
+    class ReadLease {
+    private:
+        SqlitePool* pool = nullptr; // Pool the connection goes back to
+        SqliteConnection* connection = nullptr; // Leased connection
+
+    public:
+        ReadLease(SqlitePool* pool, SqliteConnection* connection) : pool(pool), connection(connection) {}
+        ~ReadLease(); // Return the connection to the pool
+
+        ReadLease(ReadLease&& other) noexcept : pool(other.pool), connection(other.connection) { other.pool = nullptr; }
+        ReadLease(const ReadLease&) = delete;
+        ReadLease& operator=(const ReadLease&) = delete;
+        ReadLease& operator=(ReadLease&&) = delete;
+
+        SqliteConnection& operator*() const { return *connection; }
+        SqliteConnection* operator->() const { return connection; }
+    };
+
+    // Exclusive use of the writer connection; other writers wait until the lease goes out of scope
+    class WriteLease {
+    private:
+        unique_lock<mutex> lock; // Held for the lifetime of the lease
+        SqliteConnection* connection = nullptr; // The writer connection
+
+    public:
+        WriteLease(unique_lock<mutex> lock, SqliteConnection* connection) : lock(move(lock)), connection(connection) {}
+
+        WriteLease(WriteLease&&) noexcept = default;
+        WriteLease(const WriteLease&) = delete;
+        WriteLease& operator=(const WriteLease&) = delete;
+        WriteLease& operator=(WriteLease&&) = delete;
+
+        SqliteConnection& operator*() const { return *connection; }
+        SqliteConnection* operator->() const { return connection; }
+    };
+
+    // Connections to one database file in WAL mode: a single writer connection and a fixed set of
+    // read-only connections. Readers see the last committed state and never wait for the writer.
+    class SqlitePool {
+    private:
+        string path; // Database file
+        unique_ptr<SqliteConnection> writerConnection; // Only connection allowed to write
+        mutex writerMutex; // Held by the current WriteLease
+
+        vector<unique_ptr<SqliteConnection>> readerConnections; // Read-only connections
+        vector<SqliteConnection*> idleReaders; // Readers not currently leased
+        mutex readersMutex; // Guards idleReaders
+        condition_variable readerReturned; // Signals that a reader was returned
+
+        friend class ReadLease;
+        void releaseReader(SqliteConnection* connection); // Put a reader back and wake a waiting thread
+
+    public:
+        // Open the writer, switch the file to WAL and open the readers; throws runtime_error on failure
+        SqlitePool(const string& path, size_t readerCount = SQLITE_READER_CONNECTIONS);
+
+        SqlitePool(const SqlitePool&) = delete;
+        SqlitePool& operator=(const SqlitePool&) = delete;
+
+        WriteLease writer(); // Lease the writer connection, waiting for the current writer to finish
+        ReadLease reader(); // Lease a reader connection, waiting if all of them are in use
+        const string& getPath() const { return path; } // Database file
+    };
+
+} // namespace TaxReturnSystem
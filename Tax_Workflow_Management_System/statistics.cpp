@@ -5,15 +5,79 @@
  * This file implements various statistics calculations and filtering methods
  * for different user roles, including:
  * - Project filtering based on criteria
+ * - Per-snapshot status and dependency lookup tables
  * - Deadline and extension statistics
  * - Role-specific statistics calculations
+ *
+ * Statistics read the shared project snapshot instead of querying the
+ * database per project. Next tasks arrive as interned TaskStatus codes and
+ * the dependency graph's edges are resolved once per snapshot, so a
+ * deadline breakdown is a single pass over the rows with a table lookup per
+ * row.
  */
 
 #include "statistics.h"
+#include "statistics_aggregates.h"
+#include "dependency_graph.h"
 #include "CSV_management.h"
+#include <string_view>
+#include <unordered_map>
 
 namespace TaxReturnSystem {
 
+    namespace {
+
+        // Deadline bucket of each status, indexed by TaskStatus
+        constexpr DeadlineCategory DEADLINE_CATEGORIES[static_cast<size_t>(TaskStatus::Count)] = {
+                DeadlineCategory::Other,                // Unknown
+                DeadlineCategory::NotReviewedByPartner, // SignedEngagementLetter
+                DeadlineCategory::NotReviewedByPartner, // SentOpenItemsExtension
+                DeadlineCategory::NotReviewedByPartner, // InformationEntered
+                DeadlineCategory::NotReviewedByPartner, // SentOpenItemsFinalPreparation
+                DeadlineCategory::NotReviewedByPartner, // FinalInformationEntered
+                DeadlineCategory::NotReviewedByPartner, // ReadyForManagerReview
+                DeadlineCategory::NotReviewedByPartner, // ManagerApproved
+                DeadlineCategory::AwaitingReview,       // PartnerReviewed
+                DeadlineCategory::AwaitingCorrections,  // CorrectionsCleared
+                DeadlineCategory::NotFiledYet,          // EFileSent
+                DeadlineCategory::NotFiledYet,          // EFileSigned
+                DeadlineCategory::NotFiledYet,          // TaxReturnFiled
+                DeadlineCategory::Filed                 // Billed
+        };
+
+    } // namespace
+
+    // Definition of a function to bucket a next task status for deadline statistics; takes a TaskStatus as parameter; returns DeadlineCategory
+    DeadlineCategory classifyDeadlineTask(TaskStatus status) {
+        return DEADLINE_CATEGORIES[static_cast<size_t>(status)];
+    }
+
+// SNAPSHOT STATUS INDEX CLASS METHODS:
+
+    // Definition of the constructor; takes a project snapshot and the dependency graph as parameters
+    SnapshotStatusIndex::SnapshotStatusIndex(shared_ptr<const ProjectSnapshot> snapshotPtr, const DependencyGraph& dependencyGraph)
+            : snapshot(move(snapshotPtr)) {
+        // Resolve the graph's edges against this snapshot's statuses, so the table matches the rows it describes
+        const size_t rowCount = snapshot->size();
+        unordered_map<string_view, uint32_t> rowById;
+        rowById.reserve(rowCount);
+        for (uint32_t row = 0; row < rowCount; row++) {
+            rowById.emplace(snapshot->getId(row), row);
+        }
+
+        dependenciesMet.assign(rowCount, 1);
+        dependencyGraph.forEachEdge([&](const string& projectId, const string& dependsOnId) {
+            auto project = rowById.find(projectId);
+            auto dependency = rowById.find(dependsOnId);
+            if (project != rowById.end() && dependency != rowById.end() &&
+                snapshot->getTaskStatus(dependency->second) != TaskStatus::Billed) {
+                dependenciesMet[project->second] = 0;
+            }
+        });
+    }
+
+// STATISTICS CLASS METHODS:
+
     // Definition of a method to check if a project matches filter criteria; takes Project and StatsFilter as parameters; returns bool
     bool Statistics::projectMatchesFilter(const Project& project, const StatsFilter& filter) const {
         // Check if project matches regular deadline filter
@@ -46,15 +110,49 @@ namespace TaxReturnSystem {
         return true;
     }
 
+    // Definition of a method to check if a snapshot row matches filter criteria; takes a snapshot, row and StatsFilter as parameters; returns bool
+    bool Statistics::rowMatchesFilter(const ProjectSnapshot& snapshot, size_t row, const StatsFilter& filter) const {
+        // Same rules as projectMatchesFilter, read straight from the snapshot columns
+        if (filter.regularDeadline) {
+            if (snapshot.getReportType(row) != ReportType::RegularDeadline ||
+                snapshot.getRegularDeadlineValue(row) > filter.regularDeadline->getValue()) return false;
+        }
+        if (filter.internalDeadline) {
+            if (snapshot.getReportType(row) != ReportType::InternalDeadline ||
+                snapshot.getInternalDeadlineValue(row) > filter.internalDeadline->getValue()) return false;
+        }
+
+        if (filter.manager && snapshot.getManager(row) != *filter.manager) return false;
+        if (filter.partner && snapshot.getPartner(row) != *filter.partner) return false;
+        if (filter.group && snapshot.getGroup(row) != *filter.group) return false;
+        if (filter.projectType && snapshot.getProjectType(row) != *filter.projectType) return false;
+
+        return true;
+    }
+
+    // Definition of a method to get the status index of the current snapshot; takes no parameters; returns shared pointer to SnapshotStatusIndex
+    shared_ptr<const SnapshotStatusIndex> Statistics::getStatusIndex() const {
+        shared_ptr<const ProjectSnapshot> snapshot = database->getSnapshot();
+
+        shared_ptr<const SnapshotStatusIndex> index = atomic_load(&statusIndex);
+        if (!index || index->getVersion() != snapshot->getVersion()) {
+            // Racing callers may both build an index for the same snapshot; either result is correct
+            index = make_shared<const SnapshotStatusIndex>(snapshot, database->getDependencyGraph());
+            atomic_store(&statusIndex, index);
+        }
+        return index;
+    }
+
     // Definition of a method to get filtered projects; takes StatsFilter as parameter; returns vector of Projects
     vector<Project> Statistics::getFilteredProjects(const StatsFilter& filter) const {
         // Initialize vector for filtered projects
         vector<Project> filteredProjects;
 
-        // Iterate through all projects and apply filter
-        for (const auto& project : database->getAllProjects()) {
-            if (projectMatchesFilter(project, filter)) {
-                filteredProjects.push_back(project);
+        // Filter on the snapshot columns and only materialize matching rows
+        shared_ptr<const ProjectSnapshot> snapshot = database->getSnapshot();
+        for (size_t row = 0; row < snapshot->size(); row++) {
+            if (rowMatchesFilter(*snapshot, row, filter)) {
+                filteredProjects.push_back(snapshot->toProject(row));
             }
         }
 
@@ -63,90 +161,65 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get statistics per deadline; takes StatsFilter as parameter; returns map of Date to DeadlineStats
     map<Date, DeadlineStats> Statistics::getProjectsPerDeadlineCommon(const StatsFilter& filter) const {
+        // Read the maintained counters when the filter is keyed on their dimensions
+        if (auto aggregated = database->getAggregates().getProjectsPerDeadline(filter)) {
+            return move(*aggregated);
+        }
+
         // Initialize statistics map
         map<Date, DeadlineStats> stats;
 
-        // Process each filtered project
-        for (const auto& project : getFilteredProjects(filter)) {
-            // Determine appropriate deadline based on report type
-            Date deadline;
-            if (project.getReportType() == ReportType::RegularDeadline) {
-                deadline = project.getRegularDeadline();
-            } else {
-                deadline = project.getInternalDeadline();
+        shared_ptr<const SnapshotStatusIndex> index = getStatusIndex();
+        const ProjectSnapshot& snapshot = index->getSnapshot();
+
+        // Consecutive rows often share a deadline, so keep the last bucket instead of searching the map each time
+        int lastDeadline = 0;
+        DeadlineStats* deadlineStats = nullptr;
+
+        // Process each filtered row in one pass
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            if (!rowMatchesFilter(snapshot, row, filter)) {
+                continue;
             }
 
+            // Determine appropriate deadline based on report type
+            int deadline = snapshot.getReportType(row) == ReportType::RegularDeadline
+                           ? snapshot.getRegularDeadlineValue(row)
+                           : snapshot.getInternalDeadlineValue(row);
+
             // Skip projects with empty deadlines
-            if (deadline.getDateStr().empty()) {
+            if (deadline == 0) {
                 continue;
             }
 
             // Get or create stats for this deadline
-            DeadlineStats& deadlineStats = stats[deadline];
-
-            // Check project dependencies
-            bool dependenciesMet = true;
-            for (const auto& [dependencyId, dependencyType] : project.getDependencies()) {
-                Project dependencyProject;
-                if (database->getProjectFromDatabase(dependencyId, dependencyProject)) {
-                    if (!project.isDependencyMet(dependencyId, dependencyProject.getNextTask())) {
-                        dependenciesMet = false;
-                        break;
-                    }
-                } else {
-                    // Skip if dependency project not found
-                    dependenciesMet = false;
-                    break;
-                }
+            if (!deadlineStats || deadline != lastDeadline) {
+                deadlineStats = &stats[Date::fromValue(deadline)];
+                lastDeadline = deadline;
             }
 
             // Handle projects with unmet dependencies
-            if (!dependenciesMet) {
-                deadlineStats.awaitingDependencies++;
+            if (!index->areDependenciesMet(row)) {
+                deadlineStats->awaitingDependencies++;
                 continue;
             }
 
-            // Get current task and update relevant statistics
-            string nextTask = project.getNextTask();
-
-            // Count projects not reviewed by partner
-            if (nextTask == "Signed Engagement Letter" ||
-                nextTask == "Sent Open Items - Extension" ||
-                nextTask == "Information Entered" ||
-                nextTask == "Sent Open Items - Final Preparation" ||
-                nextTask == "Final Information Entered" ||
-                nextTask == "Ready for Manager Review" ||
-                nextTask == "Manager Approved - Ready for Partner Review") {
-                deadlineStats.notReviewedByPartner++;
-            }
-                // Count projects awaiting review
-            else if (nextTask == "Partner Reviewed") {
-                deadlineStats.awaitingReview++;
-            }
-                // Count projects awaiting corrections
-            else if (nextTask == "Corrections Cleared") {
-                deadlineStats.awaitingCorrections++;
-            }
-                // Count projects not filed yet
-            else if (nextTask == "Corrections Cleared" ||
-                     nextTask == "E-file Sent to Client" ||
-                     nextTask == "E-file Signed by Client" ||
-                     nextTask == "Tax Return Filed") {
-                deadlineStats.notFiledYet++;
-            }
-                // Count filed projects
-            else if (nextTask == "Billed") {
-                deadlineStats.filed++;
+            // Update the counter of the row's bucket
+            switch (index->getCategory(row)) {
+                case DeadlineCategory::NotReviewedByPartner: deadlineStats->notReviewedByPartner++; break;
+                case DeadlineCategory::AwaitingReview: deadlineStats->awaitingReview++; break;
+                case DeadlineCategory::AwaitingCorrections: deadlineStats->awaitingCorrections++; break;
+                case DeadlineCategory::NotFiledYet: deadlineStats->notFiledYet++; break;
+                case DeadlineCategory::Filed: deadlineStats->filed++; break;
+                case DeadlineCategory::Other: break;
             }
 
             // Check filing late status based on extension and billing partner
-            if (project.isExtended() || project.getBillingPartner().find("Filing Late") != string::npos) {
-                if (project.isExtended()) {
-                    deadlineStats.filingLate++;
-                }
-                if (project.getBillingPartner().find("Filing Late") != string::npos) {
-                    deadlineStats.filingLate++;
-                }
+            if (snapshot.isExtended(row)) {
+                deadlineStats->filingLate++;
+            }
+            if (snapshot.getBillingPartner(row).find("Filing Late") != string::npos) {
+                deadlineStats->filingLate++;
             }
         }
 
@@ -157,12 +230,20 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get the total number of filtered projects; takes StatsFilter as parameter; returns int
     int BPStatistics::getTotalProjects(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getTotalProjects(filter)) {
+            return *aggregated;
+        }
+
         // Get the size of the filtered projects vector
         return getFilteredProjects(filter).size();
     }
 
     // Definition of a method to get extension statistics; takes StatsFilter as parameter; returns ExtensionStats
     ExtensionStats BPStatistics::getExtensionStats(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getExtensionStats(filter)) {
+            return *aggregated;
+        }
+
         // Initialize stats structure with zeros for extended, filed, and unextended counts
         ExtensionStats stats = {0, 0, 0};
 
@@ -180,7 +261,7 @@ namespace TaxReturnSystem {
                 }
             }
                 // Check if project is filed
-            else if (project.getNextTask() == "Billed") {
+            else if (project.getTaskStatus() == TaskStatus::Billed) {
                 stats.filed++;
             }
                 // Project is neither extended nor filed
@@ -200,6 +281,10 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get statistics per internal deadline; takes StatsFilter as parameter; returns map of Date to InternalDeadlineStats
     map<Date, InternalDeadlineStats> BPStatistics::getProjectsPerInternalDeadline(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getProjectsPerInternalDeadline(filter)) {
+            return move(*aggregated);
+        }
+
         // Initialize statistics map
         map<Date, InternalDeadlineStats> stats;
 
@@ -228,12 +313,20 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get the total number of filtered projects; takes StatsFilter as parameter; returns int
     int PartnerStatistics::getTotalProjects(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getTotalProjects(filter)) {
+            return *aggregated;
+        }
+
         // Get the size of the filtered projects vector
         return getFilteredProjects(filter).size();
     }
 
     // Definition of a method to get extension statistics; takes StatsFilter as parameter; returns ExtensionStats
     ExtensionStats PartnerStatistics::getExtensionStats(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getExtensionStats(filter)) {
+            return *aggregated;
+        }
+
         // Initialize stats structure with zeros for extended, filed, and unextended counts
         ExtensionStats stats = {0, 0, 0};
 
@@ -251,7 +344,7 @@ namespace TaxReturnSystem {
                 }
             }
                 // Check if project is filed
-            else if (project.getNextTask() == "Billed") {
+            else if (project.getTaskStatus() == TaskStatus::Billed) {
                 stats.filed++;
             }
                 // Project is neither extended nor filed
@@ -271,6 +364,14 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get statistics per internal deadline; takes StatsFilter as parameter; returns map of Date to InternalDeadlineStats
     map<Date, InternalDeadlineStats> PartnerStatistics::getProjectsPerInternalDeadline(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getProjectsPerInternalDeadline(filter)) {
+            // Partner view has no per-partner breakdown
+            for (auto& [deadline, internalDeadlineStats] : *aggregated) {
+                internalDeadlineStats.byPartner.clear();
+            }
+            return move(*aggregated);
+        }
+
         // Initialize statistics map
         map<Date, InternalDeadlineStats> stats;
 
@@ -298,12 +399,20 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get the total number of filtered projects; takes StatsFilter as parameter; returns int
     int ManagerStatistics::getTotalProjects(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getTotalProjects(filter)) {
+            return *aggregated;
+        }
+
         // Get the size of the filtered projects vector
         return getFilteredProjects(filter).size();
     }
 
     // Definition of a method to get extension statistics; takes StatsFilter as parameter; returns ExtensionStats
     ExtensionStats ManagerStatistics::getExtensionStats(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getExtensionStats(filter)) {
+            return *aggregated;
+        }
+
         // Initialize stats structure with zeros for extended, filed, and unextended counts
         ExtensionStats stats = {0, 0, 0};
 
@@ -321,7 +430,7 @@ namespace TaxReturnSystem {
                 }
             }
                 // Check if project is filed
-            else if (project.getNextTask() == "Billed") {
+            else if (project.getTaskStatus() == TaskStatus::Billed) {
                 stats.filed++;
             }
                 // Project is neither extended nor filed
@@ -341,6 +450,14 @@ namespace TaxReturnSystem {
 
     // Definition of a method to get statistics per internal deadline; takes StatsFilter as parameter; returns map of Date to InternalDeadlineStats
     map<Date, InternalDeadlineStats> ManagerStatistics::getProjectsPerInternalDeadline(const StatsFilter& filter) const {
+        if (auto aggregated = database->getAggregates().getProjectsPerInternalDeadline(filter)) {
+            // Manager view has no per-manager breakdown
+            for (auto& [deadline, internalDeadlineStats] : *aggregated) {
+                internalDeadlineStats.byManager.clear();
+            }
+            return move(*aggregated);
+        }
+
         // Initialize statistics map
         map<Date, InternalDeadlineStats> stats;
 
@@ -383,28 +500,15 @@ namespace TaxReturnSystem {
     // Definition of a method to get projects awaiting corrections; takes StatsFilter as parameter; returns vector of Projects
     vector<Project> Statistics::getAwaitingCorrectionsProjects(const StatsFilter& filter) const {
         vector<Project> result;
-        for (const auto& project : getFilteredProjects(filter)) {
-            // Check if project is awaiting corrections
-            if (project.getNextTask() == "Corrections Cleared") {
-                // Check if all dependencies are met
-                bool dependenciesMet = true;
-                for (const auto& [dependencyId, dependencyType] : project.getDependencies()) {
-                    Project dependencyProject;
-                    if (database->getProjectFromDatabase(dependencyId, dependencyProject)) {
-                        if (!project.isDependencyMet(dependencyId, dependencyProject.getNextTask())) {
-                            dependenciesMet = false;
-                            break;
-                        }
-                    } else {
-                        dependenciesMet = false;
-                        break;
-                    }
-                }
-
-                // Only include project if dependencies are met
-                if (dependenciesMet) {
-                    result.push_back(project);
-                }
+        shared_ptr<const SnapshotStatusIndex> index = getStatusIndex();
+        const ProjectSnapshot& snapshot = index->getSnapshot();
+
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            // Include projects awaiting corrections whose dependencies are met
+            if (index->getCategory(row) == DeadlineCategory::AwaitingCorrections &&
+                index->areDependenciesMet(row) &&
+                rowMatchesFilter(snapshot, row, filter)) {
+                result.push_back(snapshot.toProject(row));
             }
         }
         return result;
@@ -413,35 +517,15 @@ namespace TaxReturnSystem {
     // Definition of a method to get projects awaiting e-file authorization; takes StatsFilter as parameter; returns vector of Projects
     vector<Project> Statistics::getAwaitingEFileAuthProjects(const StatsFilter& filter) const {
         vector<Project> result;
-        for (const auto& project : getFilteredProjects(filter)) {
-            // Check if project is awaiting e-file authorization
-            if (project.getNextTask() == "E-file Sent to Client") {  // Removed "E-file Authorization Pending" check
-                // Skip dependency check if there are no dependencies
-                if (project.getDependencies().empty()) {
-                    result.push_back(project);
-                    continue;
-                }
-
-                // Check if all dependencies are met
-                bool dependenciesMet = true;
-                for (const auto& [dependencyId, dependencyType] : project.getDependencies()) {
-                    Project dependencyProject;
-                    if (database->getProjectFromDatabase(dependencyId, dependencyProject)) {
-                        if (!project.isDependencyMet(dependencyId, dependencyProject.getNextTask())) {
-                            dependenciesMet = false;
-                            break;
-                        }
-                    } else {
-                        // Only mark dependencies as not met if the dependency exists but isn't met
-                        // Missing dependencies might be okay in some cases
-                        continue;
-                    }
-                }
-
-                // Only include project if dependencies are met or if there was an issue checking them
-                if (dependenciesMet) {
-                    result.push_back(project);
-                }
+        shared_ptr<const SnapshotStatusIndex> index = getStatusIndex();
+        const ProjectSnapshot& snapshot = index->getSnapshot();
+
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            // Include projects awaiting e-file authorization whose dependencies are met
+            if (snapshot.getTaskStatus(row) == TaskStatus::EFileSent &&
+                index->areDependenciesMet(row) &&
+                rowMatchesFilter(snapshot, row, filter)) {
+                result.push_back(snapshot.toProject(row));
             }
         }
         return result;
@@ -6,8 +6,10 @@
 #include <optional>
 #include <memory>
 #include <functional>
+#include <cstdint>
 #include "user.h"
 #include "CSV_management.h"
+#include "project_snapshot.h"
 
 using namespace std;
 
@@ -47,11 +49,41 @@ namespace TaxReturnSystem {
         map<string, int> byManager; // Projects by manager
     };
 
+    // Deadline statistics bucket a project's next task falls into
+    enum class DeadlineCategory : uint8_t {
+        Other,
+        NotReviewedByPartner,
+        AwaitingReview,
+        AwaitingCorrections,
+        NotFiledYet,
+        Filed
+    };
+
+    DeadlineCategory classifyDeadlineTask(TaskStatus status); // Bucket for a next task status
+
+    // Dependency table built once per project snapshot, so statistics never query the database per project
+    class SnapshotStatusIndex {
+    private:
+        shared_ptr<const ProjectSnapshot> snapshot; // Snapshot the tables describe
+        vector<uint8_t> dependenciesMet; // Per row: whether every project it depends on is billed
+
+    public:
+        SnapshotStatusIndex(shared_ptr<const ProjectSnapshot> snapshot, const DependencyGraph& dependencyGraph); // Constructor; builds the tables
+
+        const ProjectSnapshot& getSnapshot() const { return *snapshot; } // Get the indexed snapshot
+        uint64_t getVersion() const { return snapshot->getVersion(); } // Get the indexed snapshot's version
+        DeadlineCategory getCategory(size_t row) const { return classifyDeadlineTask(snapshot->getTaskStatus(row)); } // Bucket of a row's next task
+        bool areDependenciesMet(size_t row) const { return dependenciesMet[row] != 0; } // Whether a row's dependencies are met
+    };
+
     // Base statistics class
     class Statistics {
     protected:
         shared_ptr<ProjectsDatabase> database; // Database pointer
+        mutable shared_ptr<const SnapshotStatusIndex> statusIndex; // Index of the latest snapshot seen; accessed atomically
         map<Date, DeadlineStats> getProjectsPerDeadlineCommon(const StatsFilter& filter) const; // Common deadline stats method
+        shared_ptr<const SnapshotStatusIndex> getStatusIndex() const; // Index of the current snapshot, rebuilt only when the data changed
+        bool rowMatchesFilter(const ProjectSnapshot& snapshot, size_t row, const StatsFilter& filter) const; // Check if a snapshot row matches filter
 
     public:
         Statistics(shared_ptr<ProjectsDatabase> db) : database(db) {} // Constructor
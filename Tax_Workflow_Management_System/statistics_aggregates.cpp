@@ -0,0 +1,422 @@
+/**
+ * @file statistics_aggregates.cpp
+ * @brief Implementation of incrementally maintained statistics counters
+ *
+ * This file contains implementations for:
+ * - Building the counters from a project snapshot
+ * - Applying insert, update, delete and import deltas
+ * - Serving the Statistics and dashboard reads from the counters
+ *
+ * Every project adds its counts to three dimensions: all projects, its
+ * manager and its partner. Within a dimension counts are kept per report
+ * type and deadline, so a read only walks the deadlines it returns.
+ * Dependency state comes from the DependencyGraph; each record keeps the
+ * state it was counted with, and the projects a graph change affected are
+ * recounted after the change itself.
+ */
+
+#include "statistics_aggregates.h"
+#include "report_generator.h"
+#include <climits>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Adjust a per-name count, dropping names that reach zero
+        void adjustCount(map<string, int>& counts, const string& name, int sign) {
+            int& count = counts[name];
+            count += sign;
+            if (count == 0) {
+                counts.erase(name);
+            }
+        }
+
+        // Add one set of deadline counters to another
+        void addDeadlineStats(DeadlineStats& total, const DeadlineStats& stats) {
+            total.notReviewedByPartner += stats.notReviewedByPartner;
+            total.awaitingReview += stats.awaitingReview;
+            total.awaitingCorrections += stats.awaitingCorrections;
+            total.notFiledYet += stats.notFiledYet;
+            total.filed += stats.filed;
+            total.filingLate += stats.filingLate;
+            total.awaitingDependencies += stats.awaitingDependencies;
+        }
+
+        // Add one set of per-name counts to another
+        void addCounts(map<string, int>& total, const map<string, int>& counts) {
+            for (const auto& [name, count] : counts) {
+                total[name] += count;
+            }
+        }
+
+    } // namespace
+
+// STATISTICS AGGREGATES CLASS METHODS:
+
+    // Definition of the constructor; takes the dependency graph as parameter
+    StatisticsAggregates::StatisticsAggregates(const DependencyGraph& dependencyGraph) : dependencyGraph(dependencyGraph) {}
+
+    // Definition of a method to copy the counted columns of a project; takes a Project as parameter; returns ProjectRecord
+    StatisticsAggregates::ProjectRecord StatisticsAggregates::makeRecord(const Project& project) {
+        ProjectRecord record;
+        record.group = project.getGroup();
+        record.client = project.getClient();
+        record.projectType = project.getProjectType();
+        assignUpdatedColumns(record, project);
+        return record;
+    }
+
+    // Definition of a method to copy the columns an UPDATE writes, except the group; takes a record and a Project as parameters; returns void
+    void StatisticsAggregates::assignUpdatedColumns(ProjectRecord& record, const Project& project) {
+        record.billingPartner = project.getBillingPartner();
+        record.partner = project.getPartner();
+        record.manager = project.getManager();
+        record.status = project.getTaskStatus();
+        record.regularDeadline = project.getRegularDeadline().getValue();
+        record.internalDeadline = project.getInternalDeadline().getValue();
+        record.extended = project.isExtended();
+        record.reportType = project.getReportType();
+    }
+
+    // Definition of a method to add or subtract a project's counts; takes a record and a sign as parameters; returns void
+    void StatisticsAggregates::contribute(const ProjectRecord& record, int sign) {
+        const int deadline = record.reportType == ReportType::RegularDeadline
+                             ? record.regularDeadline : record.internalDeadline;
+        const pair<int, int> bucketKey(static_cast<int>(record.reportType), deadline);
+
+        const bool dependenciesMet = record.dependenciesMet;
+        const DeadlineCategory category = classifyDeadlineTask(record.status);
+        const int extendedFlag = record.extended ? 1 : 0;
+        const int extendedTag = record.billingPartner.find("Extended") != string::npos ? 1 : 0;
+        const int filingLateTag = record.billingPartner.find("Filing Late") != string::npos ? 1 : 0;
+
+        const pair<Dimension, string> dimensions[] = {
+                {Dimension::All, string()},
+                {Dimension::Manager, record.manager},
+                {Dimension::Partner, record.partner}
+        };
+
+        for (const auto& dimension : dimensions) {
+            DimensionCounters& dimensionCounters = counters[dimension];
+
+            // Internal deadline breakdown
+            DeadlineBucket& bucket = dimensionCounters.buckets[bucketKey];
+            InternalDeadlineStats& internalStats = bucket.internalStats;
+            internalStats.total += sign;
+            adjustCount(internalStats.byGroup, record.group, sign);
+            adjustCount(internalStats.byProjectType, record.projectType, sign);
+            adjustCount(internalStats.byPartner, record.partner, sign);
+            adjustCount(internalStats.byManager, record.manager, sign);
+
+            // Extension counts, with the same double counting of flag and tag as the scanning path
+            ExtensionStats& extensionStats = bucket.extensionStats;
+            if (extendedFlag || extendedTag) {
+                extensionStats.extended += sign * (extendedFlag + extendedTag);
+            } else if (category == DeadlineCategory::Filed) {
+                extensionStats.filed += sign;
+            } else {
+                extensionStats.unextended += sign;
+            }
+
+            // Deadline breakdown, which skips projects without a deadline
+            if (deadline != 0) {
+                DeadlineStats& deadlineStats = bucket.deadlineStats;
+                if (!dependenciesMet) {
+                    deadlineStats.awaitingDependencies += sign;
+                } else {
+                    switch (category) {
+                        case DeadlineCategory::NotReviewedByPartner: deadlineStats.notReviewedByPartner += sign; break;
+                        case DeadlineCategory::AwaitingReview: deadlineStats.awaitingReview += sign; break;
+                        case DeadlineCategory::AwaitingCorrections: deadlineStats.awaitingCorrections += sign; break;
+                        case DeadlineCategory::NotFiledYet: deadlineStats.notFiledYet += sign; break;
+                        case DeadlineCategory::Filed: deadlineStats.filed += sign; break;
+                        case DeadlineCategory::Other: break;
+                    }
+                    deadlineStats.filingLate += sign * (extendedFlag + filingLateTag);
+                }
+            }
+
+            if (internalStats.total == 0) {
+                dimensionCounters.buckets.erase(bucketKey);
+            }
+
+            // Dashboard counters, keyed by regular deadline whatever the report type
+            DashboardCounts& dashboard = dimensionCounters.dashboard[record.regularDeadline];
+            dashboard.totalProjects += sign;
+            if (ReportConditions::isNotFiled(record.status)) dashboard.notFiled += sign;
+            if (ReportConditions::isNotReviewed(record.status)) dashboard.notReviewed += sign;
+            if (ReportConditions::isAwaitingCorrections(record.status)) dashboard.awaitingCorrections += sign;
+            if (ReportConditions::isAwaitingEFileAuthorization(record.status)) dashboard.awaitingEFileAuth += sign;
+            if (ReportConditions::isUnextended(record.billingPartner)) dashboard.unextended += sign;
+            if (record.extended) dashboard.extended += sign;
+
+            if (dashboard.totalProjects == 0) {
+                dimensionCounters.dashboard.erase(record.regularDeadline);
+            }
+
+            if (dimensionCounters.buckets.empty() && dimensionCounters.dashboard.empty()) {
+                counters.erase(dimension);
+            }
+        }
+    }
+
+    // Definition of a method to replace a stored project; takes an id and the new record or nullptr as parameters; returns void
+    void StatisticsAggregates::replaceRecord(const string& id, const ProjectRecord* newRecord) {
+        auto existing = records.find(id);
+        if (existing != records.end()) {
+            contribute(existing->second, -1);
+            records.erase(existing);
+        }
+
+        if (newRecord) {
+            ProjectRecord& stored = records[id] = *newRecord;
+            stored.dependenciesMet = !dependencyGraph.isAwaitingDependencies(id);
+            contribute(stored, 1);
+        }
+    }
+
+    // Definition of a method to recount projects whose dependency state may have changed; takes a list of ids as parameter; returns void
+    void StatisticsAggregates::refreshDependencies(const vector<string>& ids) {
+        for (const string& id : ids) {
+            auto record = records.find(id);
+            if (record == records.end()) continue;
+
+            bool dependenciesMet = !dependencyGraph.isAwaitingDependencies(id);
+            if (record->second.dependenciesMet != dependenciesMet) {
+                contribute(record->second, -1);
+                record->second.dependenciesMet = dependenciesMet;
+                contribute(record->second, 1);
+            }
+        }
+    }
+
+    // Definition of a method to replace every counter with counts from a snapshot; takes a ProjectSnapshot as parameter; returns void
+    void StatisticsAggregates::rebuild(const ProjectSnapshot& snapshot) {
+        lock_guard<mutex> lock(aggregatesMutex);
+
+        records.clear();
+        counters.clear();
+        records.reserve(snapshot.size());
+
+        for (size_t row = 0; row < snapshot.size(); row++) {
+            ProjectRecord record;
+            record.group = snapshot.getGroup(row);
+            record.client = snapshot.getClient(row);
+            record.projectType = snapshot.getProjectType(row);
+            record.billingPartner = snapshot.getBillingPartner(row);
+            record.partner = snapshot.getPartner(row);
+            record.manager = snapshot.getManager(row);
+            record.status = snapshot.getTaskStatus(row);
+            record.regularDeadline = snapshot.getRegularDeadlineValue(row);
+            record.internalDeadline = snapshot.getInternalDeadlineValue(row);
+            record.extended = snapshot.isExtended(row);
+            record.reportType = snapshot.getReportType(row);
+            record.dependenciesMet = !dependencyGraph.isAwaitingDependencies(snapshot.getId(row));
+
+            contribute(record, 1);
+            records[snapshot.getId(row)] = move(record);
+        }
+    }
+
+    // Definition of a method to insert or replace a project; takes an id, a Project and the graph changes as parameters; returns void
+    void StatisticsAggregates::upsertProject(const string& id, const Project& project, const DependencyChanges& changes) {
+        ProjectRecord record = makeRecord(project);
+        lock_guard<mutex> lock(aggregatesMutex);
+        replaceRecord(id, &record);
+        refreshDependencies(changes.affectedProjects);
+    }
+
+    // Definition of a method to apply an update of a project's mutable columns; takes a Project and the graph changes as parameters; returns void
+    void StatisticsAggregates::updateProject(const Project& project, const DependencyChanges& changes) {
+        lock_guard<mutex> lock(aggregatesMutex);
+        auto existing = records.find(project.getId());
+        if (existing != records.end()) {
+            ProjectRecord record = existing->second;
+            assignUpdatedColumns(record, project);
+            replaceRecord(project.getId(), &record);
+        }
+        refreshDependencies(changes.affectedProjects);
+    }
+
+    // Definition of a method to remove a project; takes an id and the graph changes as parameters; returns void
+    void StatisticsAggregates::removeProject(const string& id, const DependencyChanges& changes) {
+        lock_guard<mutex> lock(aggregatesMutex);
+        replaceRecord(id, nullptr);
+        refreshDependencies(changes.affectedProjects);
+    }
+
+    // Definition of a method to apply an import diff; takes an ImportDiff and the graph changes as parameters; returns void
+    void StatisticsAggregates::applyImportDiff(const ImportDiff& diff, const DependencyChanges& changes) {
+        lock_guard<mutex> lock(aggregatesMutex);
+
+        // Same order as ProjectsDatabase::applyImportDiff: removals, updates, then additions
+        for (const string& id : diff.removals) {
+            replaceRecord(id, nullptr);
+        }
+
+        for (const Project& project : diff.updates) {
+            auto existing = records.find(project.getId());
+            if (existing == records.end()) {
+                continue;
+            }
+            ProjectRecord record = existing->second;
+            record.group = project.getGroup();
+            assignUpdatedColumns(record, project);
+            replaceRecord(project.getId(), &record);
+        }
+
+        for (const Project& project : diff.additions) {
+            ProjectRecord record = makeRecord(project);
+            replaceRecord(project.generateId(), &record);
+        }
+
+        refreshDependencies(changes.affectedProjects);
+    }
+
+    // Definition of a method to pick the counters a filter can be served from; takes StatsFilter as parameter; returns optional dimension key
+    optional<pair<StatisticsAggregates::Dimension, string>> StatisticsAggregates::dimensionFor(const StatsFilter& filter) const {
+        if (filter.group || filter.projectType || (filter.manager && filter.partner)) {
+            return nullopt;
+        }
+        if (filter.manager) {
+            return make_pair(Dimension::Manager, *filter.manager);
+        }
+        if (filter.partner) {
+            return make_pair(Dimension::Partner, *filter.partner);
+        }
+        return make_pair(Dimension::All, string());
+    }
+
+    // Definition of a method to visit the buckets of a dimension within a filter's deadline limits; takes a dimension key, StatsFilter and visitor as parameters; returns void
+    template <typename Visit>
+    void StatisticsAggregates::forEachBucket(const pair<Dimension, string>& dimension, const StatsFilter& filter, Visit visit) const {
+        auto dimensionCounters = counters.find(dimension);
+        if (dimensionCounters == counters.end()) {
+            return;
+        }
+        const auto& buckets = dimensionCounters->second.buckets;
+
+        // A deadline filter keeps one report type and deadlines up to its date; both filters together match nothing
+        auto visitReportType = [&](ReportType reportType, int latestDeadline) {
+            const int type = static_cast<int>(reportType);
+            auto bucket = buckets.lower_bound({type, INT_MIN});
+            auto last = buckets.upper_bound({type, latestDeadline});
+            for (; bucket != last; ++bucket) {
+                visit(bucket->first.second, bucket->second);
+            }
+        };
+
+        if (filter.regularDeadline && filter.internalDeadline) {
+            return;
+        }
+        if (filter.regularDeadline) {
+            visitReportType(ReportType::RegularDeadline, filter.regularDeadline->getValue());
+        } else if (filter.internalDeadline) {
+            visitReportType(ReportType::InternalDeadline, filter.internalDeadline->getValue());
+        } else {
+            for (const auto& [key, bucket] : buckets) {
+                visit(key.second, bucket);
+            }
+        }
+    }
+
+    // Definition of a method to count projects matching a filter; takes StatsFilter as parameter; returns optional int
+    optional<int> StatisticsAggregates::getTotalProjects(const StatsFilter& filter) const {
+        lock_guard<mutex> lock(aggregatesMutex);
+        auto dimension = dimensionFor(filter);
+        if (!dimension) {
+            return nullopt;
+        }
+
+        int total = 0;
+        forEachBucket(*dimension, filter, [&](int, const DeadlineBucket& bucket) {
+            total += bucket.internalStats.total;
+        });
+        return total;
+    }
+
+    // Definition of a method to get extension statistics; takes StatsFilter as parameter; returns optional ExtensionStats
+    optional<ExtensionStats> StatisticsAggregates::getExtensionStats(const StatsFilter& filter) const {
+        lock_guard<mutex> lock(aggregatesMutex);
+        auto dimension = dimensionFor(filter);
+        if (!dimension) {
+            return nullopt;
+        }
+
+        ExtensionStats stats = {0, 0, 0};
+        forEachBucket(*dimension, filter, [&](int, const DeadlineBucket& bucket) {
+            stats.extended += bucket.extensionStats.extended;
+            stats.unextended += bucket.extensionStats.unextended;
+            stats.filed += bucket.extensionStats.filed;
+        });
+        return stats;
+    }
+
+    // Definition of a method to get statistics per deadline; takes StatsFilter as parameter; returns optional map of Date to DeadlineStats
+    optional<map<Date, DeadlineStats>> StatisticsAggregates::getProjectsPerDeadline(const StatsFilter& filter) const {
+        lock_guard<mutex> lock(aggregatesMutex);
+        auto dimension = dimensionFor(filter);
+        if (!dimension) {
+            return nullopt;
+        }
+
+        map<Date, DeadlineStats> stats;
+        forEachBucket(*dimension, filter, [&](int deadline, const DeadlineBucket& bucket) {
+            if (deadline != 0) {
+                addDeadlineStats(stats[Date::fromValue(deadline)], bucket.deadlineStats);
+            }
+        });
+        return stats;
+    }
+
+    // Definition of a method to get statistics per internal deadline; takes StatsFilter as parameter; returns optional map of Date to InternalDeadlineStats
+    optional<map<Date, InternalDeadlineStats>> StatisticsAggregates::getProjectsPerInternalDeadline(const StatsFilter& filter) const {
+        lock_guard<mutex> lock(aggregatesMutex);
+        auto dimension = dimensionFor(filter);
+        if (!dimension) {
+            return nullopt;
+        }
+
+        map<Date, InternalDeadlineStats> stats;
+        forEachBucket(*dimension, filter, [&](int deadline, const DeadlineBucket& bucket) {
+            InternalDeadlineStats& total = stats[Date::fromValue(deadline)];
+            total.total += bucket.internalStats.total;
+            addCounts(total.byGroup, bucket.internalStats.byGroup);
+            addCounts(total.byProjectType, bucket.internalStats.byProjectType);
+            addCounts(total.byPartner, bucket.internalStats.byPartner);
+            addCounts(total.byManager, bucket.internalStats.byManager);
+        });
+        return stats;
+    }
+
+    // Definition of a method to get the dashboard counters; takes an optional manager and deadline bounds as parameters; returns DashboardCounts
+    DashboardCounts StatisticsAggregates::getDashboardCounts(const optional<string>& manager, optional<int> from, optional<int> to) const {
+        lock_guard<mutex> lock(aggregatesMutex);
+        DashboardCounts counts;
+
+        auto dimensionCounters = counters.find(manager ? make_pair(Dimension::Manager, *manager)
+                                                       : make_pair(Dimension::All, string()));
+        if (dimensionCounters == counters.end() || (from && to && *from > *to)) {
+            return counts;
+        }
+
+        const auto& dashboard = dimensionCounters->second.dashboard;
+        auto entry = from ? dashboard.lower_bound(*from) : dashboard.begin();
+        auto last = to ? dashboard.upper_bound(*to) : dashboard.end();
+        for (; entry != last; ++entry) {
+            const DashboardCounts& deadlineCounts = entry->second;
+            counts.totalProjects += deadlineCounts.totalProjects;
+            counts.notFiled += deadlineCounts.notFiled;
+            counts.notReviewed += deadlineCounts.notReviewed;
+            counts.awaitingCorrections += deadlineCounts.awaitingCorrections;
+            counts.awaitingEFileAuth += deadlineCounts.awaitingEFileAuth;
+            counts.unextended += deadlineCounts.unextended;
+            counts.extended += deadlineCounts.extended;
+        }
+        return counts;
+    }
+
+} // namespace TaxReturnSystem
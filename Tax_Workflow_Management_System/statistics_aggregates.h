@@ -0,0 +1,102 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <optional>
+#include <unordered_map>
+#include "statistics.h"
+#include "dependency_graph.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Counters shown on the /statistics dashboard
+    struct DashboardCounts {
+        int totalProjects = 0; // Number of projects
+        int notFiled = 0; // Projects not filed
+        int notReviewed = 0; // Projects not reviewed
+        int awaitingCorrections = 0; // Projects awaiting corrections
+        int awaitingEFileAuth = 0; // Projects awaiting e-file authorization
+        int unextended = 0; // Projects whose billing partner tags are not extended
+        int extended = 0; // Projects flagged as extended
+    };
+
+    // Statistics counters kept up to date from every write to the projects table, so reads never rescan projects
+    class StatisticsAggregates {
+    public:
+        // Role dimension a set of counters is keyed on
+        enum class Dimension : uint8_t {
+            All,
+            Manager,
+            Partner
+        };
+
+    private:
+        // Columns of a stored project that the counters depend on
+        struct ProjectRecord {
+            string group, client, projectType, billingPartner, partner, manager;
+            TaskStatus status = TaskStatus::Unknown; // Interned next task
+            int regularDeadline = 0; // YYYYMMDD, 0 when empty
+            int internalDeadline = 0; // YYYYMMDD, 0 when empty
+            bool extended = false;
+            ReportType reportType = ReportType::RegularDeadline;
+            bool dependenciesMet = true; // Dependency state the record was counted with
+        };
+
+        // Counters of the projects sharing one report type and deadline
+        struct DeadlineBucket {
+            DeadlineStats deadlineStats{}; // Not reported for the empty deadline
+            ExtensionStats extensionStats{};
+            InternalDeadlineStats internalStats{}; // total doubles as the bucket's project count
+        };
+
+        // Counters of one dimension value
+        struct DimensionCounters {
+            map<pair<int, int>, DeadlineBucket> buckets; // Keyed by (report type, deadline of that type)
+            map<int, DashboardCounts> dashboard; // Keyed by regular deadline
+        };
+
+        const DependencyGraph& dependencyGraph; // Source of every project's dependency state
+        mutable mutex aggregatesMutex; // Guards every member below
+        unordered_map<string, ProjectRecord> records; // Stored projects by id
+        map<pair<Dimension, string>, DimensionCounters> counters; // Counters by dimension and value
+
+        static ProjectRecord makeRecord(const Project& project); // Copy the counted columns of a project
+        static void assignUpdatedColumns(ProjectRecord& record, const Project& project); // Copy the columns an UPDATE writes, except the group
+
+        void contribute(const ProjectRecord& record, int sign); // Add (sign 1) or subtract (sign -1) a project's counts
+        void replaceRecord(const string& id, const ProjectRecord* newRecord); // Swap a stored project
+        void refreshDependencies(const vector<string>& ids); // Recount projects whose dependency state may have changed
+
+        // Counters a filter can be served from; nullopt when the filter uses dimensions they are not keyed on
+        optional<pair<Dimension, string>> dimensionFor(const StatsFilter& filter) const;
+
+        // Call visit on every bucket of a dimension that passes the filter's deadline limits
+        template <typename Visit>
+        void forEachBucket(const pair<Dimension, string>& dimension, const StatsFilter& filter, Visit visit) const;
+
+    public:
+        explicit StatisticsAggregates(const DependencyGraph& dependencyGraph); // Constructor; the graph must outlive the counters
+
+        void rebuild(const ProjectSnapshot& snapshot); // Replace every counter with counts from a snapshot
+
+        // Deltas, mirroring the statements run on the projects table; applied after the same change to the dependency graph
+        void upsertProject(const string& id, const Project& project, const DependencyChanges& changes); // Insert or replace a whole project
+        void updateProject(const Project& project, const DependencyChanges& changes); // Update the columns updateProjectInDatabase writes; no-op for unknown ids
+        void removeProject(const string& id, const DependencyChanges& changes); // Remove a project; no-op for unknown ids
+        void applyImportDiff(const ImportDiff& diff, const DependencyChanges& changes); // Apply an import diff's removals, updates and additions
+
+        // Reads, in the shapes of the Statistics interface; nullopt when the filter cannot be served from the counters
+        optional<int> getTotalProjects(const StatsFilter& filter) const;
+        optional<ExtensionStats> getExtensionStats(const StatsFilter& filter) const;
+        optional<map<Date, DeadlineStats>> getProjectsPerDeadline(const StatsFilter& filter) const;
+        optional<map<Date, InternalDeadlineStats>> getProjectsPerInternalDeadline(const StatsFilter& filter) const;
+
+        // Dashboard counters for projects whose regular deadline is in [from, to]; a missing bound is open
+        DashboardCounts getDashboardCounts(const optional<string>& manager, optional<int> from, optional<int> to) const;
+    };
+
+} // namespace TaxReturnSystem
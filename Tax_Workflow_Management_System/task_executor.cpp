@@ -0,0 +1,206 @@
+/**
+ * @file task_executor.cpp
+ * @brief Implementation of the shared work-stealing task executor
+ *
+ * This file contains implementations for:
+ * - Worker threads with their own task deques
+ * - Stealing from other workers when a deque runs dry
+ * - Chunked parallelFor in which the caller takes part
+ *
+ * parallelFor hands out chunks through one atomic counter, so whichever
+ * thread is free takes the next chunk. The calling thread works through
+ * chunks too, which means a nested parallelFor from inside a task always
+ * makes progress even when every worker is busy.
+ */
+
+#include "task_executor.h"
+#include <algorithm>
+#include <exception>
+#include <limits>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        // Shared progress of one parallelFor call; helper tasks may outlive the call, so it is reference counted
+        struct ParallelForState {
+            const TaskExecutor::RangeBody* body; // Only dereferenced while a chunk is unfinished
+            size_t begin; // First index
+            size_t end; // One past the last index
+            size_t grain; // Chunk size
+            size_t chunkCount; // Number of chunks
+            atomic<size_t> nextChunk{0}; // Next chunk to hand out
+            atomic<size_t> finishedChunks{0}; // Chunks completed, including failed ones
+
+            mutex doneMutex; // Paired with done; also guards error
+            condition_variable done; // Signalled when the last chunk finishes
+            exception_ptr error; // First exception thrown by body
+
+            // Run chunks until none are left
+            void runChunks() {
+                size_t chunk;
+                while ((chunk = nextChunk.fetch_add(1)) < chunkCount) {
+                    size_t chunkBegin = begin + chunk * grain;
+                    size_t chunkEnd = min(end, chunkBegin + grain);
+                    try {
+                        (*body)(chunkBegin, chunkEnd);
+                    } catch (...) {
+                        lock_guard<mutex> lock(doneMutex);
+                        if (!error) error = current_exception();
+                    }
+                    if (finishedChunks.fetch_add(1) + 1 == chunkCount) {
+                        lock_guard<mutex> lock(doneMutex);
+                        done.notify_all();
+                    }
+                }
+            }
+        };
+
+    } // namespace
+
+// TASK EXECUTOR CLASS METHODS:
+
+    // Definition of the constructor; takes the number of worker threads as parameter
+    TaskExecutor::TaskExecutor(size_t threadCount) {
+        threadCount = max(size_t(1), threadCount);
+        for (size_t i = 0; i < threadCount; i++) {
+            queues.push_back(make_unique<WorkerQueue>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            workers.emplace_back(&TaskExecutor::workerLoop, this, i);
+        }
+    }
+
+    // Definition of the destructor; lets workers drain their queues and joins them
+    TaskExecutor::~TaskExecutor() {
+        {
+            lock_guard<mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    // Definition of a method to get the process-wide executor; takes no parameters; returns TaskExecutor reference
+    TaskExecutor& TaskExecutor::shared() {
+        static TaskExecutor executor(max(1u, thread::hardware_concurrency()));
+        return executor;
+    }
+
+    // Definition of a method to get the calling thread's worker index; takes no parameters; returns reference to the index
+    size_t& TaskExecutor::currentWorkerIndex() {
+        thread_local size_t index = numeric_limits<size_t>::max();
+        return index;
+    }
+
+    // Definition of a method to queue a task; takes a task as parameter; returns void
+    void TaskExecutor::submit(Task task) {
+        // Workers keep their own spawned tasks local; outside threads spread tasks round-robin
+        size_t index = currentWorkerIndex();
+        if (index >= queues.size()) {
+            index = nextQueue.fetch_add(1) % queues.size();
+        }
+
+        {
+            // Counting the task under sleepMutex, before it is visible, means a worker about to sleep
+            // cannot miss it and a thief can never take it before it is counted
+            lock_guard<mutex> lock(sleepMutex);
+            pendingTasks.fetch_add(1);
+        }
+        {
+            lock_guard<mutex> lock(queues[index]->queueMutex);
+            queues[index]->tasks.push_back(move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Definition of a method to take a task, own deque first, then by stealing; takes a worker index and output task as parameters; returns bool
+    bool TaskExecutor::tryTakeTask(size_t index, Task& task) {
+        if (index < queues.size()) {
+            WorkerQueue& own = *queues[index];
+            lock_guard<mutex> lock(own.queueMutex);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+                pendingTasks.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // Steal the oldest task of another worker, starting from the next one to spread contention
+        size_t start = index < queues.size() ? index + 1 : 0;
+        for (size_t offset = 0; offset < queues.size(); offset++) {
+            size_t victim = (start + offset) % queues.size();
+            if (victim == index) continue;
+
+            WorkerQueue& other = *queues[victim];
+            lock_guard<mutex> lock(other.queueMutex);
+            if (!other.tasks.empty()) {
+                task = move(other.tasks.front());
+                other.tasks.pop_front();
+                pendingTasks.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Definition of a method run by each worker thread; takes the worker index as parameter; returns void
+    void TaskExecutor::workerLoop(size_t index) {
+        currentWorkerIndex() = index;
+
+        while (true) {
+            Task task;
+            if (tryTakeTask(index, task)) {
+                task();
+                continue;
+            }
+
+            unique_lock<mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || pendingTasks.load() > 0; });
+            if (stopping && pendingTasks.load() == 0) {
+                return;
+            }
+        }
+    }
+
+    // Definition of a method to run a range in parallel chunks; takes a range, chunk size and body as parameters; returns void
+    void TaskExecutor::parallelFor(size_t begin, size_t end, size_t grain, const RangeBody& body) {
+        if (begin >= end) {
+            return;
+        }
+        grain = max(size_t(1), grain);
+
+        auto state = make_shared<ParallelForState>();
+        state->body = &body;
+        state->begin = begin;
+        state->end = end;
+        state->grain = grain;
+        state->chunkCount = (end - begin + grain - 1) / grain;
+
+        // One chunk needs no helpers
+        size_t helpers = min(workers.size(), state->chunkCount - 1);
+        for (size_t i = 0; i < helpers; i++) {
+            submit([state] { state->runChunks(); });
+        }
+
+        state->runChunks();
+
+        // Wait for chunks still running on other threads
+        exception_ptr error;
+        {
+            unique_lock<mutex> lock(state->doneMutex);
+            state->done.wait(lock, [&] { return state->finishedChunks.load() == state->chunkCount; });
+            // Take the exception out, since a late helper may release the state on another thread
+            error = move(state->error);
+        }
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Process-wide pool of worker threads with per-worker deques and work stealing
+    class TaskExecutor {
+    public:
+        using Task = function<void()>;
+        using RangeBody = function<void(size_t begin, size_t end)>;
+
+    private:
+        // One worker's deque; the owner pops from the back, thieves take from the front
+        struct WorkerQueue {
+            mutex queueMutex; // Guards tasks
+            deque<Task> tasks; // Pending tasks
+        };
+
+        vector<unique_ptr<WorkerQueue>> queues; // One deque per worker
+        vector<thread> workers; // Worker threads
+        atomic<size_t> nextQueue{0}; // Round-robin target for tasks submitted from outside the pool
+        atomic<size_t> pendingTasks{0}; // Tasks queued but not yet taken
+
+        mutex sleepMutex; // Paired with wake
+        condition_variable wake; // Wakes idle workers
+        bool stopping = false; // Set by the destructor; guarded by sleepMutex
+
+        void workerLoop(size_t index); // Body of each worker thread
+        bool tryTakeTask(size_t index, Task& task); // Pop own work, else steal; index may be out of range for non-workers
+        static size_t& currentWorkerIndex(); // Index of the calling worker, or SIZE_MAX outside the pool
+
+    public:
+        explicit TaskExecutor(size_t threadCount); // Constructor; starts threadCount workers
+        ~TaskExecutor(); // Finishes queued tasks and joins the workers
+
+        TaskExecutor(const TaskExecutor&) = delete;
+        TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+        static TaskExecutor& shared(); // Executor shared by the whole process, one worker per hardware thread
+
+        size_t size() const { return workers.size(); } // Number of worker threads
+
+        void submit(Task task); // Queue a fire-and-forget task
+
+        // Run body over [begin, end) in chunks of at most grain, on the pool and the calling thread; blocks until done
+        // and rethrows the first exception thrown by body. Safe to call from inside a task.
+        void parallelFor(size_t begin, size_t end, size_t grain, const RangeBody& body);
+    };
+
+} // namespace TaxReturnSystem
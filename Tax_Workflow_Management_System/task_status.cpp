@@ -0,0 +1,103 @@
+/**
+ * @file task_status.cpp
+ * @brief Implementation of next task interning
+ *
+ * This file contains implementations for:
+ * - A perfect hash table over the task status strings in config.h
+ * - Conversion of next task strings to TaskStatus codes
+ *
+ * The table is built at compile time. A seed is searched for that places
+ * every status in its own slot of a 64-entry table, so a lookup is one
+ * hash, one table read and one string comparison to reject unknown values.
+ */
+
+#include "task_status.h"
+#include "config.h"
+#include <array>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    namespace {
+
+        constexpr size_t STATUS_COUNT = static_cast<size_t>(TaskStatus::Count);
+
+        // Status strings indexed by TaskStatus
+        constexpr array<string_view, STATUS_COUNT> STATUS_NAMES = {
+                "",
+                TASK_SIGNED_ENGAGEMENT_LETTER,
+                TASK_SENT_OPEN_ITEMS_EXTENSION,
+                TASK_INFORMATION_ENTERED,
+                TASK_SENT_OPEN_ITEMS_FINAL,
+                TASK_FINAL_INFORMATION_ENTERED,
+                TASK_READY_FOR_MANAGER_REVIEW,
+                TASK_MANAGER_APPROVED,
+                TASK_PARTNER_REVIEWED,
+                TASK_CORRECTIONS_CLEARED,
+                TASK_EFILE_SENT,
+                TASK_EFILE_SIGNED,
+                TASK_TAX_RETURN_FILED,
+                TASK_BILLED
+        };
+
+        constexpr size_t TABLE_SIZE = 64; // Power of two, one byte per slot
+        constexpr uint32_t NO_SEED = UINT32_MAX;
+
+        // Seeded FNV-1a with a final mix, so the low bits depend on every byte
+        constexpr uint32_t hashStatus(string_view text, uint32_t seed) {
+            uint32_t hash = 2166136261u ^ seed;
+            for (char c : text) {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 16777619u;
+            }
+            hash ^= hash >> 15;
+            hash *= 0x2c1b3c6du;
+            hash ^= hash >> 12;
+            return hash;
+        }
+
+        constexpr size_t slotOf(string_view text, uint32_t seed) {
+            return hashStatus(text, seed) & (TABLE_SIZE - 1);
+        }
+
+        // Find the first seed that gives every status its own slot
+        constexpr uint32_t findSeed() {
+            for (uint32_t seed = 0; seed < 10000; seed++) {
+                bool used[TABLE_SIZE] = {};
+                bool collision = false;
+                for (size_t status = 1; status < STATUS_COUNT && !collision; status++) {
+                    size_t slot = slotOf(STATUS_NAMES[status], seed);
+                    collision = used[slot];
+                    used[slot] = true;
+                }
+                if (!collision) {
+                    return seed;
+                }
+            }
+            return NO_SEED;
+        }
+
+        constexpr uint32_t SEED = findSeed();
+        static_assert(SEED != NO_SEED, "No perfect hash seed for the task statuses in config.h");
+
+        // Slot to status; empty slots hold Unknown
+        constexpr array<TaskStatus, TABLE_SIZE> buildTable() {
+            array<TaskStatus, TABLE_SIZE> table{};
+            for (size_t status = 1; status < STATUS_COUNT; status++) {
+                table[slotOf(STATUS_NAMES[status], SEED)] = static_cast<TaskStatus>(status);
+            }
+            return table;
+        }
+
+        constexpr array<TaskStatus, TABLE_SIZE> STATUS_TABLE = buildTable();
+
+    } // namespace
+
+    // Definition of a function to intern a next task value; takes a string view as parameter; returns TaskStatus
+    TaskStatus parseTaskStatus(string_view nextTask) {
+        TaskStatus candidate = STATUS_TABLE[slotOf(nextTask, SEED)];
+        return STATUS_NAMES[static_cast<size_t>(candidate)] == nextTask ? candidate : TaskStatus::Unknown;
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Interned next task value; the order follows the TASK_* strings in config.h
+    enum class TaskStatus : uint8_t {
+        Unknown, // Any value not in config.h
+        SignedEngagementLetter,
+        SentOpenItemsExtension,
+        InformationEntered,
+        SentOpenItemsFinalPreparation,
+        FinalInformationEntered,
+        ReadyForManagerReview,
+        ManagerApproved,
+        PartnerReviewed,
+        CorrectionsCleared,
+        EFileSent,
+        EFileSigned,
+        TaxReturnFiled,
+        Billed,
+        Count
+    };
+
+    TaskStatus parseTaskStatus(string_view nextTask); // Code of a next task value; Unknown when it is not a known status
+
+    // Set of statuses as a bitmask
+    using TaskStatusMask = uint32_t;
+
+    constexpr TaskStatusMask taskStatusBit(TaskStatus status) { // Mask holding one status
+        return TaskStatusMask(1) << static_cast<unsigned>(status);
+    }
+
+    constexpr bool taskStatusIn(TaskStatus status, TaskStatusMask mask) { // Whether a status is in a set
+        return (taskStatusBit(status) & mask) != 0;
+    }
+
+    // Status sets shared by reports, filters and statistics
+    constexpr TaskStatusMask TASKS_FILED_MASK = // Return filed or further along
+            taskStatusBit(TaskStatus::CorrectionsCleared) | taskStatusBit(TaskStatus::EFileSent) |
+            taskStatusBit(TaskStatus::EFileSigned) | taskStatusBit(TaskStatus::TaxReturnFiled) |
+            taskStatusBit(TaskStatus::Billed);
+    constexpr TaskStatusMask TASKS_PARTNER_REVIEWED_MASK = // Reviewed by the partner or further along
+            TASKS_FILED_MASK | taskStatusBit(TaskStatus::PartnerReviewed);
+
+} // namespace TaxReturnSystem
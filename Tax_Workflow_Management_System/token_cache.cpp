@@ -0,0 +1,112 @@
+/**
+ * @file token_cache.cpp
+ * @brief Implementation of the verified-token cache
+ *
+ * This file contains implementations for:
+ * - Token digests and shard selection
+ * - Lock-free lookups of verified and revoked tokens
+ * - Copy-on-write inserts and revocations with expired-entry cleanup
+ *
+ * Tokens are keyed by their SHA-256 digest, so the cache never keeps a
+ * bearer token itself. Each shard publishes an immutable table through an
+ * atomic shared pointer: a lookup loads the current table and reads it
+ * without taking a lock, and a writer copies the table, drops the entries
+ * that have expired, applies its change and publishes the copy. Writes
+ * happen once per login or logout, reads on every authenticated request.
+ */
+
+#include "token_cache.h"
+#include <openssl/sha.h>
+#include <cstring>
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+// TOKEN CACHE CLASS METHODS:
+
+    // Definition of the digest hash; takes a digest as parameter; returns size_t
+    size_t TokenCache::DigestHash::operator()(const Digest& digest) const {
+        size_t hash;
+        memcpy(&hash, digest.data() + 1, sizeof(hash)); // Byte 0 already picked the shard
+        return hash;
+    }
+
+    // Definition of a method to hash a token; takes a token as parameter; returns Digest
+    TokenCache::Digest TokenCache::digestOf(const string& token) {
+        Digest digest;
+        SHA256(reinterpret_cast<const unsigned char*>(token.data()), token.size(), digest.data());
+        return digest;
+    }
+
+    // Definition of a method to look up a token; takes a token as parameter; returns Lookup
+    TokenCache::Lookup TokenCache::lookup(const string& token) const {
+        Digest digest = digestOf(token);
+        shared_ptr<const Table> table = atomic_load(&shardFor(digest).table);
+
+        Lookup result;
+        auto entry = table->find(digest);
+        if (entry == table->end() || chrono::system_clock::now() > entry->second.expiresAt) {
+            return result;
+        }
+
+        if (entry->second.revoked) {
+            result.state = State::Revoked;
+        } else {
+            result.state = State::Valid;
+            result.subject = entry->second.subject;
+            result.role = entry->second.role;
+        }
+        return result;
+    }
+
+    // Definition of a method to get the expiry of a cached valid token; takes a token as parameter; returns optional time point
+    optional<chrono::system_clock::time_point> TokenCache::getExpiry(const string& token) const {
+        Digest digest = digestOf(token);
+        shared_ptr<const Table> table = atomic_load(&shardFor(digest).table);
+
+        auto entry = table->find(digest);
+        if (entry == table->end() || entry->second.revoked) {
+            return nullopt;
+        }
+        return entry->second.expiresAt;
+    }
+
+    // Definition of a method to publish a shard table with one entry set; takes a digest and an entry as parameters; returns void
+    void TokenCache::store(const Digest& digest, Entry entry) {
+        Shard& shard = shardFor(digest);
+        lock_guard<mutex> lock(shard.writeMutex);
+
+        shared_ptr<const Table> current = atomic_load(&shard.table);
+        auto next = make_shared<Table>();
+        next->reserve(current->size() + 1);
+
+        // Expired entries are dropped while copying; a revoked one is kept until its token could no longer validate anyway
+        auto now = chrono::system_clock::now();
+        for (const auto& [key, value] : *current) {
+            if (value.expiresAt >= now) {
+                next->emplace(key, value);
+            }
+        }
+
+        // A revocation always wins over a verified entry for the same token
+        auto existing = next->find(digest);
+        if (existing != next->end() && existing->second.revoked && !entry.revoked) {
+            return;
+        }
+        (*next)[digest] = move(entry);
+
+        atomic_store(&shard.table, shared_ptr<const Table>(move(next)));
+    }
+
+    // Definition of a method to cache a verified token; takes a token, its subject, role and expiry as parameters; returns void
+    void TokenCache::insertVerified(const string& token, const string& subject, UserRole role, chrono::system_clock::time_point expiresAt) {
+        store(digestOf(token), Entry{subject, role, expiresAt, false});
+    }
+
+    // Definition of a method to revoke a token; takes a token and the latest time it could expire as parameters; returns void
+    void TokenCache::revoke(const string& token, chrono::system_clock::time_point expiresAt) {
+        store(digestOf(token), Entry{string(), UserRole::Manager, expiresAt, true});
+    }
+
+} // namespace TaxReturnSystem
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include "user.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Concurrent cache of verified and revoked JWTs, keyed by the SHA-256 digest of the token
+    class TokenCache {
+    public:
+        using Digest = array<uint8_t, 32>; // SHA-256 of a token
+
+        // Result of a lookup
+        enum class State : uint8_t {
+            Miss, // Not cached, or cached but expired; the caller has to verify the token
+            Valid, // Verified before and not expired
+            Revoked // Invalidated before it expired
+        };
+
+        // What a lookup found
+        struct Lookup {
+            State state = State::Miss;
+            string subject; // Token subject, set for Valid
+            UserRole role = UserRole::Manager; // Token role claim, set for Valid
+        };
+
+    private:
+        // One cached token
+        struct Entry {
+            string subject; // Token subject
+            UserRole role = UserRole::Manager; // Token role claim
+            chrono::system_clock::time_point expiresAt; // Token expiry; the entry is ignored after it
+            bool revoked = false; // Whether the token was invalidated
+        };
+
+        // Hash of a digest; the digest is already uniformly distributed, so its first bytes are used as is
+        struct DigestHash {
+            size_t operator()(const Digest& digest) const;
+        };
+
+        using Table = unordered_map<Digest, Entry, DigestHash>;
+
+        // One shard; readers load the table without locking, writers copy it under the mutex and publish the copy
+        struct Shard {
+            mutex writeMutex; // Serializes writers of this shard
+            shared_ptr<const Table> table = make_shared<const Table>(); // Current table; accessed atomically
+        };
+
+        static constexpr size_t SHARD_COUNT = 16; // Power of two
+        array<Shard, SHARD_COUNT> shards; // Shards by digest
+
+        Shard& shardFor(const Digest& digest) { return shards[digest[0] & (SHARD_COUNT - 1)]; } // Shard holding a digest
+        const Shard& shardFor(const Digest& digest) const { return shards[digest[0] & (SHARD_COUNT - 1)]; }
+        void store(const Digest& digest, Entry entry); // Publish a copy of a shard's table with one entry set
+
+    public:
+        static Digest digestOf(const string& token); // SHA-256 of a token
+
+        Lookup lookup(const string& token) const; // Look up a token without locking
+        void insertVerified(const string& token, const string& subject, UserRole role, chrono::system_clock::time_point expiresAt); // Cache a verified token
+        void revoke(const string& token, chrono::system_clock::time_point expiresAt); // Reject a token until it expires
+        optional<chrono::system_clock::time_point> getExpiry(const string& token) const; // Expiry of a cached valid token
+    };
+
+} // namespace TaxReturnSystem
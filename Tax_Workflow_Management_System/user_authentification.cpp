@@ -17,8 +17,8 @@ namespace TaxReturnSystem {
 
     // AUTH CLASS METHODS:
 
-    // Definition of method to generate a JWT token for a given username; takes username as parameter, returns token
-    string Auth::generateToken(const string& username) const {
+    // Definition of method to generate a JWT token for a given username; takes username and role as parameters, returns token
+    string Auth::generateToken(const string& username, UserRole role) const {
         if (secretKey.empty()) { // If the key is empty, log the error and return an empty string
             logger.log("JWT secret key is empty");
             cerr << "JWT secret key is empty!" << endl;
@@ -28,6 +28,7 @@ namespace TaxReturnSystem {
         auto token = jwt::create() // Create a new JWT token
                 .set_issuer(JWT_ISSUER) // Set the issuer of the token
                 .set_subject(username) // Set the subject (username) of the token
+                .set_payload_claim("role", jwt::claim(to_string(static_cast<int>(role)))) // Set the role, stored as in the users table
                 .set_expires_at(chrono::system_clock::now() + chrono::seconds(TOKEN_EXPIRY)) // Set the token to expire
                 .sign(jwt::algorithm::hs256{secretKey}); // Sign the token using the stored secret key
         logger.log("Token generated for user: " + username);
@@ -45,14 +46,14 @@ namespace TaxReturnSystem {
         return token;
     }
 
-    // Definition of method to hash a password using bcrypt; takes password as parameter, returns hashed password
+    // Definition of method to hash a password using bcrypt on the hashing pool; takes password as parameter, returns hashed password
     string Auth::hashPassword(const string& password) {
-        return BCrypt::generateHash(password); // Hash the provided password with bcrypt
+        return runOnHashingPool<string>([&password]() { return BCrypt::generateHash(password); }); // Hash the provided password with bcrypt
     }
 
-    // Definition of method to verify a password against a stored hash using BCrypt; takes plain text password and hash as parameters, returns true if password matches hash, false otherwise
+    // Definition of method to verify a password against a stored hash using BCrypt on the hashing pool; takes plain text password and hash as parameters, returns true if password matches hash, false otherwise
     bool Auth :: verifyPassword(const string& password, const string& hash) const {
-        return BCrypt::validatePassword(password, hash);
+        return runOnHashingPool<bool>([&password, &hash]() { return BCrypt::validatePassword(password, hash); });
     }
 
     //TODO: resolve the email issues
@@ -66,9 +67,9 @@ namespace TaxReturnSystem {
 
         bool result = emailService.sendEmail(email, subject, body);
         if (result) {
-            logger.log("Password reset email sent to: " + email);
+            logger.log("Password reset email queued for: " + email);
         } else {
-            logger.log("Failed to send password reset email to: " + email);
+            logger.log("Failed to queue password reset email for: " + email);
         }
         return result;
     }
@@ -158,39 +159,33 @@ namespace TaxReturnSystem {
         return chrono::system_clock::now() - it->second > chrono::seconds(USERNAME_RECOVERY_COOLDOWN);
     }
 
-    // Definition of method to check if a user account is locked; takes username as parameter, returns true if the account is locked, false otherwise
-    bool Auth::isAccountLocked(const string& username) const {
-        // Check if the loginAttempts map contains the entry for the specified username
-        auto iter = loginAttempts.find(username);
-        if (iter != loginAttempts.end()) { // If an entry for the given username was found
-            if (iter->second.lockoutUntil > chrono::system_clock::now()) { // If the current time is less than the lockoutUntil time, the user is locked out
-                return true;
-            }
-        }
-        return false;
+    // Definition of method to get the stripe holding a user's login attempts; takes username as parameter, returns the stripe
+    Auth::LoginStripe& Auth::stripeFor(const string& username) {
+        return loginStripes[hash<string>()(username) & (LOGIN_STRIPES - 1)];
     }
 
-    // Definition of method to reset login attempts for a user; takes username as parameter
-    void Auth::resetLoginAttempts(const string& username) {
-        loginAttempts.erase(username);
+    // Definition of method to check if a user account is locked; takes the user's login attempts as parameter, returns true if the account is locked, false otherwise
+    bool Auth::isAccountLocked(const LoginAttempt& attempt) const {
+        // If the current time is less than the lockoutUntil time, the user is locked out
+        return attempt.lockoutUntil > chrono::system_clock::now();
     }
 
-    // Definition of method to increment login attempts for a user; takes username as parameter, increments the attempt count, and locks the account if maximum attempts are reached; returns void
-    void Auth::incrementLoginAttempts(const string& username) {
-        auto& attempts = loginAttempts[username];
-        attempts.attempts++; // Increase the number of attempts for this user
-        cout << "Incrementing failed attempts. New count: " << attempts.attempts << endl;
-        if (attempts.attempts >= MAX_LOGIN_ATTEMPTS) { // If the number of attempts is greater than or equal to the maximum allowed attempts
+    // Definition of method to increment login attempts for a user; takes username and its login attempts as parameters, increments the attempt count, and locks the account if maximum attempts are reached; returns void
+    void Auth::incrementLoginAttempts(const string& username, LoginAttempt& attempt) {
+        attempt.attempts++; // Increase the number of attempts for this user
+        cout << "Incrementing failed attempts. New count: " << attempt.attempts << endl;
+        if (attempt.attempts >= MAX_LOGIN_ATTEMPTS) { // If the number of attempts is greater than or equal to the maximum allowed attempts
             // Lockout the user by setting the lockoutUntil time to the current time plus the lockout duration
-            attempts.lockoutUntil = chrono::system_clock::now() + chrono::seconds(LOCKOUT_DURATION);
+            attempt.lockoutUntil = chrono::system_clock::now() + chrono::seconds(LOCKOUT_DURATION);
             logger.log("User locked out due to multiple failed attempts: " + username);
-            cout << "User locked out. Lockout until: " << attempts.lockoutUntil.time_since_epoch().count() << endl;
+            cout << "User locked out. Lockout until: " << attempt.lockoutUntil.time_since_epoch().count() << endl;
         }
     }
 
     // Constructor
     Auth::Auth(EmailService& emailService, UserDatabase& userDatabase, Logger& logger, const string& jwtSecretKey)
-            : emailService(emailService), userDatabase(userDatabase), logger(logger), secretKey(jwtSecretKey) {
+            : emailService(emailService), userDatabase(userDatabase), logger(logger), secretKey(jwtSecretKey),
+              hashingPool(PASSWORD_HASHING_THREADS) {
 
         if (secretKey.empty()) {
             string errorMsg = "JWT secret key is empty!";
@@ -235,8 +230,6 @@ namespace TaxReturnSystem {
 
     // Definition of method to log in a user; takes username and password as parameters, returns token if successful, empty string otherwise
     LoginResult Auth::loginUser(const string& username, const string& password) {
-        lock_guard<mutex> lock(loginMutex);
-
         cout << "Login attempt for user: " << username << endl;
         logger.log("Login attempt for user: " + username);
 
@@ -252,59 +245,80 @@ namespace TaxReturnSystem {
             return LoginResult::InvalidPasswordLength;
         }
 
-        if (isAccountLocked(username)) {
-            logger.log("Login attempt rejected: User locked out - " + username);
-            cerr << "User is currently locked out." << endl;
-            return LoginResult::AccountLocked;
+        // Only one login per username checks its password at a time, so a burst of guesses cannot
+        // run past the lockout; logins of other users only share the stripe lock for these few lines
+        LoginStripe& stripe = stripeFor(username);
+        {
+            unique_lock<mutex> lock(stripe.stripeMutex);
+            stripe.verified.wait(lock, [&]() {
+                auto attempt = stripe.attempts.find(username);
+                return attempt == stripe.attempts.end() || !attempt->second.verifying;
+            });
+
+            LoginAttempt& attempt = stripe.attempts[username];
+            if (isAccountLocked(attempt)) {
+                logger.log("Login attempt rejected: User locked out - " + username);
+                cerr << "User is currently locked out." << endl;
+                return LoginResult::AccountLocked;
+            }
+            attempt.verifying = true;
         }
 
-        User user;
-        string hashedPassword;
-        bool userExists = userDatabase.getUserFromDatabase(username, user, hashedPassword);
+        // Look up the user and check the password without holding the stripe lock
+        bool passwordCorrect = false;
+        try {
+            User user;
+            string hashedPassword;
+            bool userExists = userDatabase.getUserFromDatabase(username, user, hashedPassword);
 
-        bool passwordCorrect = userExists && verifyPassword(password, hashedPassword);
+            passwordCorrect = userExists && verifyPassword(password, hashedPassword);
+        } catch (...) {
+            {
+                lock_guard<mutex> lock(stripe.stripeMutex);
+                stripe.attempts[username].verifying = false;
+            }
+            stripe.verified.notify_all();
+            throw;
+        }
+
+        // Record the outcome and let the next login of this user proceed
+        {
+            lock_guard<mutex> lock(stripe.stripeMutex);
+            LoginAttempt& attempt = stripe.attempts[username];
+            attempt.verifying = false;
+            if (passwordCorrect) {
+                stripe.attempts.erase(username);
+            } else {
+                incrementLoginAttempts(username, attempt);
+            }
+        }
+        stripe.verified.notify_all();
 
         if (passwordCorrect) {
-            resetLoginAttempts(username);
             logger.log("Successful login: " + username);
             cout << "Login successful." << endl;
             return LoginResult::Success;
         } else {
-            incrementLoginAttempts(username);
             logger.log("Failed login attempt: " + username);
             cout << "Login failed." << endl;
             return LoginResult::InvalidCredentials;
         }
     }
 
-    // Definition of method to validate JWT token; takes token as parameter, returns true if valid, false otherwise
-    bool Auth::validateToken(const string& token) const {
+    // Definition of method to decode and verify a JWT token; takes token as parameter, returns its claims if the token is valid, nullopt otherwise
+    optional<Auth::VerifiedToken> Auth::verifyToken(const string& token) const {
         try {
-            if (invalidatedTokens.find(token) != invalidatedTokens.end()) {
-                return false;
-            }
-            cout << "Validating token: " << token.substr(0, 10) << "..." << endl; // Log first 10 chars for security
             auto decoded = jwt::decode(token);
 
-            cout << "Token decoded successfully" << endl;
-
-            // Print issuer and subject claims
-            cout << "Issuer: " << decoded.get_issuer() << endl;
-            cout << "Subject: " << decoded.get_subject() << endl;
-
             // Check expiration
-            if (decoded.has_expires_at()) {
-                cout << "Token has expiration claim" << endl;
-                auto exp = decoded.get_expires_at();
-                if (chrono::system_clock::now() > exp) {
-                    cout << "Token has expired" << endl;
-                    logger.log("Token validation failed: Token expired");
-                    return false;
-                }
-            } else {
-                cout << "Token does not have expiration claim" << endl;
+            if (!decoded.has_expires_at()) {
                 logger.log("Token validation failed: No expiration claim");
-                return false;
+                return nullopt;
+            }
+            auto exp = decoded.get_expires_at();
+            if (chrono::system_clock::now() > exp) {
+                logger.log("Token validation failed: Token expired");
+                return nullopt;
             }
 
             // Verify signature
@@ -313,15 +327,56 @@ namespace TaxReturnSystem {
                     .with_issuer(JWT_ISSUER);
 
             verifier.verify(decoded);
-            cout << "Token signature verified successfully" << endl;
 
-            logger.log("Token validated successfully");
-            return true;
+            // Check role
+            if (!decoded.has_payload_claim("role")) {
+                logger.log("Token validation failed: No role claim");
+                return nullopt;
+            }
+            int role = stoi(decoded.get_payload_claim("role").as_string());
+            if (role < static_cast<int>(UserRole::Admin) || role > static_cast<int>(UserRole::Manager)) {
+                logger.log("Token validation failed: Unknown role");
+                return nullopt;
+            }
+
+            return VerifiedToken{decoded.get_subject(), static_cast<UserRole>(role), exp};
         } catch (const exception& e) {
             cerr << "Error validating token: " << e.what() << endl;
             logger.log("Token validation failed: " + string(e.what()));
+            return nullopt;
+        }
+    }
+
+    // Definition of method to validate JWT token; takes token as parameter, returns true if valid, false otherwise
+    bool Auth::validateToken(const string& token) const {
+        // Tokens seen before are answered from the cache without decoding or logging
+        TokenCache::Lookup cached = tokenCache.lookup(token);
+        if (cached.state != TokenCache::State::Miss) {
+            return cached.state == TokenCache::State::Valid;
+        }
+
+        auto verified = verifyToken(token);
+        if (!verified) {
             return false;
         }
+
+        tokenCache.insertVerified(token, verified->subject, verified->role, verified->expiresAt);
+        logger.log("Token validated successfully for user: " + verified->subject);
+        return true;
+    }
+
+    // Definition of method to invalidate a JWT token; takes token as parameter; returns void
+    void Auth::invalidateToken(const string& token) {
+        // Only tokens that could still validate need remembering, and only until they expire
+        optional<chrono::system_clock::time_point> expiresAt = tokenCache.getExpiry(token);
+        if (!expiresAt) {
+            if (auto verified = verifyToken(token)) {
+                expiresAt = verified->expiresAt;
+            }
+        }
+        if (expiresAt) {
+            tokenCache.revoke(token, *expiresAt);
+        }
     }
 
     // Definition of method to request a password reset; takes username as parameter, returns true if reset request was successful, false otherwise
@@ -429,51 +484,63 @@ namespace TaxReturnSystem {
 
         bool result = emailService.sendEmail(email, subject, body);
         if (result) {
-            logger.log("Username recovery email sent to: " + email + " for username: " + username);
+            logger.log("Username recovery email queued for: " + email + " for username: " + username);
         } else {
-            logger.log("Failed to send username recovery email to: " + email);
+            logger.log("Failed to queue username recovery email for: " + email);
         }
 
         lastUsernameRecovery[email] = chrono::system_clock::now();
         return result;
     }
 
+    // Definition of a method to create a token for a user, carrying their current role; takes username as parameter; returns token, or an empty string if the user is unknown
+    string Auth::createTokenForUser(const string& username) {
+        User user;
+        string hashedPassword;
+        if (!userDatabase.getUserFromDatabase(username, user, hashedPassword)) {
+            logger.log("Token not generated, user not found: " + username);
+            return "";
+        }
+        return generateToken(username, user.getRole());
+    }
+
+    // Definition of a method to get the role claim of a token; takes token as parameter; returns the role, or nullopt if the token is not valid
+    optional<UserRole> Auth::getRoleFromToken(const string& token) const {
+        // Answered from the cache entry validation leaves behind, without a database lookup
+        TokenCache::Lookup cached = tokenCache.lookup(token);
+        if (cached.state == TokenCache::State::Miss && validateToken(token)) {
+            cached = tokenCache.lookup(token);
+        }
+        if (cached.state != TokenCache::State::Valid) {
+            return nullopt;
+        }
+        return cached.role;
+    }
+
     // Definition of a method to retrieve a user from a token; takes token as parameter; returns User object
     User Auth::getUserFromToken(const string& token) const {
         try {
-            // Log token retrieval attempt (first 10 chars for security)
-            cout << "Getting user from token: " << token.substr(0, 10) << "..." << endl;
-
-            // Validate the token
-            if (!validateToken(token)) {
+            // Validate the token; the subject comes from the cache entry validation leaves behind
+            TokenCache::Lookup cached = tokenCache.lookup(token);
+            if (cached.state == TokenCache::State::Miss && validateToken(token)) {
+                cached = tokenCache.lookup(token);
+            }
+            if (cached.state != TokenCache::State::Valid) {
                 throw runtime_error("Invalid token");
             }
 
-            // Decode the token
-            auto decoded = jwt::decode(token);
-            cout << "Token decoded successfully" << endl;
-
-            // Log issuer and subject claims
-            cout << "Issuer: " << decoded.get_issuer() << endl;
-            cout << "Subject: " << decoded.get_subject() << endl;
-
             // Extract username from token
-            string username = decoded.get_subject();
+            const string& username = cached.subject;
             if (username.empty()) {
                 throw runtime_error("Token is missing 'sub' claim");
             }
-            cout << "Username extracted from token: " << username << endl;
 
-            // Retrieve user from database
+            // Retrieve user from the user database's cache, which every user update invalidates, rather than caching it with the token
             User user;
             string hashedPassword;
             if (!userDatabase.getUserFromDatabase(username, user, hashedPassword)) {
                 throw runtime_error("User not found in database");
             }
-            cout << "User found in database" << endl;
-
-            // Log successful retrieval
-            logger.log("User retrieved from token successfully: " + username);
             return user;
         } catch (const exception& e) {
             // Log and rethrow exceptions
@@ -12,6 +12,9 @@
 #include <cstdlib>
 #include <optional>
 #include <random>
+#include <array>
+#include <future>
+#include <condition_variable>
 #include <openssl/sha.h>
 #include <sqlite3.h>
 #include <bcrypt/BCrypt.hpp>
@@ -21,6 +24,8 @@
 #include "email_service.h"
 #include "user_database.h"
 #include "user.h"
+#include "token_cache.h"
+#include "task_executor.h"
 
 using namespace std;
 
@@ -28,8 +33,9 @@ namespace TaxReturnSystem {
 
     // Structure to hold user login attempts
     struct LoginAttempt {
-        int attempts; // Number of login attempts
+        int attempts = 0; // Number of login attempts
         chrono::system_clock::time_point lockoutUntil; // Time until the user is locked out
+        bool verifying = false; // Whether a login for the user is checking its password
     };
 
     enum class LoginResult { Success, InvalidUsername, InvalidPasswordLength, AccountLocked, InvalidCredentials };
@@ -42,22 +48,40 @@ namespace TaxReturnSystem {
         UserDatabase& userDatabase; // Reference to user database
         Logger& logger; // Reference to logger
 
+        // Login attempts, striped by username so logins of different users never share a lock
+        struct LoginStripe {
+            mutex stripeMutex; // Guards attempts
+            condition_variable verified; // Signals that a user's password check finished
+            unordered_map<string, LoginAttempt> attempts; // Login attempts of the usernames hashed to this stripe
+        };
+        static constexpr size_t LOGIN_STRIPES = 64; // Power of two
+
         // Authentication-related data
         string secretKey; // JWT secret key
-        mutex loginMutex; // Mutex for thread safety
+        array<LoginStripe, LOGIN_STRIPES> loginStripes; // Track login attempts per user
+        mutable TaskExecutor hashingPool; // Runs bcrypt off the request threads, bounded to PASSWORD_HASHING_THREADS
 
         // Data structures for tracking user activities
-        unordered_map<string, LoginAttempt> loginAttempts; // Track login attempts per user
         unordered_map<string, pair<string, chrono::system_clock::time_point>> resetTokens; // Map of reset tokens
         unordered_map<string, vector<chrono::system_clock::time_point>> resetAttempts; // Track reset attempts
         unordered_map<string, chrono::system_clock::time_point> lastPasswordChange; // Track last password change
         unordered_map<string, chrono::system_clock::time_point> lastUsernameRecovery; // Track last username recovery
 
         // Token generation and management
-        string generateToken(const string& username) const; // Generate JWT token
+        // Claims of a token that passed verification
+        struct VerifiedToken {
+            string subject; // Username
+            UserRole role; // Role claim
+            chrono::system_clock::time_point expiresAt; // Expiry claim
+        };
+
+        string generateToken(const string& username, UserRole role) const; // Generate JWT token
         string generateResetToken() const; // Generate reset token
+        optional<VerifiedToken> verifyToken(const string& token) const; // Decode and verify a JWT; returns its claims
 
         // Password-related methods
+        template <typename Result, typename Work>
+        Result runOnHashingPool(Work work) const; // Run work on the hashing pool and wait for its result
         string hashPassword(const string& password); // Hash a password
         bool verifyPassword(const string& password, const string& hash) const; // Verify password against hash
         bool sendResetEmail(const string& email, const string& token) const; // Send password reset email
@@ -72,11 +96,11 @@ namespace TaxReturnSystem {
         void recordResetAttempt(const string& username); // Record a reset attempt
         bool canChangePassword(const string& username) const; // Check if password can be changed
         bool canRecoverUsername(const string& email) const; // Check if username can be recovered
-        bool isAccountLocked(const string& username) const; // Check if account is locked
-        void resetLoginAttempts(const string& username); // Reset login attempts
-        void incrementLoginAttempts(const string& username); // Increment login attempts
+        LoginStripe& stripeFor(const string& username); // Stripe holding a user's login attempts
+        bool isAccountLocked(const LoginAttempt& attempt) const; // Check if account is locked
+        void incrementLoginAttempts(const string& username, LoginAttempt& attempt); // Increment login attempts; caller holds the stripe lock
 
-        unordered_set<string> invalidatedTokens; // Set of invalidated tokens
+        mutable TokenCache tokenCache; // Verified and invalidated tokens, so repeat requests skip decoding and signature checks
 
     public:
         // Constructor and Destructor
@@ -87,8 +111,9 @@ namespace TaxReturnSystem {
         bool registerUser(const string& username, const string& password, const string& email); // Register a new user
         LoginResult loginUser(const string& username, const string& password); // Log in a user
         bool validateToken(const string& token) const; // Validate a JWT token
-        void invalidateToken(const string& token) { invalidatedTokens.insert(token); } // Invalidate a token
+        void invalidateToken(const string& token); // Invalidate a token
         User getUserFromToken(const string& token) const; // Get user from token
+        optional<UserRole> getRoleFromToken(const string& token) const; // Get the role claim of a valid token
 
         // Password management methods
         bool requestPasswordReset(const string& username); // Request password reset
@@ -99,7 +124,16 @@ namespace TaxReturnSystem {
         // Account recovery methods
         bool recoverUsername(const string& email); // Recover username
 
-        string createTokenForUser(const string& username) { return generateToken(username); } // Create token for user
+        string createTokenForUser(const string& username); // Create token for user
     };
 
+    // Definition of a method to run work on the hashing pool; takes the work as parameter; returns its result
+    template <typename Result, typename Work>
+    Result Auth::runOnHashingPool(Work work) const {
+        auto task = make_shared<packaged_task<Result()>>(move(work));
+        future<Result> result = task->get_future();
+        hashingPool.submit([task]() { (*task)(); });
+        return result.get();
+    }
+
 } // namespace TaxReturnSystem
\ No newline at end of file
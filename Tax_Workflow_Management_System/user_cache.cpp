@@ -0,0 +1,112 @@
+/**
+ * @file user_cache.cpp
+ * @brief Implementation of the in-memory user record cache
+ *
+ * This file contains implementations for:
+ * - Lookups by username and by email
+ * - Least-recently-used eviction
+ * - Invalidation after user updates
+ *
+ * UserDatabase reads through this cache and invalidates it after every
+ * write. A load reads the generation before querying SQLite and the insert
+ * is dropped if any invalidation happened in between, so a row read just
+ * before an update can never be cached after that update.
+ */
+
+#include "user_cache.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+// USER CACHE CLASS METHODS:
+
+    // Definition of the constructor; takes the capacity as parameter; returns nothing
+    UserCache::UserCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    // Definition of a method to find a user by username; takes a username as parameter; returns optional Entry
+    optional<UserCache::Entry> UserCache::findByUsername(const string& username) const {
+        lock_guard<mutex> lock(cacheMutex);
+        auto found = byUsername.find(username);
+        if (found == byUsername.end()) {
+            return nullopt;
+        }
+        recency.splice(recency.begin(), recency, found->second);
+        return *found->second;
+    }
+
+    // Definition of a method to find a user by email; takes an email as parameter; returns optional Entry
+    optional<UserCache::Entry> UserCache::findByEmail(const string& email) const {
+        lock_guard<mutex> lock(cacheMutex);
+        auto username = usernameByEmail.find(email);
+        if (username == usernameByEmail.end()) {
+            return nullopt;
+        }
+        auto found = byUsername.find(username->second);
+        recency.splice(recency.begin(), recency, found->second);
+        return *found->second;
+    }
+
+    // Definition of a method to get the invalidation generation; takes no parameters; returns uint64_t
+    uint64_t UserCache::getGeneration() const {
+        lock_guard<mutex> lock(cacheMutex);
+        return generation;
+    }
+
+    // Definition of a method to cache a loaded user; takes the entry and the generation read before loading it; returns void
+    void UserCache::insert(Entry entry, uint64_t loadedAtGeneration) {
+        lock_guard<mutex> lock(cacheMutex);
+        if (loadedAtGeneration != generation) {
+            return;
+        }
+
+        string username = entry.user.getUsername();
+        auto existing = byUsername.find(username);
+        if (existing != byUsername.end()) {
+            eraseLocked(existing->second);
+        }
+
+        // Emails are not unique in the users table; the index follows the last user loaded for one
+        string email = entry.user.getEmail();
+        auto previousOwner = usernameByEmail.find(email);
+        if (previousOwner != usernameByEmail.end()) {
+            eraseLocked(byUsername.at(previousOwner->second));
+        }
+
+        recency.push_front(move(entry));
+        byUsername.emplace(username, recency.begin());
+        usernameByEmail.emplace(move(email), move(username));
+
+        if (recency.size() > capacity) {
+            eraseLocked(prev(recency.end()));
+        }
+    }
+
+    // Definition of a method to drop a user; takes a username as parameter; returns void
+    void UserCache::invalidate(const string& username) {
+        lock_guard<mutex> lock(cacheMutex);
+        generation++;
+        auto found = byUsername.find(username);
+        if (found != byUsername.end()) {
+            eraseLocked(found->second);
+        }
+    }
+
+    // Definition of a method to drop the user an email maps to; takes an email as parameter; returns void
+    void UserCache::invalidateEmail(const string& email) {
+        lock_guard<mutex> lock(cacheMutex);
+        generation++;
+        auto username = usernameByEmail.find(email);
+        if (username != usernameByEmail.end()) {
+            eraseLocked(byUsername.at(username->second));
+        }
+    }
+
+    // Definition of a method to remove an entry and its indexes; takes the entry as parameter; returns void
+    void UserCache::eraseLocked(RecencyList::iterator entry) {
+        usernameByEmail.erase(entry->user.getEmail());
+        byUsername.erase(entry->user.getUsername());
+        recency.erase(entry);
+    }
+
+} // namespace TaxReturnSystem
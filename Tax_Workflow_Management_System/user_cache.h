@@ -0,0 +1,48 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include "config.h"
+#include "user.h"
+
+using namespace std;
+
+namespace TaxReturnSystem {
+
+    // Bounded least-recently-used cache of user records, keyed by username with an index by email
+    class UserCache {
+    public:
+        // One cached users row
+        struct Entry {
+            User user; // Username, email, role and last password change
+            string hashedPassword; // Stored password hash, needed by logins
+        };
+
+    private:
+        using RecencyList = list<Entry>; // Most recently used first
+
+        size_t capacity; // Most users kept
+        mutable mutex cacheMutex; // Guards every member below
+        mutable RecencyList recency; // Cached entries; lookups move theirs to the front
+        unordered_map<string, RecencyList::iterator> byUsername; // Username to entry
+        unordered_map<string, string> usernameByEmail; // Email of a cached entry to its username
+        uint64_t generation = 0; // Bumped by every invalidation, so loads that raced one are not cached
+
+        void eraseLocked(RecencyList::iterator entry); // Remove an entry and its email index; caller holds cacheMutex
+
+    public:
+        explicit UserCache(size_t capacity = USER_CACHE_CAPACITY); // Constructor
+
+        optional<Entry> findByUsername(const string& username) const; // Cached entry for a username
+        optional<Entry> findByEmail(const string& email) const; // Cached entry for an email
+        uint64_t getGeneration() const; // Read before loading a row from the database and pass to insert
+        void insert(Entry entry, uint64_t loadedAtGeneration); // Cache a loaded row unless an invalidation happened since
+        void invalidate(const string& username); // Drop a user after it changed
+        void invalidateEmail(const string& email); // Drop whichever user an email maps to
+    };
+
+} // namespace TaxReturnSystem
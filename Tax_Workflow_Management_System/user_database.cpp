@@ -7,6 +7,12 @@
  * - User CRUD operations
  * - Password and role management
  * - Email management
+ *
+ * Every query runs as a statement cached on the connection that executes
+ * it, so SQL is compiled once per connection. Lookups go through a bounded
+ * cache of users first; the update methods invalidate the user they
+ * changed after the write, so authenticated requests read profile data
+ * from memory while changes are visible immediately.
  */
 
 #include "user_database.h"
@@ -16,15 +22,10 @@ using namespace std;
 namespace TaxReturnSystem {
 
     // Definition of UserDatabase constructor; takes database path as parameter; initializes database connection
-    UserDatabase::UserDatabase(const string& path) : dbPath(path), db(nullptr) {
+    UserDatabase::UserDatabase(const string& path) : dbPath(path), pool(path) {
         // Log constructor start
         cout << "UserDatabase constructor called with path: " << path << endl;
 
-        // Open database connection
-        if (!openDatabase()) {
-            throw runtime_error("Failed to open database");
-        }
-
         // Create necessary tables
         cout << "Database opened successfully. Attempting to create tables..." << endl;
         createTablesIfNotExist();
@@ -33,37 +34,8 @@ namespace TaxReturnSystem {
         cout << "UserDatabase constructor completed successfully." << endl;
     }
 
-    // Destructor; closes the database connection
-    UserDatabase::~UserDatabase() {
-        closeDatabase();
-    }
-
-    // Definition of a method to open the database connection; returns bool indicating success
-    bool UserDatabase::openDatabase() {
-        // Log attempt to open database
-        cout << "Attempting to open database at: " << dbPath << endl;
-
-        // Open the database connection
-        int result = sqlite3_open(dbPath.c_str(), &db);
-        if (result != SQLITE_OK) {
-            // Log error if opening fails
-            cerr << "Failed to open database: " << sqlite3_errmsg(db) << endl;
-            return false;
-        }
-
-        // Log success
-        cout << "Database opened successfully." << endl;
-        return true;
-    }
-
-    // Definition of a method to close the database connection; no parameters or return value
-    void UserDatabase::closeDatabase() {
-        // Close database if connection exists
-        if (db) {
-            sqlite3_close(db);
-            db = nullptr;
-        }
-    }
+    // Destructor; the pool closes the connections
+    UserDatabase::~UserDatabase() = default;
 
     // Definition of a method to create database tables if they don't exist; no parameters or return value
     void UserDatabase::createTablesIfNotExist() {
@@ -80,12 +52,14 @@ namespace TaxReturnSystem {
             user_role INTEGER NOT NULL,
             last_password_change INTEGER NOT NULL
         );
+        CREATE INDEX IF NOT EXISTS idx_users_email ON users(email);
     )";
 
         // Execute SQL statement
+        WriteLease writer = pool.writer();
         char* errMsg = nullptr;
         cout << "Executing SQL to create users table..." << endl;
-        int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
+        int rc = sqlite3_exec(writer->handle(), sql, nullptr, nullptr, &errMsg);
 
         // Handle any SQL errors
         if (rc != SQLITE_OK) {
@@ -99,18 +73,57 @@ namespace TaxReturnSystem {
         cout << "Users table created successfully." << endl;
     }
 
+    // Definition of a method to load one user and cache it; takes a query selecting by one key and the key; returns the user if found
+    optional<UserCache::Entry> UserDatabase::loadUser(const char* sql, const string& key) {
+        // Read the generation first so a load that races an update is not cached
+        uint64_t generation = cache.getGeneration();
+
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare(sql);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
+            return nullopt;
+        }
+
+        sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            return nullopt;
+        }
+
+        // Populate user object with database values, treating NULL text as empty
+        auto textColumn = [stmt](int index) {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, index));
+            return string(text ? text : "");
+        };
+
+        UserCache::Entry entry;
+        entry.user.setUsername(textColumn(0));
+        entry.hashedPassword = textColumn(1);
+        entry.user.setEmail(textColumn(2));
+        entry.user.setRole(static_cast<UserRole>(sqlite3_column_int(stmt, 3)));
+        entry.user.setLastPasswordChange(chrono::system_clock::from_time_t(sqlite3_column_int64(stmt, 4)));
+
+        cache.insert(entry, generation);
+        return entry;
+    }
+
+    // Definition of a method to get a user from the cache, loading it on a miss; takes username as parameter; returns the user if found
+    optional<UserCache::Entry> UserDatabase::findUser(const string& username) {
+        if (optional<UserCache::Entry> cached = cache.findByUsername(username)) {
+            return cached;
+        }
+        return loadUser("SELECT username, passwordHash, email, user_role, last_password_change FROM users WHERE username = ?;", username);
+    }
+
     // Definition of a method to add a new user to the database; takes username, passwordHash, and email as parameters; returns bool indicating success
     bool UserDatabase::addUserToDatabase(const string& username, const string& passwordHash, const string& email) {
         // Log attempt to add user
         cout << "Attempting to add user: " << username << endl;
 
-        // SQL statement to insert a new user
-        string sql = "INSERT INTO users (username, passwordHash, email, user_role, last_password_change) VALUES (?, ?, ?, ?, ?);";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("INSERT INTO users (username, passwordHash, email, user_role, last_password_change) VALUES (?, ?, ?, ?, ?);");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
@@ -127,14 +140,17 @@ namespace TaxReturnSystem {
 
         // Execute SQL statement
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
 
         // Check execution result
         if (result != SQLITE_DONE) {
-            cerr << "Failed to add user: " << sqlite3_errmsg(db) << endl;
+            cerr << "Failed to add user: " << writer->errorMessage() << endl;
             return false;
         }
 
+        // The email may now belong to more than one user; let the next lookup by email ask the database
+        cache.invalidateEmail(email);
+
         // Log success
         cout << "User added successfully." << endl;
         return true;
@@ -142,128 +158,76 @@ namespace TaxReturnSystem {
 
     // Definition of a method to retrieve a user from the database; takes username and output parameters for user and hashedPassword; returns bool indicating success
     bool UserDatabase::getUserFromDatabase(const string& username, User& user, string& hashedPassword) {
-        // SQL statement to select user data
-        string sql = "SELECT username, passwordHash, email, user_role, last_password_change FROM users WHERE username = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        optional<UserCache::Entry> entry = findUser(username);
+        if (!entry) {
             return false;
         }
-
-        // Bind username parameter
-        sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-
-        // Execute and retrieve user data if found
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            // Populate user object with database values
-            user.setUsername(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
-            hashedPassword = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-            user.setEmail(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
-            user.setRole(static_cast<UserRole>(sqlite3_column_int(stmt, 3)));
-            user.setLastPasswordChange(chrono::system_clock::from_time_t(sqlite3_column_int64(stmt, 4)));
-
-            sqlite3_finalize(stmt);
-            return true;
-        }
-
-        // Clean up and return false if user not found
-        sqlite3_finalize(stmt);
-        return false;
+        user = move(entry->user);
+        hashedPassword = move(entry->hashedPassword);
+        return true;
     }
 
     // Definition of a method to retrieve a username from an email; takes email and output parameter for username; returns bool indicating success
     bool UserDatabase::getUsernameFromEmail(const string& email, string& username) {
-        // SQL statement to select username based on email
-        string sql = "SELECT username FROM users WHERE email = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
-            return false;
+        optional<UserCache::Entry> entry = cache.findByEmail(email);
+        if (!entry) {
+            entry = loadUser("SELECT username, passwordHash, email, user_role, last_password_change FROM users WHERE email = ?;", email);
         }
-
-        // Bind email parameter
-        sqlite3_bind_text(stmt, 1, email.c_str(), -1, SQLITE_STATIC);
-
-        // Execute and retrieve username if found
-        bool found = false;
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            found = true;
+        if (!entry) {
+            return false;
         }
-
-        // Clean up and return result
-        sqlite3_finalize(stmt);
-        return found;
+        username = entry->user.getUsername();
+        return true;
     }
 
     // Definition of a method to retrieve a user's email from the database; takes username and output parameter for email; returns bool indicating success
     bool UserDatabase::getUserEmailFromDatabase(const string& username, string& email) {
-        // SQL statement to select email based on username
-        string sql = "SELECT email FROM users WHERE username = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        optional<UserCache::Entry> entry = findUser(username);
+        if (!entry || entry->user.getEmail().empty()) {
             return false;
         }
-
-        // Bind username parameter
-        sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
-
-        // Execute and retrieve email if found
-        bool success = false;
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            // Safely convert and store email if it exists
-            const char* emailChar = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-            if (emailChar) {
-                email = string(emailChar);
-                success = true;
-            }
-        }
-
-        // Clean up and return result
-        sqlite3_finalize(stmt);
-        return success;
+        email = entry->user.getEmail();
+        return true;
     }
 
     // Definition of a method to update a user's information in the database; takes User object and hashedPassword; returns bool indicating success
     bool UserDatabase::updateUserInDatabase(const User& user, const string& hashedPassword) {
         // Determine SQL statement based on whether password needs updating
-        string sql;
-        sqlite3_stmt* stmt;
-
+        const char* sql;
         if (hashedPassword.empty()) {
             sql = "UPDATE users SET user_role = ?, last_password_change = ?, email = ? WHERE username = ?;";
         } else {
             sql = "UPDATE users SET user_role = ?, last_password_change = ?, email = ?, passwordHash = ? WHERE username = ?;";
         }
 
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare(sql);
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
         // Bind parameters to SQL statement
+        string username = user.getUsername();
+        string email = user.getEmail();
         sqlite3_bind_int(stmt, 1, static_cast<int>(user.getRole()));
         sqlite3_bind_int64(stmt, 2, chrono::system_clock::to_time_t(user.getLastPasswordChange()));
-        sqlite3_bind_text(stmt, 3, user.getEmail().c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, email.c_str(), -1, SQLITE_STATIC);
 
         if (!hashedPassword.empty()) {
             sqlite3_bind_text(stmt, 4, hashedPassword.c_str(), -1, SQLITE_STATIC);
-            sqlite3_bind_text(stmt, 5, user.getUsername().c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, username.c_str(), -1, SQLITE_STATIC);
         } else {
-            sqlite3_bind_text(stmt, 4, user.getUsername().c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 4, username.c_str(), -1, SQLITE_STATIC);
         }
 
-        // Execute SQL statement and finalize
+        // Execute SQL statement
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
+
+        // Drop the old record and whichever cached user the new email belonged to
+        cache.invalidate(username);
+        cache.invalidateEmail(email);
 
         // Return success status
         return result == SQLITE_DONE;
@@ -271,13 +235,10 @@ namespace TaxReturnSystem {
 
     // Definition of a method to update a user's password; takes username and newPasswordHash as parameters; returns bool indicating success
     bool UserDatabase::updateUserPasswordInDatabase(const string& username, const string& newPasswordHash) {
-        // SQL statement to update password and last change time
-        string sql = "UPDATE users SET hashed_password = ?, last_password_change = ? WHERE username = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("UPDATE users SET passwordHash = ?, last_password_change = ? WHERE username = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
@@ -287,9 +248,10 @@ namespace TaxReturnSystem {
         sqlite3_bind_int64(stmt, 2, chrono::system_clock::to_time_t(now));
         sqlite3_bind_text(stmt, 3, username.c_str(), -1, SQLITE_STATIC);
 
-        // Execute SQL statement and finalize
+        // Execute SQL statement
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
+        cache.invalidate(username);
 
         // Return success status
         return result == SQLITE_DONE;
@@ -297,13 +259,10 @@ namespace TaxReturnSystem {
 
     // Definition of a method to update a user's email; takes username and newEmail as parameters; returns bool indicating success
     bool UserDatabase::updateUserEmailInDatabase(const string& username, const string& newEmail) {
-        // SQL statement to update email
-        string sql = "UPDATE users SET email = ? WHERE username = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("UPDATE users SET email = ? WHERE username = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
@@ -311,9 +270,11 @@ namespace TaxReturnSystem {
         sqlite3_bind_text(stmt, 1, newEmail.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_STATIC);
 
-        // Execute SQL statement and finalize
+        // Execute SQL statement
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
+        cache.invalidate(username);
+        cache.invalidateEmail(newEmail);
 
         // Return success status
         return result == SQLITE_DONE;
@@ -321,13 +282,10 @@ namespace TaxReturnSystem {
 
     // Definition of a method to update a user's role; takes username and newRole as parameters; returns bool indicating success
     bool UserDatabase::updateUserRoleInDatabase(const string& username, UserRole newRole) {
-        // SQL statement to update user role
-        string sql = "UPDATE users SET user_role = ? WHERE username = ?;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        WriteLease writer = pool.writer();
+        CachedStatement statement = writer->prepare("UPDATE users SET user_role = ? WHERE username = ?;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return false;
         }
 
@@ -335,9 +293,10 @@ namespace TaxReturnSystem {
         sqlite3_bind_int(stmt, 1, static_cast<int>(newRole));
         sqlite3_bind_text(stmt, 2, username.c_str(), -1, SQLITE_STATIC);
 
-        // Execute SQL statement and finalize
+        // Execute SQL statement
         int result = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        statement.reset();
+        cache.invalidate(username);
 
         // Return success status
         return result == SQLITE_DONE;
@@ -345,13 +304,10 @@ namespace TaxReturnSystem {
 
     // Definition of a method to list all users in the database; no parameters; no return value
     void UserDatabase::listAllUsers() const {
-        // SQL statement to select all user information
-        const char* sql = "SELECT username, email, user_role FROM users;";
-        sqlite3_stmt* stmt;
-
-        // Prepare SQL statement
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-            cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << endl;
+        ReadLease reader = pool.reader();
+        CachedStatement statement = reader->prepare("SELECT username, email, user_role FROM users;");
+        sqlite3_stmt* stmt = statement.get();
+        if (!stmt) {
             return;
         }
 
@@ -368,9 +324,6 @@ namespace TaxReturnSystem {
 
             cout << username << " | " << email << " | " << role << endl;
         }
-
-        // Clean up prepared statement
-        sqlite3_finalize(stmt);
     }
 
-} // namespace TaxReturnSystem
\ No newline at end of file
+} // namespace TaxReturnSystem
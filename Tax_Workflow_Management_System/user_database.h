@@ -4,23 +4,28 @@
 #include <sqlite3.h>
 #include <iostream>
 #include <chrono>
+#include <optional>
 #include "user.h"
+#include "user_cache.h"
+#include "sqlite_pool.h"
 
 namespace TaxReturnSystem {
 
+    // Users table. Lookups are served from a bounded in-memory cache and fall back to a reader
+    // connection; updates run on the writer connection and invalidate the cached user.
     class UserDatabase {
     private:
         string dbPath; // Path to the database
-        sqlite3* db; // Pointer to the SQLite database connection
+        mutable SqlitePool pool; // Writer and reader connections with cached statements
+        UserCache cache; // Recently used users, by username and by email
 
-        // Methods for database connection management
-        bool openDatabase(); // Opens the database connection
-        void closeDatabase(); // Closes the database connection
+        optional<UserCache::Entry> loadUser(const char* sql, const string& key); // Read one user into the cache; sql selects by one bound key
+        optional<UserCache::Entry> findUser(const string& username); // Cached user, loading it on a miss
 
     public:
         // Constructor and destructor
-        UserDatabase(const string& path); // Constructor: Initializes the database connection
-        ~UserDatabase(); // Destructor: Closes the database connection
+        UserDatabase(const string& path); // Constructor: Opens the connection pool
+        ~UserDatabase(); // Destructor: Closes the connections
 
         void createTablesIfNotExist(); // Creates necessary tables if they don't exist
 